@@ -1,4 +1,4 @@
-// mc_hash_rng.h - v0.5 - public domain, initial release 2021-09-15 - Miguel A. Friginal
+// mc_hash_rng.h - v0.15 - public domain, initial release 2021-09-15 - Miguel A. Friginal
 //
 // A hash-based pseudo-random number generator.
 //
@@ -43,6 +43,18 @@
 // History:
 //
 //      0.5 (2021-09-15) First released version.
+//      0.6 (2026-10-16) Added mergeable reservoir sampling by hash priority.
+//      0.7 (2026-10-16) Added exponential, normal, gamma, beta and Dirichlet distributions.
+//      0.8 (2026-10-16) Added binomial, Poisson, geometric and negative binomial
+//                       distributions.
+//      0.9 (2026-10-16) Added points on circles, discs, spheres and balls, and rotations.
+//      0.10 (2026-10-16) Added sampler for user-defined piecewise-linear distributions.
+//      0.11 (2026-10-16) Added batch integer hashes. The implementation can be included
+//                        more than once (e.g. by other libraries depending on this one).
+//      0.12 (2026-10-17) Added stochastic rounding and dithering of float buffers.
+//      0.13 (2026-10-17) Added random-access Brownian bridges.
+//      0.14 (2026-10-17) Added hierarchical counts and masses for quadtrees and octrees.
+//      0.15 (2026-10-17) Added random-access Poisson event timelines.
 //
 //
 // Compiling:
@@ -57,6 +69,9 @@
 //   and #define MCHR_USE_STDINT to have integer parameters and return values be
 //   "uint32_t" and "int32_t" instead of "unsigned int" and "int".
 //
+//   The implementation uses functions from <math.h>, so you may need to link with the
+//   math library (e.g. "-lm").
+//
 //
 // License:
 //
@@ -101,6 +116,61 @@
 //
 //          if (mchr_get_1d_chance(data1, seed, 0.5)) // 50% probability
 //
+//   Reservoirs select a random subset of k items out of a stream, using the hash of each
+//   item as its priority. Reservoirs filled by different threads can be merged, giving
+//   the same selection as a single reservoir receiving all items:
+//
+//          mchr_reservoir_entry_t entries[16];
+//          mchr_reservoir_t reservoir;
+//          mchr_reservoir_init(&reservoir, entries, 16, seed);
+//          mchr_reservoir_add_1d_range(&reservoir, 0, 50000);
+//          mchr_reservoir_merge(&reservoir, &reservoir_from_other_thread);
+//          mchr_reservoir_sort(&reservoir);
+//
+//   Samples from common distributions are available with the same data and seed
+//   parameters, plus batch versions filling arrays for consecutive positions:
+//
+//          float wait_time = mchr_get_2d_exponential(entity_id, tick, seed, 0.25f);
+//          float yield = mchr_get_1d_gamma(field_id, seed, 2.0f, 10.0f);
+//          mchr_get_1d_gamma_batch(0, field_count, seed, 2.0f, 10.0f, yields);
+//          unsigned int successes = mchr_get_2d_binomial(crowd_id, tick, seed, 5000, 0.3f);
+//          mchr_get_1d_on_sphere_batch(first_particle, count, seed, dir_x, dir_y, dir_z);
+//
+//   Custom distributions authored as curves can be sampled through their CDF:
+//
+//          float cdf[POINTS]; unsigned int guide[POINTS];
+//          mchr_cdf_sampler_t sampler;
+//          mchr_cdf_from_pdf(curve_x, curve_density, POINTS, cdf);
+//          mchr_cdf_sampler_init(&sampler, curve_x, cdf, POINTS, guide, POINTS);
+//          float loot_value = mchr_get_1d_cdf_sample(chest_id, seed, &sampler);
+//
+//   Float buffers can be quantized to integers with stochastic rounding or dithering,
+//   where the rounding of element i depends only on its position and the seed:
+//
+//          // heights in [min_height, max_height] to the full range of 16 bits
+//          float scale = 65535.0f / (max_height - min_height);
+//          mchr_quantize_1d_u16_batch(heights, count, scale, -min_height * scale,
+//                                     MCHR_ROUNDING_STOCHASTIC, 0, seed, heights_u16);
+//
+//   Random walks between two fixed ends (e.g. the sideways offset of a river between two
+//   towns) can be evaluated at any point, or over any range, without walking from the
+//   start:
+//
+//          float offset = mchr_get_brownian_bridge(step, STEPS, river_id, 0.0f, 0.0f, 0.5f);
+//
+//   Quadtree and octree nodes get counts (or masses) that always add up to the count of
+//   their parent, so every level of detail shows the same features:
+//
+//          unsigned int trees_in_node = mchr_get_quadtree_count(lod, node_x, node_y, seed, 5000.0f);
+//          mchr_get_quadtree_count_batch(lod, tile_x, tile_y, 16, 16, seed, 5000.0f, counts);
+//
+//   Events of a Poisson process can be listed for any time window, and overlapping windows
+//   agree on the events they share:
+//
+//          double times[64];
+//          unsigned int ids[64];
+//          unsigned int count = mchr_get_timeline_events(now, now + frame_time, meteors_per_second, seed, times, ids, 64);
+//
 //
 // More about seeds and data indices/positions:
 //
@@ -148,7 +218,8 @@
 //
 //   Although all functions are pure functions (depending only on their input parameters),
 //   you will need to lock access to the index buffers pointed at by the random length
-//   hash functions like "mchr_get_hash_uint()" or "mchr_get_chance()".
+//   hash functions like "mchr_get_hash_uint()" or "mchr_get_chance()". The same applies to
+//   reservoirs, which should be owned by a single thread and merged afterwards.
 
 #ifndef MCHR_INCLUDE_MC_HASH_RNG_H
 #define MCHR_INCLUDE_MC_HASH_RNG_H
@@ -190,6 +261,16 @@ MCHR_DEF MCHR_UINT mchr_get_2d_hash_uint( MCHR_INT posX, MCHR_INT posY, MCHR_UIN
 MCHR_DEF MCHR_UINT mchr_get_3d_hash_uint( MCHR_INT posX, MCHR_INT posY, MCHR_INT posZ, MCHR_UINT seed );
 MCHR_DEF MCHR_UINT mchr_get_4d_hash_uint( MCHR_INT posX, MCHR_INT posY, MCHR_INT posZ, MCHR_INT posT, MCHR_UINT seed );
 
+// ---------------------------------------------------------------------------------------
+// Batch versions of the integer hashes, writing the hash of each element of the position
+//  arrays into out (identical to calling the functions above for every element). They
+//  have no function calls nor branches inside the loop, so compilers can vectorize them.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF void mchr_get_1d_hash_uint_batch( const MCHR_INT* pos, MCHR_UINT count, MCHR_UINT seed, MCHR_UINT* out );
+MCHR_DEF void mchr_get_2d_hash_uint_batch( const MCHR_INT* posX, const MCHR_INT* posY, MCHR_UINT count, MCHR_UINT seed, MCHR_UINT* out );
+MCHR_DEF void mchr_get_3d_hash_uint_batch( const MCHR_INT* posX, const MCHR_INT* posY, const MCHR_INT* posZ, MCHR_UINT count, MCHR_UINT seed, MCHR_UINT* out );
+MCHR_DEF void mchr_get_4d_hash_uint_batch( const MCHR_INT* posX, const MCHR_INT* posY, const MCHR_INT* posZ, const MCHR_INT* posT, MCHR_UINT count, MCHR_UINT seed, MCHR_UINT* out );
+
 // ---------------------------------------------------------------------------------------
 // A version of `mchr_get_hash_uint()` that returns unbiased unsigned integers in the
 //  left-closed interval (including min but not max) between zero and an upper limit. Used
@@ -245,6 +326,284 @@ MCHR_DEF bool mchr_get_2d_chance( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed,
 MCHR_DEF bool mchr_get_3d_chance( MCHR_INT posX, MCHR_INT posY, MCHR_INT posZ, MCHR_UINT seed, float probability_of_true );
 MCHR_DEF bool mchr_get_4d_chance( MCHR_INT posX, MCHR_INT posY, MCHR_INT posZ, MCHR_INT posT, MCHR_UINT seed, float probability_of_true );
 
+// ---------------------------------------------------------------------------------------
+// Reservoir sampling (random top-k selection) by hash priority. Every item gets a
+//  priority from the hash of its key, and the reservoir keeps the `capacity` items with
+//  the highest priorities seen so far. Since priorities only depend on the key and the
+//  seed, reservoirs filled independently (e.g. one per thread) can be merged, and the
+//  final selection is the same regardless of the number of reservoirs or the order in
+//  which items arrived.
+// Weighted versions use the A-Res algorithm (Efraimidis and Spirakis), selecting each
+//  item with a probability proportional to its weight. Items with a weight of zero or
+//  less are never selected. Don't mix weighted and unweighted additions in the same
+//  reservoir, or reservoirs using different seeds.
+// Each key must be added only once across all the reservoirs that get merged: there is no
+//  search for duplicates, so an item added twice (to one reservoir, or to two of them) can
+//  be kept twice.
+// The entries buffer is owned by the caller, and must hold at least `capacity` entries.
+// ---------------------------------------------------------------------------------------
+typedef struct mchr_reservoir_entry_t {
+    double priority;
+    MCHR_UINT item;
+} mchr_reservoir_entry_t;
+
+typedef struct mchr_reservoir_t {
+    mchr_reservoir_entry_t* entries;
+    MCHR_UINT capacity;
+    MCHR_UINT count;
+    MCHR_UINT seed;
+} mchr_reservoir_t;
+
+MCHR_DEF void mchr_reservoir_init( mchr_reservoir_t* reservoir, mchr_reservoir_entry_t* entries, MCHR_UINT capacity, MCHR_UINT seed );
+MCHR_DEF void mchr_reservoir_add( mchr_reservoir_t* reservoir, const void* index_buffer, size_t len, MCHR_UINT item );
+MCHR_DEF void mchr_reservoir_add_1d( mchr_reservoir_t* reservoir, MCHR_INT pos );
+MCHR_DEF void mchr_reservoir_add_1d_range( mchr_reservoir_t* reservoir, MCHR_INT first_pos, MCHR_UINT count );
+MCHR_DEF void mchr_reservoir_add_weighted( mchr_reservoir_t* reservoir, const void* index_buffer, size_t len, MCHR_UINT item, float weight );
+MCHR_DEF void mchr_reservoir_add_1d_weighted( mchr_reservoir_t* reservoir, MCHR_INT pos, float weight );
+MCHR_DEF void mchr_reservoir_add_1d_range_weighted( mchr_reservoir_t* reservoir, MCHR_INT first_pos, MCHR_UINT count, const float* weights );
+
+// ---------------------------------------------------------------------------------------
+// Add all entries from another reservoir (created with the same seed) into this one. Both
+//  must have received disjoint items, as entries they share end up twice in this one.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF void mchr_reservoir_merge( mchr_reservoir_t* reservoir, const mchr_reservoir_t* other );
+
+// ---------------------------------------------------------------------------------------
+// Sort the entries from lowest to highest priority (ties broken by item), which gives a
+//  deterministic output order. The reservoir can keep receiving items after sorting.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF void mchr_reservoir_sort( mchr_reservoir_t* reservoir );
+
+// ---------------------------------------------------------------------------------------
+// Continuous distributions. Like every other function these are random-access: the
+//  result only depends on the data and the seed. When a sample needs several uniform
+//  values, the n-th one is `mchr_get_1d_hash_uint(n, key)`, where key is the hash of the
+//  data, so samples for different positions never share random bits.
+// Exponential returns waiting times for events happening at `rate` per time unit. Gamma
+//  uses the Marsaglia-Tsang method, with the usual boost for shapes under 1. Beta and
+//  Dirichlet are computed from gamma samples. Dirichlet writes `count` ratios that add up
+//  to 1 into out_ratios.
+// The batch versions write the results for positions first_pos to first_pos + count - 1
+//  (identical to calling the 1d versions). They work on chunks of samples, hashing all
+//  of them before transforming them in separate loops, and only go through the single
+//  sample code for gamma attempts that fail the quick squeeze test (a few percent). The
+//  Dirichlet batch output is stored by component (SoA): ratio j of the i-th sample is
+//  out_ratios[j * count + i].
+// ---------------------------------------------------------------------------------------
+MCHR_DEF float mchr_get_exponential( const void* index_buffer, size_t len, MCHR_UINT seed, float rate );
+MCHR_DEF float mchr_get_1d_exponential( MCHR_INT pos, MCHR_UINT seed, float rate );
+MCHR_DEF float mchr_get_2d_exponential( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float rate );
+MCHR_DEF void  mchr_get_1d_exponential_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float rate, float* out );
+
+MCHR_DEF float mchr_get_normal( const void* index_buffer, size_t len, MCHR_UINT seed, float mean, float std_dev );
+MCHR_DEF float mchr_get_1d_normal( MCHR_INT pos, MCHR_UINT seed, float mean, float std_dev );
+MCHR_DEF float mchr_get_2d_normal( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float mean, float std_dev );
+MCHR_DEF void  mchr_get_1d_normal_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float mean, float std_dev, float* out );
+
+MCHR_DEF float mchr_get_gamma( const void* index_buffer, size_t len, MCHR_UINT seed, float shape, float scale );
+MCHR_DEF float mchr_get_1d_gamma( MCHR_INT pos, MCHR_UINT seed, float shape, float scale );
+MCHR_DEF float mchr_get_2d_gamma( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float shape, float scale );
+MCHR_DEF void  mchr_get_1d_gamma_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float shape, float scale, float* out );
+
+MCHR_DEF float mchr_get_beta( const void* index_buffer, size_t len, MCHR_UINT seed, float alpha, float beta );
+MCHR_DEF float mchr_get_1d_beta( MCHR_INT pos, MCHR_UINT seed, float alpha, float beta );
+MCHR_DEF float mchr_get_2d_beta( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float alpha, float beta );
+MCHR_DEF void  mchr_get_1d_beta_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float alpha, float beta, float* out );
+
+MCHR_DEF void mchr_get_dirichlet( const void* index_buffer, size_t len, MCHR_UINT seed, const float* alphas, MCHR_UINT count, float* out_ratios );
+MCHR_DEF void mchr_get_1d_dirichlet( MCHR_INT pos, MCHR_UINT seed, const float* alphas, MCHR_UINT count, float* out_ratios );
+MCHR_DEF void mchr_get_2d_dirichlet( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, const float* alphas, MCHR_UINT count, float* out_ratios );
+MCHR_DEF void mchr_get_1d_dirichlet_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, const float* alphas, MCHR_UINT alphas_count, float* out_ratios );
+
+// ---------------------------------------------------------------------------------------
+// Discrete distributions, using the same random-access scheme as the continuous ones.
+//  All of them run in constant expected time, independent of the number of trials.
+// Binomial returns how many of `trials` independent attempts succeed with probability
+//  `probability`, using inversion when trials * probability is small and Hormann's BTRS
+//  transformed rejection otherwise. Poisson uses inversion for small means and PTRS for
+//  larger ones. Geometric returns the number of failures before the first success, and
+//  negative binomial the number of failures before `successes` successes (which doesn't
+//  need to be an integer), sampled as a gamma-Poisson mixture.
+// Results too large for an MCHR_UINT saturate to 0xFFFFFFFF, which can happen with huge
+//  means for Poisson and negative binomial (whose gamma-distributed mean is unbounded),
+//  and tiny probabilities for geometric.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF MCHR_UINT mchr_get_binomial( const void* index_buffer, size_t len, MCHR_UINT seed, MCHR_UINT trials, float probability );
+MCHR_DEF MCHR_UINT mchr_get_1d_binomial( MCHR_INT pos, MCHR_UINT seed, MCHR_UINT trials, float probability );
+MCHR_DEF MCHR_UINT mchr_get_2d_binomial( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, MCHR_UINT trials, float probability );
+MCHR_DEF void      mchr_get_1d_binomial_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, MCHR_UINT trials, float probability, MCHR_UINT* out );
+
+MCHR_DEF MCHR_UINT mchr_get_poisson( const void* index_buffer, size_t len, MCHR_UINT seed, float mean );
+MCHR_DEF MCHR_UINT mchr_get_1d_poisson( MCHR_INT pos, MCHR_UINT seed, float mean );
+MCHR_DEF MCHR_UINT mchr_get_2d_poisson( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float mean );
+MCHR_DEF void      mchr_get_1d_poisson_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float mean, MCHR_UINT* out );
+
+MCHR_DEF MCHR_UINT mchr_get_geometric( const void* index_buffer, size_t len, MCHR_UINT seed, float probability );
+MCHR_DEF MCHR_UINT mchr_get_1d_geometric( MCHR_INT pos, MCHR_UINT seed, float probability );
+MCHR_DEF MCHR_UINT mchr_get_2d_geometric( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float probability );
+MCHR_DEF void      mchr_get_1d_geometric_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float probability, MCHR_UINT* out );
+
+MCHR_DEF MCHR_UINT mchr_get_negative_binomial( const void* index_buffer, size_t len, MCHR_UINT seed, float successes, float probability );
+MCHR_DEF MCHR_UINT mchr_get_1d_negative_binomial( MCHR_INT pos, MCHR_UINT seed, float successes, float probability );
+MCHR_DEF MCHR_UINT mchr_get_2d_negative_binomial( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float successes, float probability );
+MCHR_DEF void      mchr_get_1d_negative_binomial_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float successes, float probability, MCHR_UINT* out );
+
+// ---------------------------------------------------------------------------------------
+// Directional sampling: uniformly distributed points on the unit circle, inside the unit
+//  disc, on the unit sphere, inside the unit ball, and uniform random rotations returned
+//  as unit quaternions (x, y, z, w). Each sample uses a single hash when 16 bits per value
+//  are enough (circle, disc, sphere), and a second hash, `mchr_get_1d_hash_uint(1, key)`,
+//  otherwise. Sines and cosines come from a polynomial approximation instead of the C
+//  library, so the batch versions have no function calls and can be vectorized.
+// The batch versions write the results for positions first_pos to first_pos + count - 1
+//  into separate arrays per coordinate (SoA).
+// ---------------------------------------------------------------------------------------
+MCHR_DEF void mchr_get_on_circle( const void* index_buffer, size_t len, MCHR_UINT seed, float* out_x, float* out_y );
+MCHR_DEF void mchr_get_1d_on_circle( MCHR_INT pos, MCHR_UINT seed, float* out_x, float* out_y );
+MCHR_DEF void mchr_get_2d_on_circle( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float* out_x, float* out_y );
+MCHR_DEF void mchr_get_1d_on_circle_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float* out_x, float* out_y );
+
+MCHR_DEF void mchr_get_in_disc( const void* index_buffer, size_t len, MCHR_UINT seed, float* out_x, float* out_y );
+MCHR_DEF void mchr_get_1d_in_disc( MCHR_INT pos, MCHR_UINT seed, float* out_x, float* out_y );
+MCHR_DEF void mchr_get_2d_in_disc( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float* out_x, float* out_y );
+MCHR_DEF void mchr_get_1d_in_disc_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float* out_x, float* out_y );
+
+MCHR_DEF void mchr_get_on_sphere( const void* index_buffer, size_t len, MCHR_UINT seed, float* out_x, float* out_y, float* out_z );
+MCHR_DEF void mchr_get_1d_on_sphere( MCHR_INT pos, MCHR_UINT seed, float* out_x, float* out_y, float* out_z );
+MCHR_DEF void mchr_get_2d_on_sphere( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float* out_x, float* out_y, float* out_z );
+MCHR_DEF void mchr_get_1d_on_sphere_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float* out_x, float* out_y, float* out_z );
+
+MCHR_DEF void mchr_get_in_ball( const void* index_buffer, size_t len, MCHR_UINT seed, float* out_x, float* out_y, float* out_z );
+MCHR_DEF void mchr_get_1d_in_ball( MCHR_INT pos, MCHR_UINT seed, float* out_x, float* out_y, float* out_z );
+MCHR_DEF void mchr_get_2d_in_ball( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float* out_x, float* out_y, float* out_z );
+MCHR_DEF void mchr_get_1d_in_ball_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float* out_x, float* out_y, float* out_z );
+
+MCHR_DEF void mchr_get_rotation( const void* index_buffer, size_t len, MCHR_UINT seed, float* out_x, float* out_y, float* out_z, float* out_w );
+MCHR_DEF void mchr_get_1d_rotation( MCHR_INT pos, MCHR_UINT seed, float* out_x, float* out_y, float* out_z, float* out_w );
+MCHR_DEF void mchr_get_2d_rotation( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float* out_x, float* out_y, float* out_z, float* out_w );
+MCHR_DEF void mchr_get_1d_rotation_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float* out_x, float* out_y, float* out_z, float* out_w );
+
+// ---------------------------------------------------------------------------------------
+// Sampler for user-defined distributions, given as a piecewise-linear cumulative
+//  distribution function: `count` (at least 2) increasing values, and the non-decreasing
+//  cumulative weight at each of them (it doesn't need to be normalized). Flat segments
+//  of the CDF are never sampled. Use `mchr_cdf_from_pdf()` to integrate a curve of
+//  probability densities into a CDF.
+// A guide table finds the CDF segment for a uniform value in constant expected time;
+//  a table with as many entries as CDF points is usually enough. The sampler references
+//  the value, CDF and guide arrays, which are owned by the caller and must outlive it.
+// `mchr_cdf_sampler_eval()` maps a value from 0 to 1 through the inverse CDF, and the
+//  other functions do it for random values, with the same parameters as everywhere else.
+// ---------------------------------------------------------------------------------------
+typedef struct mchr_cdf_sampler_t {
+    const float* values;
+    const float* cdf;
+    MCHR_UINT count;
+    MCHR_UINT* guide;
+    MCHR_UINT guide_size;
+} mchr_cdf_sampler_t;
+
+MCHR_DEF void  mchr_cdf_from_pdf( const float* values, const float* pdf, MCHR_UINT count, float* out_cdf );
+MCHR_DEF void  mchr_cdf_sampler_init( mchr_cdf_sampler_t* sampler, const float* values, const float* cdf, MCHR_UINT count, MCHR_UINT* guide, MCHR_UINT guide_size );
+MCHR_DEF float mchr_cdf_sampler_eval( const mchr_cdf_sampler_t* sampler, float zero_to_one );
+
+MCHR_DEF float mchr_get_cdf_sample( const void* index_buffer, size_t len, MCHR_UINT seed, const mchr_cdf_sampler_t* sampler );
+MCHR_DEF float mchr_get_1d_cdf_sample( MCHR_INT pos, MCHR_UINT seed, const mchr_cdf_sampler_t* sampler );
+MCHR_DEF float mchr_get_2d_cdf_sample( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, const mchr_cdf_sampler_t* sampler );
+MCHR_DEF void  mchr_get_1d_cdf_sample_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, const mchr_cdf_sampler_t* sampler, float* out );
+
+// ---------------------------------------------------------------------------------------
+// Quantization of floats to integers: `value * scale + offset` rounded as selected, and
+//  clamped to the range of the result (NaNs become its minimum, and 32 bit results stop
+//  at 2147483520, the largest float below 2^31). The rounding of each value depends on
+//  its position and the seed:
+//      MCHR_ROUNDING_NEAREST               to the nearest integer, halves up
+//      MCHR_ROUNDING_STOCHASTIC            up with a probability equal to the fraction,
+//                                          taken from `mchr_get_1d_hash_uint(pos, seed)`
+//                                          (or the 2d hash), so the mean error is zero
+//      MCHR_ROUNDING_TRIANGULAR_DITHER     to the nearest integer after adding hashed
+//                                          noise with a triangular distribution in
+//                                          (-1, 1), making the error independent of the
+//                                          signal (e.g. for audio)
+//      MCHR_ROUNDING_ORDERED_DITHER        up when the fraction is above a threshold from
+//                                          a 256-entry ordered pattern (the bit-reversed
+//                                          position in 1d, a 16x16 Bayer matrix in 2d)
+// The 1d batch versions quantize `count` values at positions first_pos onwards, and the
+//  2d versions quantize a `width` x `height` row-major image with its first value at
+//  (first_x, first_y). Batch results are bit-exact with the single value functions.
+// ---------------------------------------------------------------------------------------
+typedef enum mchr_rounding_t {
+    MCHR_ROUNDING_NEAREST,
+    MCHR_ROUNDING_STOCHASTIC,
+    MCHR_ROUNDING_TRIANGULAR_DITHER,
+    MCHR_ROUNDING_ORDERED_DITHER
+} mchr_rounding_t;
+
+MCHR_DEF MCHR_INT mchr_quantize_1d( float value, float scale, float offset, mchr_rounding_t rounding, MCHR_INT pos, MCHR_UINT seed, MCHR_INT min, MCHR_INT max );
+MCHR_DEF MCHR_INT mchr_quantize_2d( float value, float scale, float offset, mchr_rounding_t rounding, MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, MCHR_INT min, MCHR_INT max );
+
+MCHR_DEF void mchr_quantize_1d_u8_batch( const float* values, MCHR_UINT count, float scale, float offset, mchr_rounding_t rounding, MCHR_INT first_pos, MCHR_UINT seed, unsigned char* out );
+MCHR_DEF void mchr_quantize_1d_u16_batch( const float* values, MCHR_UINT count, float scale, float offset, mchr_rounding_t rounding, MCHR_INT first_pos, MCHR_UINT seed, unsigned short* out );
+MCHR_DEF void mchr_quantize_1d_i16_batch( const float* values, MCHR_UINT count, float scale, float offset, mchr_rounding_t rounding, MCHR_INT first_pos, MCHR_UINT seed, short* out );
+MCHR_DEF void mchr_quantize_1d_i32_batch( const float* values, MCHR_UINT count, float scale, float offset, mchr_rounding_t rounding, MCHR_INT first_pos, MCHR_UINT seed, MCHR_INT* out );
+
+MCHR_DEF void mchr_quantize_2d_u8_batch( const float* values, MCHR_UINT width, MCHR_UINT height, float scale, float offset, mchr_rounding_t rounding, MCHR_INT first_x, MCHR_INT first_y, MCHR_UINT seed, unsigned char* out );
+MCHR_DEF void mchr_quantize_2d_u16_batch( const float* values, MCHR_UINT width, MCHR_UINT height, float scale, float offset, mchr_rounding_t rounding, MCHR_INT first_x, MCHR_INT first_y, MCHR_UINT seed, unsigned short* out );
+MCHR_DEF void mchr_quantize_2d_i16_batch( const float* values, MCHR_UINT width, MCHR_UINT height, float scale, float offset, mchr_rounding_t rounding, MCHR_INT first_x, MCHR_INT first_y, MCHR_UINT seed, short* out );
+MCHR_DEF void mchr_quantize_2d_i32_batch( const float* values, MCHR_UINT width, MCHR_UINT height, float scale, float offset, mchr_rounding_t rounding, MCHR_INT first_x, MCHR_INT first_y, MCHR_UINT seed, MCHR_INT* out );
+
+// ---------------------------------------------------------------------------------------
+// Brownian bridge: value at `index` (0 to `length`) of a random walk with normal steps
+//  of standard deviation `std_dev`, that starts at `start` and ends at `end`. It's built
+//  by recursive midpoint displacement: the value at the middle of an interval is the
+//  interpolation of its ends plus a normal offset, keyed by the middle index and the
+//  seed, with the variance a Brownian motion would have there. A single value takes
+//  O(log(length)), and the batch version fills `count` values from `first_index` in
+//  O(count + log(length)), giving the same values. For a walk with a free end, pass an
+//  end drawn from a normal distribution with a deviation of std_dev * sqrt(length).
+// ---------------------------------------------------------------------------------------
+MCHR_DEF float mchr_get_brownian_bridge( MCHR_UINT index, MCHR_UINT length, MCHR_UINT seed, float start, float end, float std_dev );
+MCHR_DEF void  mchr_get_brownian_bridge_batch( MCHR_UINT first_index, MCHR_UINT count, MCHR_UINT length, MCHR_UINT seed, float start, float end, float std_dev, float* out );
+
+// ---------------------------------------------------------------------------------------
+// Hierarchical values of quadtree and octree nodes, consistent across levels. Level 0
+//  nodes are the roots (an infinite grid of them), and the children of node (x, y[, z])
+//  of a level are nodes (2x + i, 2y + j[, 2z + k]) of the next one, with i, j, k 0 or 1.
+// Counts: roots hold a Poisson-distributed count with mean `root_mean`, and each node's
+//  count is split among its children with hashed binomial draws (halving along x, then
+//  y, then z), so children add up exactly to their parent, and the counts of a level
+//  are Poisson-distributed with mean root_mean / 4^level (8^level in octrees).
+// Masses: roots hold `root_mass`, and every split gives a fraction of 0.5 +/- 0.5 *
+//  `roughness` to one side (uniformly distributed) and the rest to the other, so
+//  children add up to their parent (up to float rounding); roughness 0 splits evenly,
+//  and 1 gives the most clustered masses.
+// A single node takes O(level) time. Batch versions fill the nodes of a level in a
+//  `width` x `height` [x `depth`] box starting at (first_x, first_y[, first_z]), in
+//  row-major order, visiting each of their ancestors once; they give the same values.
+//  Levels go up to 31.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF MCHR_UINT mchr_get_quadtree_count( MCHR_UINT level, MCHR_INT x, MCHR_INT y, MCHR_UINT seed, float root_mean );
+MCHR_DEF float     mchr_get_quadtree_mass( MCHR_UINT level, MCHR_INT x, MCHR_INT y, MCHR_UINT seed, float root_mass, float roughness );
+MCHR_DEF void      mchr_get_quadtree_count_batch( MCHR_UINT level, MCHR_INT first_x, MCHR_INT first_y, MCHR_UINT width, MCHR_UINT height, MCHR_UINT seed, float root_mean, MCHR_UINT* out );
+MCHR_DEF void      mchr_get_quadtree_mass_batch( MCHR_UINT level, MCHR_INT first_x, MCHR_INT first_y, MCHR_UINT width, MCHR_UINT height, MCHR_UINT seed, float root_mass, float roughness, float* out );
+
+MCHR_DEF MCHR_UINT mchr_get_octree_count( MCHR_UINT level, MCHR_INT x, MCHR_INT y, MCHR_INT z, MCHR_UINT seed, float root_mean );
+MCHR_DEF float     mchr_get_octree_mass( MCHR_UINT level, MCHR_INT x, MCHR_INT y, MCHR_INT z, MCHR_UINT seed, float root_mass, float roughness );
+MCHR_DEF void      mchr_get_octree_count_batch( MCHR_UINT level, MCHR_INT first_x, MCHR_INT first_y, MCHR_INT first_z, MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT seed, float root_mean, MCHR_UINT* out );
+MCHR_DEF void      mchr_get_octree_mass_batch( MCHR_UINT level, MCHR_INT first_x, MCHR_INT first_y, MCHR_INT first_z, MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT seed, float root_mass, float roughness, float* out );
+
+// ---------------------------------------------------------------------------------------
+// Timelines of a Poisson process with `rate` events per time unit: the events in the
+//  window [t0, t1), sorted by time. Time is split in buckets of (4 / rate) time units,
+//  each holding a hashed, Poisson-distributed number of events, so any window takes
+//  O(events) time, and windows that overlap return the same events where they overlap.
+// Writes up to `capacity` event times, and ids stable per event (the same in every
+//  query, to key further randomness), if `out_ids` is not NULL. Ids are 32-bit hashes,
+//  so two events can share one. Returns the number of events in the window, which can be
+//  larger than `capacity` (use a capacity of 0 to only count events).
+// ---------------------------------------------------------------------------------------
+MCHR_DEF MCHR_UINT mchr_get_timeline_events( double t0, double t1, float rate, MCHR_UINT seed, double* out_times, MCHR_UINT* out_ids, MCHR_UINT capacity );
+
 #ifdef __cplusplus
 }
 #endif
@@ -253,11 +612,14 @@ MCHR_DEF bool mchr_get_4d_chance( MCHR_INT posX, MCHR_INT posY, MCHR_INT posZ, M
 #endif // MCHR_INCLUDE_MC_HASH_RNG_H
 
 
-#ifdef MCHR_IMPLEMENTATION
+#if defined(MCHR_IMPLEMENTATION) && !defined(MCHR_IMPLEMENTATION_INCLUDED)
+#define MCHR_IMPLEMENTATION_INCLUDED
 
 // std includes here
 #include <limits.h>
 #include <assert.h>
+#include <math.h>
+#include <string.h>
 
 #if defined(_MSC_VER) && !defined(__clang__)
 
@@ -288,6 +650,52 @@ static const MCHR_UINT MCHR_BIT_NOISE1 = 0x68E31DA4U;   // 0b0110 1000 1110 0011
 static const MCHR_UINT MCHR_BIT_NOISE2 = 0xB5297A4DU;   // 0b1011 0101 0010 1001 0111 1010 0100 1101
 static const MCHR_UINT MCHR_BIT_NOISE3 = 0x1B56C4E9U;   // 0b0001 1011 0101 0110 1100 0100 1110 1001
 
+// ---------------------------------------------------------------------------------------
+// Private function with the final mixing step of the hash, shared by the generic
+//  implementation below and by the unrolled fixed-size versions used in batch loops.
+// ---------------------------------------------------------------------------------------
+static MCHR_UINT mchr_priv_hash_finalize(MCHR_UINT num, MCHR_UINT seed) {
+    num *= MCHR_BIT_NOISE1;
+    num += seed;
+    num ^= (num >> 8);
+    num += MCHR_BIT_NOISE2;
+    num ^= (num << 8);
+    num *= MCHR_BIT_NOISE3;
+    num ^= (num >> 8);
+
+    return num;
+}
+
+// ---------------------------------------------------------------------------------------
+// Private unrolled versions of `mchr_get_hash_uint()` for 1 to 4 integers, returning
+//  identical values. Having no loop nor memory access, they can be inlined and vectorized
+//  inside batch loops.
+// ---------------------------------------------------------------------------------------
+static MCHR_UINT mchr_priv_hash_1d(MCHR_INT pos, MCHR_UINT seed) {
+    return mchr_priv_hash_finalize((MCHR_UINT)pos + MCHR_PRIMES[1], seed);
+}
+
+static MCHR_UINT mchr_priv_hash_2d(MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed) {
+    MCHR_UINT num = (MCHR_UINT)posX + MCHR_PRIMES[1]
+                  + (MCHR_UINT)posY * MCHR_PRIMES[1] + MCHR_PRIMES[2];
+    return mchr_priv_hash_finalize(num, seed);
+}
+
+static MCHR_UINT mchr_priv_hash_3d(MCHR_INT posX, MCHR_INT posY, MCHR_INT posZ, MCHR_UINT seed) {
+    MCHR_UINT num = (MCHR_UINT)posX + MCHR_PRIMES[1]
+                  + (MCHR_UINT)posY * MCHR_PRIMES[1] + MCHR_PRIMES[2]
+                  + (MCHR_UINT)posZ * MCHR_PRIMES[2] + MCHR_PRIMES[3];
+    return mchr_priv_hash_finalize(num, seed);
+}
+
+static MCHR_UINT mchr_priv_hash_4d(MCHR_INT posX, MCHR_INT posY, MCHR_INT posZ, MCHR_INT posT, MCHR_UINT seed) {
+    MCHR_UINT num = (MCHR_UINT)posX + MCHR_PRIMES[1]
+                  + (MCHR_UINT)posY * MCHR_PRIMES[1] + MCHR_PRIMES[2]
+                  + (MCHR_UINT)posZ * MCHR_PRIMES[2] + MCHR_PRIMES[3]
+                  + (MCHR_UINT)posT * MCHR_PRIMES[3] + MCHR_PRIMES[4];
+    return mchr_priv_hash_finalize(num, seed);
+}
+
 // ---------------------------------------------------------------------------------------
 // This is the main hash table implementation. Currently using a modified Squirrel3 hash
 //  (by Squirrel Eiserloh, see https://www.youtube.com/watch?v=LWFzPP8ZbdU) that works on
@@ -310,15 +718,7 @@ MCHR_DEF MCHR_UINT mchr_get_hash_uint(const void* index_buffer, size_t len, MCHR
         len -= sizeof(MCHR_UINT);
     }
 
-    num *= MCHR_BIT_NOISE1;
-    num += seed;
-    num ^= (num >> 8);
-    num += MCHR_BIT_NOISE2;
-    num ^= (num << 8);
-    num *= MCHR_BIT_NOISE3;
-    num ^= (num >> 8);
-
-    return num;
+    return mchr_priv_hash_finalize(num, seed);
 }
 
 // ---------------------------------------------------------------------------------------
@@ -394,23 +794,47 @@ static float mchr_priv_uint_to_neg_one_one(MCHR_UINT num) {
 // Unsigned integer result.
 // ---------------------------------------------------------------------------------------
 MCHR_DEF MCHR_UINT mchr_get_1d_hash_uint( MCHR_INT pos, MCHR_UINT seed ) {
-    return mchr_get_hash_uint(&pos, sizeof(MCHR_INT), seed);
+    return mchr_priv_hash_1d(pos, seed);
 }
 
 MCHR_DEF MCHR_UINT mchr_get_2d_hash_uint( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed ) {
-    MCHR_INT array[] = { posX, posY };
-    return mchr_get_hash_uint(array, sizeof(array), seed);
+    return mchr_priv_hash_2d(posX, posY, seed);
 }
 
 MCHR_DEF MCHR_UINT mchr_get_3d_hash_uint( MCHR_INT posX, MCHR_INT posY, MCHR_INT posZ, MCHR_UINT seed ) {
-    MCHR_INT array[] = { posX, posY, posZ };
-    return mchr_get_hash_uint(array, sizeof(array), seed);
+    return mchr_priv_hash_3d(posX, posY, posZ, seed);
 }
 
 
 MCHR_DEF MCHR_UINT mchr_get_4d_hash_uint( MCHR_INT posX, MCHR_INT posY, MCHR_INT posZ, MCHR_INT posT, MCHR_UINT seed ) {
-    MCHR_INT array[] = { posX, posY, posZ, posT };
-    return mchr_get_hash_uint(array, sizeof(array), seed);
+    return mchr_priv_hash_4d(posX, posY, posZ, posT, seed);
+}
+
+// ---------------------------------------------------------------------------------------
+// Batch unsigned integer result.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF void mchr_get_1d_hash_uint_batch( const MCHR_INT* pos, MCHR_UINT count, MCHR_UINT seed, MCHR_UINT* out ) {
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        out[i] = mchr_priv_hash_1d(pos[i], seed);
+    }
+}
+
+MCHR_DEF void mchr_get_2d_hash_uint_batch( const MCHR_INT* posX, const MCHR_INT* posY, MCHR_UINT count, MCHR_UINT seed, MCHR_UINT* out ) {
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        out[i] = mchr_priv_hash_2d(posX[i], posY[i], seed);
+    }
+}
+
+MCHR_DEF void mchr_get_3d_hash_uint_batch( const MCHR_INT* posX, const MCHR_INT* posY, const MCHR_INT* posZ, MCHR_UINT count, MCHR_UINT seed, MCHR_UINT* out ) {
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        out[i] = mchr_priv_hash_3d(posX[i], posY[i], posZ[i], seed);
+    }
+}
+
+MCHR_DEF void mchr_get_4d_hash_uint_batch( const MCHR_INT* posX, const MCHR_INT* posY, const MCHR_INT* posZ, const MCHR_INT* posT, MCHR_UINT count, MCHR_UINT seed, MCHR_UINT* out ) {
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        out[i] = mchr_priv_hash_4d(posX[i], posY[i], posZ[i], posT[i], seed);
+    }
 }
 
 // ---------------------------------------------------------------------------------------
@@ -565,6 +989,1601 @@ MCHR_DEF float mchr_get_4d_hash_neg_one_to_one( MCHR_INT posX, MCHR_INT posY, MC
     return mchr_priv_uint_to_neg_one_one(result);
 }
 
+// ---------------------------------------------------------------------------------------
+// Reservoir sampling. Entries are kept in a binary min-heap, so the weakest selected item
+//  is always at the root and can be compared against (and replaced by) new candidates.
+// An entry is weaker than another if it has a lower priority, or the same priority and a
+//  lower item value, so there is always a single possible selection.
+// ---------------------------------------------------------------------------------------
+static bool mchr_priv_reservoir_entry_less(const mchr_reservoir_entry_t* a, const mchr_reservoir_entry_t* b) {
+    return (a->priority < b->priority) || ((a->priority == b->priority) && (a->item < b->item));
+}
+
+static int mchr_priv_reservoir_entry_compare(const void* a, const void* b) {
+    const mchr_reservoir_entry_t* entry_a = (const mchr_reservoir_entry_t*)a;
+    const mchr_reservoir_entry_t* entry_b = (const mchr_reservoir_entry_t*)b;
+    if (mchr_priv_reservoir_entry_less(entry_a, entry_b))
+        return -1;
+    if (mchr_priv_reservoir_entry_less(entry_b, entry_a))
+        return 1;
+    return 0;
+}
+
+static void mchr_priv_reservoir_push(mchr_reservoir_t* reservoir, double priority, MCHR_UINT item) {
+    mchr_reservoir_entry_t entry = { priority, item };
+    mchr_reservoir_entry_t* heap = reservoir->entries;
+
+    if (reservoir->count < reservoir->capacity) {
+        // sift up from the new leaf
+        MCHR_UINT i = reservoir->count++;
+        while (i > 0) {
+            MCHR_UINT parent = (i - 1) / 2;
+            if (!mchr_priv_reservoir_entry_less(&entry, &heap[parent]))
+                break;
+            heap[i] = heap[parent];
+            i = parent;
+        }
+        heap[i] = entry;
+        return;
+    }
+
+    if (reservoir->capacity == 0 || !mchr_priv_reservoir_entry_less(&heap[0], &entry))
+        return;
+
+    // replace the root and sift down
+    MCHR_UINT i = 0;
+    MCHR_UINT count = reservoir->count;
+    while (1) {
+        MCHR_UINT child = 2 * i + 1;
+        if (child >= count)
+            break;
+        if (child + 1 < count && mchr_priv_reservoir_entry_less(&heap[child + 1], &heap[child]))
+            child += 1;
+        if (!mchr_priv_reservoir_entry_less(&heap[child], &entry))
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = entry;
+}
+
+// ---------------------------------------------------------------------------------------
+// Private function returning the A-Res priority, log(u) / weight, for a hash value. The
+//  hash is mapped to u in the open (0,1) interval so the logarithm is always finite.
+// ---------------------------------------------------------------------------------------
+static double mchr_priv_uint_to_open_unit_double(MCHR_UINT num) {
+    return (num + 0.5) * (1.0 / 4294967296.0);
+}
+
+static double mchr_priv_weighted_priority(MCHR_UINT hash, float weight) {
+    return log(mchr_priv_uint_to_open_unit_double(hash)) / weight;
+}
+
+MCHR_DEF void mchr_reservoir_init( mchr_reservoir_t* reservoir, mchr_reservoir_entry_t* entries, MCHR_UINT capacity, MCHR_UINT seed ) {
+    assert(entries != NULL || capacity == 0);
+    reservoir->entries = entries;
+    reservoir->capacity = capacity;
+    reservoir->count = 0;
+    reservoir->seed = seed;
+}
+
+MCHR_DEF void mchr_reservoir_add( mchr_reservoir_t* reservoir, const void* index_buffer, size_t len, MCHR_UINT item ) {
+    MCHR_UINT hash = mchr_get_hash_uint(index_buffer, len, reservoir->seed);
+    mchr_priv_reservoir_push(reservoir, (double)hash, item);
+}
+
+MCHR_DEF void mchr_reservoir_add_1d( mchr_reservoir_t* reservoir, MCHR_INT pos ) {
+    MCHR_UINT hash = mchr_priv_hash_1d(pos, reservoir->seed);
+    mchr_priv_reservoir_push(reservoir, (double)hash, (MCHR_UINT)pos);
+}
+
+MCHR_DEF void mchr_reservoir_add_1d_range( mchr_reservoir_t* reservoir, MCHR_INT first_pos, MCHR_UINT count ) {
+    MCHR_UINT i = 0;
+
+    // fill the reservoir
+    for (; i < count && reservoir->count < reservoir->capacity; ++i) {
+        mchr_reservoir_add_1d(reservoir, (MCHR_INT)((MCHR_UINT)first_pos + i));
+    }
+
+    // once full, most candidates are rejected by comparing against the root alone
+    for (; i < count && reservoir->capacity > 0; ++i) {
+        MCHR_INT pos = (MCHR_INT)((MCHR_UINT)first_pos + i);
+        double priority = (double)mchr_priv_hash_1d(pos, reservoir->seed);
+        if (priority >= reservoir->entries[0].priority) {
+            mchr_priv_reservoir_push(reservoir, priority, (MCHR_UINT)pos);
+        }
+    }
+}
+
+MCHR_DEF void mchr_reservoir_add_weighted( mchr_reservoir_t* reservoir, const void* index_buffer, size_t len, MCHR_UINT item, float weight ) {
+    if (!(weight > 0.0f))
+        return;
+    MCHR_UINT hash = mchr_get_hash_uint(index_buffer, len, reservoir->seed);
+    mchr_priv_reservoir_push(reservoir, mchr_priv_weighted_priority(hash, weight), item);
+}
+
+MCHR_DEF void mchr_reservoir_add_1d_weighted( mchr_reservoir_t* reservoir, MCHR_INT pos, float weight ) {
+    if (!(weight > 0.0f))
+        return;
+    MCHR_UINT hash = mchr_priv_hash_1d(pos, reservoir->seed);
+    mchr_priv_reservoir_push(reservoir, mchr_priv_weighted_priority(hash, weight), (MCHR_UINT)pos);
+}
+
+MCHR_DEF void mchr_reservoir_add_1d_range_weighted( mchr_reservoir_t* reservoir, MCHR_INT first_pos, MCHR_UINT count, const float* weights ) {
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        mchr_reservoir_add_1d_weighted(reservoir, (MCHR_INT)((MCHR_UINT)first_pos + i), weights[i]);
+    }
+}
+
+MCHR_DEF void mchr_reservoir_merge( mchr_reservoir_t* reservoir, const mchr_reservoir_t* other ) {
+    assert(reservoir->seed == other->seed);
+    for (MCHR_UINT i = 0; i < other->count; ++i) {
+        mchr_priv_reservoir_push(reservoir, other->entries[i].priority, other->entries[i].item);
+    }
+}
+
+MCHR_DEF void mchr_reservoir_sort( mchr_reservoir_t* reservoir ) {
+    // an array sorted in ascending order is also a valid min-heap
+    qsort(reservoir->entries, reservoir->count, sizeof(mchr_reservoir_entry_t), mchr_priv_reservoir_entry_compare);
+}
+
+// ---------------------------------------------------------------------------------------
+// Private function to convert an unsigned integer hash into a float in the open (0,1)
+//  interval, using the 23 high bits, so logarithms and divisions are always finite.
+// ---------------------------------------------------------------------------------------
+static float mchr_priv_uint_to_open_unit(MCHR_UINT num) {
+    return ((num >> 9) + 0.5f) * (1.0f / 8388608.0f);
+}
+
+// ---------------------------------------------------------------------------------------
+// Private function returning the index-th uniform value in (0,1) derived from a key.
+// ---------------------------------------------------------------------------------------
+static float mchr_priv_key_uniform(MCHR_UINT key, MCHR_UINT index) {
+    return mchr_priv_uint_to_open_unit(mchr_priv_hash_1d((MCHR_INT)index, key));
+}
+
+// ---------------------------------------------------------------------------------------
+// Private distribution kernels, all taking the key (hash of data and seed) of a sample.
+// ---------------------------------------------------------------------------------------
+static const float MCHR_TWO_PI = 6.28318530717958647692f;
+
+static float mchr_priv_exponential(MCHR_UINT key, float rate) {
+    assert(rate > 0.0f);
+    return -logf(mchr_priv_key_uniform(key, 0)) / rate;
+}
+
+// Box-Muller transform using the uniforms at index and index + 1.
+static float mchr_priv_standard_normal(MCHR_UINT key, MCHR_UINT index) {
+    float radius = sqrtf(-2.0f * logf(mchr_priv_key_uniform(key, index)));
+    return radius * cosf(MCHR_TWO_PI * mchr_priv_key_uniform(key, index + 1));
+}
+
+// Gamma with scale 1. Each Marsaglia-Tsang attempt consumes three uniforms.
+static float mchr_priv_standard_gamma(MCHR_UINT key, float shape) {
+    assert(shape > 0.0f);
+    if (shape < 1.0f) {
+        float boost = powf(mchr_priv_key_uniform(key, 0), 1.0f / shape);
+        return mchr_priv_standard_gamma(mchr_priv_hash_1d(1, key), shape + 1.0f) * boost;
+    }
+
+    const float d = shape - 1.0f / 3.0f;
+    const float c = 1.0f / sqrtf(9.0f * d);
+    for (MCHR_UINT index = 0; ; index += 3) {
+        float x = mchr_priv_standard_normal(key, index);
+        float v = 1.0f + c * x;
+        if (v <= 0.0f)
+            continue;
+        v = v * v * v;
+        float u = mchr_priv_key_uniform(key, index + 2);
+        float x2 = x * x;
+        if (u < 1.0f - 0.0331f * x2 * x2)
+            return d * v;
+        if (logf(u) < 0.5f * x2 + d * (1.0f - v + logf(v)))
+            return d * v;
+    }
+}
+
+static float mchr_priv_beta(MCHR_UINT key, float alpha, float beta) {
+    float x = mchr_priv_standard_gamma(mchr_priv_hash_1d(0, key), alpha);
+    float y = mchr_priv_standard_gamma(mchr_priv_hash_1d(1, key), beta);
+    if (x + y > 0.0f)
+        return x / (x + y);
+    // both gamma samples underflowed (tiny shapes): all the mass is at 0 and 1
+    return mchr_priv_key_uniform(key, 2) < alpha / (alpha + beta) ? 1.0f : 0.0f;
+}
+
+static void mchr_priv_dirichlet(MCHR_UINT key, const float* alphas, MCHR_UINT count, float* out, size_t stride) {
+    float sum = 0.0f;
+    float alpha_sum = 0.0f;
+    for (MCHR_UINT j = 0; j < count; ++j) {
+        float value = mchr_priv_standard_gamma(mchr_priv_hash_1d((MCHR_INT)j, key), alphas[j]);
+        out[j * stride] = value;
+        sum += value;
+        alpha_sum += alphas[j];
+    }
+    if (sum > 0.0f) {
+        for (MCHR_UINT j = 0; j < count; ++j) {
+            out[j * stride] /= sum;
+        }
+        return;
+    }
+    // every gamma sample underflowed (tiny alphas): pick one component by its alpha
+    float target = mchr_priv_key_uniform(key, count) * alpha_sum;
+    MCHR_UINT chosen = count - 1;
+    for (MCHR_UINT j = 0; j < count; ++j) {
+        target -= alphas[j];
+        if (target < 0.0f) {
+            chosen = j;
+            break;
+        }
+    }
+    for (MCHR_UINT j = 0; j < count; ++j) {
+        out[j * stride] = (j == chosen) ? 1.0f : 0.0f;
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Private batch kernels, working on chunks of keys. Each one finds the uniforms of all its
+//  samples first, then transforms them in separate loops with no calls other than to the
+//  math functions, and only falls back to the scalar kernels for the few samples needing
+//  more (gamma attempts rejected by the squeeze test, and underflows), so the results are
+//  identical to theirs.
+// ---------------------------------------------------------------------------------------
+#define MCHR_PRIV_SAMPLE_CHUNK 64
+
+static void mchr_priv_keys_1d(MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, MCHR_UINT* out_keys) {
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        out_keys[i] = mchr_priv_hash_1d((MCHR_INT)((MCHR_UINT)first_pos + i), seed);
+    }
+}
+
+static void mchr_priv_exponential_chunk(const MCHR_UINT* keys, MCHR_UINT count, float rate, float* out) {
+    assert(rate > 0.0f);
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        out[i] = mchr_priv_key_uniform(keys[i], 0);
+    }
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        out[i] = -logf(out[i]) / rate;
+    }
+}
+
+static void mchr_priv_standard_normal_chunk(const MCHR_UINT* keys, MCHR_UINT count, float* out) {
+    float angle[MCHR_PRIV_SAMPLE_CHUNK];
+    assert(count <= MCHR_PRIV_SAMPLE_CHUNK);
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        out[i] = mchr_priv_key_uniform(keys[i], 0);
+        angle[i] = mchr_priv_key_uniform(keys[i], 1);
+    }
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        out[i] = sqrtf(-2.0f * logf(out[i])) * cosf(MCHR_TWO_PI * angle[i]);
+    }
+}
+
+static void mchr_priv_standard_gamma_chunk(const MCHR_UINT* keys, MCHR_UINT count, float shape, float* out) {
+    assert(shape > 0.0f);
+    assert(count <= MCHR_PRIV_SAMPLE_CHUNK);
+    if (shape < 1.0f) {
+        // the boosts, times samples of shape + 1 from the sub-keys
+        MCHR_UINT sub_keys[MCHR_PRIV_SAMPLE_CHUNK];
+        float boost[MCHR_PRIV_SAMPLE_CHUNK];
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            boost[i] = powf(mchr_priv_key_uniform(keys[i], 0), 1.0f / shape);
+            sub_keys[i] = mchr_priv_hash_1d(1, keys[i]);
+        }
+        mchr_priv_standard_gamma_chunk(sub_keys, count, shape + 1.0f, out);
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            out[i] *= boost[i];
+        }
+        return;
+    }
+
+    // the first Marsaglia-Tsang attempt of every sample, kept if the squeeze accepts it
+    const float d = shape - 1.0f / 3.0f;
+    const float c = 1.0f / sqrtf(9.0f * d);
+    float u[MCHR_PRIV_SAMPLE_CHUNK];
+    bool accepted[MCHR_PRIV_SAMPLE_CHUNK];
+    mchr_priv_standard_normal_chunk(keys, count, out);
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        u[i] = mchr_priv_key_uniform(keys[i], 2);
+    }
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        const float x = out[i];
+        const float x2 = x * x;
+        const float v = 1.0f + c * x;
+        accepted[i] = (v > 0.0f) && (u[i] < 1.0f - 0.0331f * x2 * x2);
+        out[i] = d * (v * v * v);
+    }
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        if (!accepted[i])
+            out[i] = mchr_priv_standard_gamma(keys[i], shape);
+    }
+}
+
+static void mchr_priv_beta_chunk(const MCHR_UINT* keys, MCHR_UINT count, float alpha, float beta, float* out) {
+    MCHR_UINT sub_keys[MCHR_PRIV_SAMPLE_CHUNK];
+    float y[MCHR_PRIV_SAMPLE_CHUNK];
+    assert(count <= MCHR_PRIV_SAMPLE_CHUNK);
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        sub_keys[i] = mchr_priv_hash_1d(0, keys[i]);
+    }
+    mchr_priv_standard_gamma_chunk(sub_keys, count, alpha, out);
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        sub_keys[i] = mchr_priv_hash_1d(1, keys[i]);
+    }
+    mchr_priv_standard_gamma_chunk(sub_keys, count, beta, y);
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        const float sum = out[i] + y[i];
+        out[i] = (sum > 0.0f) ? out[i] / sum : out[i];
+    }
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        if (!(out[i] + y[i] > 0.0f))
+            out[i] = mchr_priv_beta(keys[i], alpha, beta);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Exponential distribution.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF float mchr_get_exponential( const void* index_buffer, size_t len, MCHR_UINT seed, float rate ) {
+    return mchr_priv_exponential(mchr_get_hash_uint(index_buffer, len, seed), rate);
+}
+
+MCHR_DEF float mchr_get_1d_exponential( MCHR_INT pos, MCHR_UINT seed, float rate ) {
+    return mchr_priv_exponential(mchr_priv_hash_1d(pos, seed), rate);
+}
+
+MCHR_DEF float mchr_get_2d_exponential( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float rate ) {
+    return mchr_priv_exponential(mchr_priv_hash_2d(posX, posY, seed), rate);
+}
+
+MCHR_DEF void mchr_get_1d_exponential_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float rate, float* out ) {
+    MCHR_UINT keys[MCHR_PRIV_SAMPLE_CHUNK];
+    for (MCHR_UINT first = 0, chunk = 0; first < count; first += chunk) {
+        chunk = (count - first < MCHR_PRIV_SAMPLE_CHUNK) ? count - first : MCHR_PRIV_SAMPLE_CHUNK;
+        mchr_priv_keys_1d((MCHR_INT)((MCHR_UINT)first_pos + first), chunk, seed, keys);
+        mchr_priv_exponential_chunk(keys, chunk, rate, out + first);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Normal distribution.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF float mchr_get_normal( const void* index_buffer, size_t len, MCHR_UINT seed, float mean, float std_dev ) {
+    return mean + std_dev * mchr_priv_standard_normal(mchr_get_hash_uint(index_buffer, len, seed), 0);
+}
+
+MCHR_DEF float mchr_get_1d_normal( MCHR_INT pos, MCHR_UINT seed, float mean, float std_dev ) {
+    return mean + std_dev * mchr_priv_standard_normal(mchr_priv_hash_1d(pos, seed), 0);
+}
+
+MCHR_DEF float mchr_get_2d_normal( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float mean, float std_dev ) {
+    return mean + std_dev * mchr_priv_standard_normal(mchr_priv_hash_2d(posX, posY, seed), 0);
+}
+
+MCHR_DEF void mchr_get_1d_normal_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float mean, float std_dev, float* out ) {
+    MCHR_UINT keys[MCHR_PRIV_SAMPLE_CHUNK];
+    for (MCHR_UINT first = 0, chunk = 0; first < count; first += chunk) {
+        chunk = (count - first < MCHR_PRIV_SAMPLE_CHUNK) ? count - first : MCHR_PRIV_SAMPLE_CHUNK;
+        mchr_priv_keys_1d((MCHR_INT)((MCHR_UINT)first_pos + first), chunk, seed, keys);
+        mchr_priv_standard_normal_chunk(keys, chunk, out + first);
+        for (MCHR_UINT i = first; i < first + chunk; ++i) {
+            out[i] = mean + std_dev * out[i];
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Gamma distribution.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF float mchr_get_gamma( const void* index_buffer, size_t len, MCHR_UINT seed, float shape, float scale ) {
+    return scale * mchr_priv_standard_gamma(mchr_get_hash_uint(index_buffer, len, seed), shape);
+}
+
+MCHR_DEF float mchr_get_1d_gamma( MCHR_INT pos, MCHR_UINT seed, float shape, float scale ) {
+    return scale * mchr_priv_standard_gamma(mchr_priv_hash_1d(pos, seed), shape);
+}
+
+MCHR_DEF float mchr_get_2d_gamma( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float shape, float scale ) {
+    return scale * mchr_priv_standard_gamma(mchr_priv_hash_2d(posX, posY, seed), shape);
+}
+
+MCHR_DEF void mchr_get_1d_gamma_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float shape, float scale, float* out ) {
+    MCHR_UINT keys[MCHR_PRIV_SAMPLE_CHUNK];
+    for (MCHR_UINT first = 0, chunk = 0; first < count; first += chunk) {
+        chunk = (count - first < MCHR_PRIV_SAMPLE_CHUNK) ? count - first : MCHR_PRIV_SAMPLE_CHUNK;
+        mchr_priv_keys_1d((MCHR_INT)((MCHR_UINT)first_pos + first), chunk, seed, keys);
+        mchr_priv_standard_gamma_chunk(keys, chunk, shape, out + first);
+        for (MCHR_UINT i = first; i < first + chunk; ++i) {
+            out[i] = scale * out[i];
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Beta distribution.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF float mchr_get_beta( const void* index_buffer, size_t len, MCHR_UINT seed, float alpha, float beta ) {
+    return mchr_priv_beta(mchr_get_hash_uint(index_buffer, len, seed), alpha, beta);
+}
+
+MCHR_DEF float mchr_get_1d_beta( MCHR_INT pos, MCHR_UINT seed, float alpha, float beta ) {
+    return mchr_priv_beta(mchr_priv_hash_1d(pos, seed), alpha, beta);
+}
+
+MCHR_DEF float mchr_get_2d_beta( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float alpha, float beta ) {
+    return mchr_priv_beta(mchr_priv_hash_2d(posX, posY, seed), alpha, beta);
+}
+
+MCHR_DEF void mchr_get_1d_beta_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float alpha, float beta, float* out ) {
+    MCHR_UINT keys[MCHR_PRIV_SAMPLE_CHUNK];
+    for (MCHR_UINT first = 0, chunk = 0; first < count; first += chunk) {
+        chunk = (count - first < MCHR_PRIV_SAMPLE_CHUNK) ? count - first : MCHR_PRIV_SAMPLE_CHUNK;
+        mchr_priv_keys_1d((MCHR_INT)((MCHR_UINT)first_pos + first), chunk, seed, keys);
+        mchr_priv_beta_chunk(keys, chunk, alpha, beta, out + first);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Dirichlet distribution.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF void mchr_get_dirichlet( const void* index_buffer, size_t len, MCHR_UINT seed, const float* alphas, MCHR_UINT count, float* out_ratios ) {
+    mchr_priv_dirichlet(mchr_get_hash_uint(index_buffer, len, seed), alphas, count, out_ratios, 1);
+}
+
+MCHR_DEF void mchr_get_1d_dirichlet( MCHR_INT pos, MCHR_UINT seed, const float* alphas, MCHR_UINT count, float* out_ratios ) {
+    mchr_priv_dirichlet(mchr_priv_hash_1d(pos, seed), alphas, count, out_ratios, 1);
+}
+
+MCHR_DEF void mchr_get_2d_dirichlet( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, const float* alphas, MCHR_UINT count, float* out_ratios ) {
+    mchr_priv_dirichlet(mchr_priv_hash_2d(posX, posY, seed), alphas, count, out_ratios, 1);
+}
+
+MCHR_DEF void mchr_get_1d_dirichlet_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, const float* alphas, MCHR_UINT alphas_count, float* out_ratios ) {
+    MCHR_UINT keys[MCHR_PRIV_SAMPLE_CHUNK];
+    MCHR_UINT sub_keys[MCHR_PRIV_SAMPLE_CHUNK];
+    float sum[MCHR_PRIV_SAMPLE_CHUNK];
+    for (MCHR_UINT first = 0, chunk = 0; first < count; first += chunk) {
+        chunk = (count - first < MCHR_PRIV_SAMPLE_CHUNK) ? count - first : MCHR_PRIV_SAMPLE_CHUNK;
+        mchr_priv_keys_1d((MCHR_INT)((MCHR_UINT)first_pos + first), chunk, seed, keys);
+        for (MCHR_UINT i = 0; i < chunk; ++i) {
+            sum[i] = 0.0f;
+        }
+        // the gamma samples of each component, straight into its row of the output
+        for (MCHR_UINT j = 0; j < alphas_count; ++j) {
+            float* row = out_ratios + (size_t)j * count + first;
+            for (MCHR_UINT i = 0; i < chunk; ++i) {
+                sub_keys[i] = mchr_priv_hash_1d((MCHR_INT)j, keys[i]);
+            }
+            mchr_priv_standard_gamma_chunk(sub_keys, chunk, alphas[j], row);
+            for (MCHR_UINT i = 0; i < chunk; ++i) {
+                sum[i] += row[i];
+            }
+        }
+        for (MCHR_UINT j = 0; j < alphas_count; ++j) {
+            float* row = out_ratios + (size_t)j * count + first;
+            for (MCHR_UINT i = 0; i < chunk; ++i) {
+                row[i] = (sum[i] > 0.0f) ? row[i] / sum[i] : row[i];
+            }
+        }
+        for (MCHR_UINT i = 0; i < chunk; ++i) {
+            if (!(sum[i] > 0.0f))
+                mchr_priv_dirichlet(keys[i], alphas, alphas_count, out_ratios + first + i, count);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Private discrete distribution kernels. These work in double precision, as the inversion
+//  methods accumulate many small probabilities.
+// ---------------------------------------------------------------------------------------
+static double mchr_priv_key_uniform_double(MCHR_UINT key, MCHR_UINT index) {
+    return mchr_priv_uint_to_open_unit_double(mchr_priv_hash_1d((MCHR_INT)index, key));
+}
+
+static MCHR_UINT mchr_priv_binomial(MCHR_UINT key, MCHR_UINT trials, double p) {
+    if (trials == 0 || !(p > 0.0))
+        return 0;
+    if (p >= 1.0)
+        return trials;
+    if (p > 0.5)
+        return trials - mchr_priv_binomial(key, trials, 1.0 - p);
+
+    const double n = trials;
+    const double q = 1.0 - p;
+    if (n * p < 10.0) {
+        // inversion by sequential search from zero, expected O(n * p) steps
+        const double s = p / q;
+        const double a = (n + 1.0) * s;
+        double r = exp(n * log1p(-p));
+        double u = mchr_priv_key_uniform_double(key, 0);
+        MCHR_UINT x = 0;
+        while (u > r && x < trials) {
+            u -= r;
+            x += 1;
+            r *= (a / x - s);
+        }
+        return x;
+    }
+
+    // BTRS, from "The generation of binomial random variates" by Wolfgang Hormann
+    const double spq = sqrt(n * p * q);
+    const double b = 1.15 + 2.53 * spq;
+    const double a = -0.0873 + 0.0248 * b + 0.01 * p;
+    const double c = n * p + 0.5;
+    const double v_r = 0.92 - 4.2 / b;
+    const double alpha = (2.83 + 5.1 / b) * spq;
+    const double lpq = log(p / q);
+    const double m = floor((n + 1.0) * p);
+    const double h = lgamma(m + 1.0) + lgamma(n - m + 1.0);
+    for (MCHR_UINT index = 0; ; index += 2) {
+        double u = mchr_priv_key_uniform_double(key, index) - 0.5;
+        double v = mchr_priv_key_uniform_double(key, index + 1);
+        double us = 0.5 - fabs(u);
+        double k = floor((2.0 * a / us + b) * u + c);
+        if (k < 0.0 || k > n)
+            continue;
+        if (us >= 0.07 && v <= v_r)
+            return (MCHR_UINT)k;
+        v = log(v * alpha / (a / (us * us) + b));
+        if (v <= h - lgamma(k + 1.0) - lgamma(n - k + 1.0) + (k - m) * lpq)
+            return (MCHR_UINT)k;
+    }
+}
+
+static MCHR_UINT mchr_priv_poisson(MCHR_UINT key, double mean) {
+    if (!(mean > 0.0))
+        return 0;
+    // tens of thousands of standard deviations above the largest MCHR_UINT, which also
+    //  keeps infinite means out of PTRS
+    if (mean >= 8589934592.0)
+        return 0xFFFFFFFFU;
+
+    if (mean < 10.0) {
+        // inversion by sequential search from zero
+        double p = exp(-mean);
+        double cdf = p;
+        double u = mchr_priv_key_uniform_double(key, 0);
+        MCHR_UINT x = 0;
+        while (u > cdf && p > 0.0) {
+            x += 1;
+            p *= mean / x;
+            cdf += p;
+        }
+        return x;
+    }
+
+    // PTRS, from "The transformed rejection method for generating Poisson random
+    //  variables" by Wolfgang Hormann
+    const double slam = sqrt(mean);
+    const double loglam = log(mean);
+    const double b = 0.931 + 2.53 * slam;
+    const double a = -0.059 + 0.02483 * b;
+    const double inv_alpha = 1.1239 + 1.1328 / (b - 3.4);
+    const double v_r = 0.9277 - 3.6224 / (b - 2.0);
+    for (MCHR_UINT index = 0; ; index += 2) {
+        double u = mchr_priv_key_uniform_double(key, index) - 0.5;
+        double v = mchr_priv_key_uniform_double(key, index + 1);
+        double us = 0.5 - fabs(u);
+        double k = floor((2.0 * a / us + b) * u + mean + 0.43);
+        if (us >= 0.07 && v <= v_r)
+            return k < 4294967295.0 ? (MCHR_UINT)k : 0xFFFFFFFFU;
+        if (k < 0.0 || (us < 0.013 && v > us))
+            continue;
+        if (log(v) + log(inv_alpha) - log(a / (us * us) + b) <= -mean + k * loglam - lgamma(k + 1.0))
+            return k < 4294967295.0 ? (MCHR_UINT)k : 0xFFFFFFFFU;
+    }
+}
+
+static MCHR_UINT mchr_priv_geometric(MCHR_UINT key, double p) {
+    assert(p > 0.0);
+    if (p >= 1.0)
+        return 0;
+    double failures = floor(log(mchr_priv_key_uniform_double(key, 0)) / log1p(-p));
+    return failures < 4294967295.0 ? (MCHR_UINT)failures : 0xFFFFFFFFU;
+}
+
+static MCHR_UINT mchr_priv_negative_binomial(MCHR_UINT key, float successes, double p) {
+    assert(p > 0.0);
+    if (p >= 1.0 || !(successes > 0.0f))
+        return 0;
+    double mean = mchr_priv_standard_gamma(mchr_priv_hash_1d(0, key), successes) * (1.0 - p) / p;
+    return mchr_priv_poisson(mchr_priv_hash_1d(1, key), mean);
+}
+
+// ---------------------------------------------------------------------------------------
+// Binomial distribution.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF MCHR_UINT mchr_get_binomial( const void* index_buffer, size_t len, MCHR_UINT seed, MCHR_UINT trials, float probability ) {
+    return mchr_priv_binomial(mchr_get_hash_uint(index_buffer, len, seed), trials, probability);
+}
+
+MCHR_DEF MCHR_UINT mchr_get_1d_binomial( MCHR_INT pos, MCHR_UINT seed, MCHR_UINT trials, float probability ) {
+    return mchr_priv_binomial(mchr_priv_hash_1d(pos, seed), trials, probability);
+}
+
+MCHR_DEF MCHR_UINT mchr_get_2d_binomial( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, MCHR_UINT trials, float probability ) {
+    return mchr_priv_binomial(mchr_priv_hash_2d(posX, posY, seed), trials, probability);
+}
+
+MCHR_DEF void mchr_get_1d_binomial_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, MCHR_UINT trials, float probability, MCHR_UINT* out ) {
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        out[i] = mchr_priv_binomial(mchr_priv_hash_1d((MCHR_INT)((MCHR_UINT)first_pos + i), seed), trials, probability);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Poisson distribution.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF MCHR_UINT mchr_get_poisson( const void* index_buffer, size_t len, MCHR_UINT seed, float mean ) {
+    return mchr_priv_poisson(mchr_get_hash_uint(index_buffer, len, seed), mean);
+}
+
+MCHR_DEF MCHR_UINT mchr_get_1d_poisson( MCHR_INT pos, MCHR_UINT seed, float mean ) {
+    return mchr_priv_poisson(mchr_priv_hash_1d(pos, seed), mean);
+}
+
+MCHR_DEF MCHR_UINT mchr_get_2d_poisson( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float mean ) {
+    return mchr_priv_poisson(mchr_priv_hash_2d(posX, posY, seed), mean);
+}
+
+MCHR_DEF void mchr_get_1d_poisson_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float mean, MCHR_UINT* out ) {
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        out[i] = mchr_priv_poisson(mchr_priv_hash_1d((MCHR_INT)((MCHR_UINT)first_pos + i), seed), mean);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Geometric distribution (failures before the first success).
+// ---------------------------------------------------------------------------------------
+MCHR_DEF MCHR_UINT mchr_get_geometric( const void* index_buffer, size_t len, MCHR_UINT seed, float probability ) {
+    return mchr_priv_geometric(mchr_get_hash_uint(index_buffer, len, seed), probability);
+}
+
+MCHR_DEF MCHR_UINT mchr_get_1d_geometric( MCHR_INT pos, MCHR_UINT seed, float probability ) {
+    return mchr_priv_geometric(mchr_priv_hash_1d(pos, seed), probability);
+}
+
+MCHR_DEF MCHR_UINT mchr_get_2d_geometric( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float probability ) {
+    return mchr_priv_geometric(mchr_priv_hash_2d(posX, posY, seed), probability);
+}
+
+MCHR_DEF void mchr_get_1d_geometric_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float probability, MCHR_UINT* out ) {
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        out[i] = mchr_priv_geometric(mchr_priv_hash_1d((MCHR_INT)((MCHR_UINT)first_pos + i), seed), probability);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Negative binomial distribution (failures before a number of successes).
+// ---------------------------------------------------------------------------------------
+MCHR_DEF MCHR_UINT mchr_get_negative_binomial( const void* index_buffer, size_t len, MCHR_UINT seed, float successes, float probability ) {
+    return mchr_priv_negative_binomial(mchr_get_hash_uint(index_buffer, len, seed), successes, probability);
+}
+
+MCHR_DEF MCHR_UINT mchr_get_1d_negative_binomial( MCHR_INT pos, MCHR_UINT seed, float successes, float probability ) {
+    return mchr_priv_negative_binomial(mchr_priv_hash_1d(pos, seed), successes, probability);
+}
+
+MCHR_DEF MCHR_UINT mchr_get_2d_negative_binomial( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float successes, float probability ) {
+    return mchr_priv_negative_binomial(mchr_priv_hash_2d(posX, posY, seed), successes, probability);
+}
+
+MCHR_DEF void mchr_get_1d_negative_binomial_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float successes, float probability, MCHR_UINT* out ) {
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        out[i] = mchr_priv_negative_binomial(mchr_priv_hash_1d((MCHR_INT)((MCHR_UINT)first_pos + i), seed), successes, probability);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Private function computing the sine and cosine of an angle given in binary units
+//  (2^32 is a full turn). The angle is split into a quadrant and an offset in
+//  [-pi/4, pi/4) from the quadrant center, where short minimax polynomials (from Cephes'
+//  sinf and cosf) are accurate to about one float ulp. There are no branches, so it can
+//  be vectorized.
+// ---------------------------------------------------------------------------------------
+static void mchr_priv_sincos_turn(MCHR_UINT angle, float* out_sin, float* out_cos) {
+    MCHR_UINT shifted = angle + 0x20000000U;
+    MCHR_UINT quadrant = shifted >> 30;
+    MCHR_INT offset = (MCHR_INT)(shifted & 0x3FFFFFFFU) - 0x20000000;
+    float x = (float)offset * (MCHR_TWO_PI / 4294967296.0f);
+    float x2 = x * x;
+
+    float s = x + x * x2 * (-1.6666654611e-1f + x2 * (8.3321608736e-3f + x2 * -1.9515295891e-4f));
+    float c = 1.0f - 0.5f * x2 + x2 * x2 * (4.166664568298827e-2f + x2 * (-1.388731625493765e-3f + x2 * 2.443315711809948e-5f));
+
+    // rotate by the quadrant: (s, c), (c, -s), (-s, -c), (-c, s)
+    float sin_value = (quadrant & 1) ? c : s;
+    float cos_value = (quadrant & 1) ? s : c;
+    *out_sin = (quadrant & 2) ? -sin_value : sin_value;
+    *out_cos = ((quadrant + 1) & 2) ? -cos_value : cos_value;
+}
+
+// ---------------------------------------------------------------------------------------
+// Private function computing the cube root of a value in (0,1], starting from a bit
+//  manipulation estimate (dividing the exponent by 3) refined by Newton iterations.
+// ---------------------------------------------------------------------------------------
+static float mchr_priv_cbrt_unit(float value) {
+    MCHR_UINT bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bits = bits / 3 + 709921077U;
+    float y;
+    memcpy(&y, &bits, sizeof(y));
+    y = (2.0f * y + value / (y * y)) * (1.0f / 3.0f);
+    y = (2.0f * y + value / (y * y)) * (1.0f / 3.0f);
+    y = (2.0f * y + value / (y * y)) * (1.0f / 3.0f);
+    return y;
+}
+
+// ---------------------------------------------------------------------------------------
+// Private function mapping the 16 low bits of a hash into the open (0,1) interval.
+// ---------------------------------------------------------------------------------------
+static float mchr_priv_low_bits_to_open_unit(MCHR_UINT num) {
+    return ((num & 0xFFFFU) + 0.5f) * (1.0f / 65536.0f);
+}
+
+// ---------------------------------------------------------------------------------------
+// Private directional kernels, taking the key (hash of data and seed) of a sample.
+// ---------------------------------------------------------------------------------------
+static void mchr_priv_on_circle(MCHR_UINT key, float* out_x, float* out_y) {
+    mchr_priv_sincos_turn(key, out_y, out_x);
+}
+
+static void mchr_priv_in_disc(MCHR_UINT key, float* out_x, float* out_y) {
+    float s, c;
+    mchr_priv_sincos_turn(key & 0xFFFF0000U, &s, &c);
+    float radius = sqrtf(mchr_priv_low_bits_to_open_unit(key));
+    *out_x = radius * c;
+    *out_y = radius * s;
+}
+
+static void mchr_priv_on_sphere(MCHR_UINT key, float* out_x, float* out_y, float* out_z) {
+    float s, c;
+    mchr_priv_sincos_turn(key & 0xFFFF0000U, &s, &c);
+    float z = 1.0f - 2.0f * mchr_priv_low_bits_to_open_unit(key);
+    float radius = sqrtf(1.0f - z * z);
+    *out_x = radius * c;
+    *out_y = radius * s;
+    *out_z = z;
+}
+
+static void mchr_priv_in_ball(MCHR_UINT key, float* out_x, float* out_y, float* out_z) {
+    float x, y, z;
+    mchr_priv_on_sphere(key, &x, &y, &z);
+    float radius = mchr_priv_cbrt_unit(mchr_priv_uint_to_open_unit(mchr_priv_hash_1d(1, key)));
+    *out_x = radius * x;
+    *out_y = radius * y;
+    *out_z = radius * z;
+}
+
+// Uniform rotation by Ken Shoemake's method, from two angles and one uniform value.
+static void mchr_priv_rotation(MCHR_UINT key, float* out_x, float* out_y, float* out_z, float* out_w) {
+    float s1, c1, s2, c2;
+    mchr_priv_sincos_turn(key & 0xFFFF0000U, &s1, &c1);
+    mchr_priv_sincos_turn(key << 16, &s2, &c2);
+    float u = mchr_priv_uint_to_open_unit(mchr_priv_hash_1d(1, key));
+    float r1 = sqrtf(1.0f - u);
+    float r2 = sqrtf(u);
+    *out_x = r1 * s1;
+    *out_y = r1 * c1;
+    *out_z = r2 * s2;
+    *out_w = r2 * c2;
+}
+
+// ---------------------------------------------------------------------------------------
+// Point on the unit circle.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF void mchr_get_on_circle( const void* index_buffer, size_t len, MCHR_UINT seed, float* out_x, float* out_y ) {
+    mchr_priv_on_circle(mchr_get_hash_uint(index_buffer, len, seed), out_x, out_y);
+}
+
+MCHR_DEF void mchr_get_1d_on_circle( MCHR_INT pos, MCHR_UINT seed, float* out_x, float* out_y ) {
+    mchr_priv_on_circle(mchr_priv_hash_1d(pos, seed), out_x, out_y);
+}
+
+MCHR_DEF void mchr_get_2d_on_circle( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float* out_x, float* out_y ) {
+    mchr_priv_on_circle(mchr_priv_hash_2d(posX, posY, seed), out_x, out_y);
+}
+
+MCHR_DEF void mchr_get_1d_on_circle_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float* out_x, float* out_y ) {
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        mchr_priv_on_circle(mchr_priv_hash_1d((MCHR_INT)((MCHR_UINT)first_pos + i), seed), &out_x[i], &out_y[i]);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Point inside the unit disc.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF void mchr_get_in_disc( const void* index_buffer, size_t len, MCHR_UINT seed, float* out_x, float* out_y ) {
+    mchr_priv_in_disc(mchr_get_hash_uint(index_buffer, len, seed), out_x, out_y);
+}
+
+MCHR_DEF void mchr_get_1d_in_disc( MCHR_INT pos, MCHR_UINT seed, float* out_x, float* out_y ) {
+    mchr_priv_in_disc(mchr_priv_hash_1d(pos, seed), out_x, out_y);
+}
+
+MCHR_DEF void mchr_get_2d_in_disc( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float* out_x, float* out_y ) {
+    mchr_priv_in_disc(mchr_priv_hash_2d(posX, posY, seed), out_x, out_y);
+}
+
+MCHR_DEF void mchr_get_1d_in_disc_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float* out_x, float* out_y ) {
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        mchr_priv_in_disc(mchr_priv_hash_1d((MCHR_INT)((MCHR_UINT)first_pos + i), seed), &out_x[i], &out_y[i]);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Point on the unit sphere.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF void mchr_get_on_sphere( const void* index_buffer, size_t len, MCHR_UINT seed, float* out_x, float* out_y, float* out_z ) {
+    mchr_priv_on_sphere(mchr_get_hash_uint(index_buffer, len, seed), out_x, out_y, out_z);
+}
+
+MCHR_DEF void mchr_get_1d_on_sphere( MCHR_INT pos, MCHR_UINT seed, float* out_x, float* out_y, float* out_z ) {
+    mchr_priv_on_sphere(mchr_priv_hash_1d(pos, seed), out_x, out_y, out_z);
+}
+
+MCHR_DEF void mchr_get_2d_on_sphere( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float* out_x, float* out_y, float* out_z ) {
+    mchr_priv_on_sphere(mchr_priv_hash_2d(posX, posY, seed), out_x, out_y, out_z);
+}
+
+MCHR_DEF void mchr_get_1d_on_sphere_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float* out_x, float* out_y, float* out_z ) {
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        mchr_priv_on_sphere(mchr_priv_hash_1d((MCHR_INT)((MCHR_UINT)first_pos + i), seed), &out_x[i], &out_y[i], &out_z[i]);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Point inside the unit ball.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF void mchr_get_in_ball( const void* index_buffer, size_t len, MCHR_UINT seed, float* out_x, float* out_y, float* out_z ) {
+    mchr_priv_in_ball(mchr_get_hash_uint(index_buffer, len, seed), out_x, out_y, out_z);
+}
+
+MCHR_DEF void mchr_get_1d_in_ball( MCHR_INT pos, MCHR_UINT seed, float* out_x, float* out_y, float* out_z ) {
+    mchr_priv_in_ball(mchr_priv_hash_1d(pos, seed), out_x, out_y, out_z);
+}
+
+MCHR_DEF void mchr_get_2d_in_ball( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float* out_x, float* out_y, float* out_z ) {
+    mchr_priv_in_ball(mchr_priv_hash_2d(posX, posY, seed), out_x, out_y, out_z);
+}
+
+MCHR_DEF void mchr_get_1d_in_ball_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float* out_x, float* out_y, float* out_z ) {
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        mchr_priv_in_ball(mchr_priv_hash_1d((MCHR_INT)((MCHR_UINT)first_pos + i), seed), &out_x[i], &out_y[i], &out_z[i]);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Uniform rotation as a unit quaternion.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF void mchr_get_rotation( const void* index_buffer, size_t len, MCHR_UINT seed, float* out_x, float* out_y, float* out_z, float* out_w ) {
+    mchr_priv_rotation(mchr_get_hash_uint(index_buffer, len, seed), out_x, out_y, out_z, out_w);
+}
+
+MCHR_DEF void mchr_get_1d_rotation( MCHR_INT pos, MCHR_UINT seed, float* out_x, float* out_y, float* out_z, float* out_w ) {
+    mchr_priv_rotation(mchr_priv_hash_1d(pos, seed), out_x, out_y, out_z, out_w);
+}
+
+MCHR_DEF void mchr_get_2d_rotation( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, float* out_x, float* out_y, float* out_z, float* out_w ) {
+    mchr_priv_rotation(mchr_priv_hash_2d(posX, posY, seed), out_x, out_y, out_z, out_w);
+}
+
+MCHR_DEF void mchr_get_1d_rotation_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, float* out_x, float* out_y, float* out_z, float* out_w ) {
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        mchr_priv_rotation(mchr_priv_hash_1d((MCHR_INT)((MCHR_UINT)first_pos + i), seed), &out_x[i], &out_y[i], &out_z[i], &out_w[i]);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Piecewise-linear inverse CDF sampler.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF void mchr_cdf_from_pdf( const float* values, const float* pdf, MCHR_UINT count, float* out_cdf ) {
+    // trapezoidal integration of the density curve
+    float sum = 0.0f;
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        if (i > 0) {
+            assert(values[i] >= values[i - 1]);
+            sum += 0.5f * (pdf[i] + pdf[i - 1]) * (values[i] - values[i - 1]);
+        }
+        out_cdf[i] = sum;
+    }
+}
+
+MCHR_DEF void mchr_cdf_sampler_init( mchr_cdf_sampler_t* sampler, const float* values, const float* cdf, MCHR_UINT count, MCHR_UINT* guide, MCHR_UINT guide_size ) {
+    assert(count >= 2);
+    assert(guide_size >= 1);
+    assert(cdf[count - 1] > cdf[0]);
+
+    sampler->values = values;
+    sampler->cdf = cdf;
+    sampler->count = count;
+    sampler->guide = guide;
+    sampler->guide_size = guide_size;
+
+    // guide[j] is the first segment ending at or after the j-th fraction of the range
+    const float range = cdf[count - 1] - cdf[0];
+    MCHR_UINT segment = 0;
+    for (MCHR_UINT j = 0; j < guide_size; ++j) {
+        float threshold = cdf[0] + range * ((float)j / guide_size);
+        while (segment < count - 2 && cdf[segment + 1] < threshold) {
+            segment += 1;
+        }
+        guide[j] = segment;
+    }
+}
+
+MCHR_DEF float mchr_cdf_sampler_eval( const mchr_cdf_sampler_t* sampler, float zero_to_one ) {
+    const float* cdf = sampler->cdf;
+    const MCHR_UINT last_segment = sampler->count - 2;
+    const float target = cdf[0] + (cdf[sampler->count - 1] - cdf[0]) * zero_to_one;
+
+    MCHR_UINT guide_index = (MCHR_UINT)(zero_to_one * sampler->guide_size);
+    if (guide_index >= sampler->guide_size)
+        guide_index = sampler->guide_size - 1;
+
+    // find the first segment ending at or after the target (stepping back only guards
+    //  against rounding differences with the thresholds used to build the guide)
+    MCHR_UINT segment = sampler->guide[guide_index];
+    while (segment > 0 && cdf[segment] >= target) {
+        segment -= 1;
+    }
+    while (segment < last_segment && cdf[segment + 1] < target) {
+        segment += 1;
+    }
+
+    float low = cdf[segment];
+    float high = cdf[segment + 1];
+    float t = (high > low) ? (target - low) / (high - low) : 0.0f;
+    t = (t < 0.0f) ? 0.0f : ((t > 1.0f) ? 1.0f : t);
+    return sampler->values[segment] + t * (sampler->values[segment + 1] - sampler->values[segment]);
+}
+
+MCHR_DEF float mchr_get_cdf_sample( const void* index_buffer, size_t len, MCHR_UINT seed, const mchr_cdf_sampler_t* sampler ) {
+    return mchr_cdf_sampler_eval(sampler, mchr_priv_uint_to_open_unit(mchr_get_hash_uint(index_buffer, len, seed)));
+}
+
+MCHR_DEF float mchr_get_1d_cdf_sample( MCHR_INT pos, MCHR_UINT seed, const mchr_cdf_sampler_t* sampler ) {
+    return mchr_cdf_sampler_eval(sampler, mchr_priv_uint_to_open_unit(mchr_priv_hash_1d(pos, seed)));
+}
+
+MCHR_DEF float mchr_get_2d_cdf_sample( MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, const mchr_cdf_sampler_t* sampler ) {
+    return mchr_cdf_sampler_eval(sampler, mchr_priv_uint_to_open_unit(mchr_priv_hash_2d(posX, posY, seed)));
+}
+
+MCHR_DEF void mchr_get_1d_cdf_sample_batch( MCHR_INT first_pos, MCHR_UINT count, MCHR_UINT seed, const mchr_cdf_sampler_t* sampler, float* out ) {
+    // hash all positions first in a branch-free (vectorizable) pass, then look them up
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        out[i] = mchr_priv_uint_to_open_unit(mchr_priv_hash_1d((MCHR_INT)((MCHR_UINT)first_pos + i), seed));
+    }
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        out[i] = mchr_cdf_sampler_eval(sampler, out[i]);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Private quantization state: the parameters of a call, with the limits of the result as
+//  floats, rounded towards the inside of the range so that clamped values convert to
+//  integers without overflow.
+// ---------------------------------------------------------------------------------------
+typedef struct mchr_priv_quantizer_t {
+    float scale, offset;
+    float low, high;
+    mchr_rounding_t rounding;
+    MCHR_UINT seed;
+    bool is_2d;
+} mchr_priv_quantizer_t;
+
+static void mchr_priv_quantizer_init(mchr_priv_quantizer_t* quantizer, float scale, float offset, mchr_rounding_t rounding, MCHR_UINT seed, bool is_2d, MCHR_INT min, MCHR_INT max) {
+    assert(min <= max);
+    quantizer->scale = scale;
+    quantizer->offset = offset;
+    quantizer->low = (float)min;
+    quantizer->high = (float)max;
+    if ((double)quantizer->low < (double)min)
+        quantizer->low = nextafterf(quantizer->low, 0.0f);
+    if ((double)quantizer->high > (double)max)
+        quantizer->high = nextafterf(quantizer->high, 0.0f);
+    quantizer->rounding = rounding;
+    quantizer->seed = seed;
+    quantizer->is_2d = is_2d;
+}
+
+// ---------------------------------------------------------------------------------------
+// Private function rounding a value down, and then up when the fraction left is above the
+//  threshold. There are no branches, so it can be vectorized.
+// ---------------------------------------------------------------------------------------
+static MCHR_INT mchr_priv_quantize(float value, float scale, float offset, float shift, float threshold, float low, float high) {
+    float t = value * scale + offset + shift;
+    t = (t > low) ? t : low;
+    t = (t < high) ? t : high;
+    MCHR_INT floor_t = (MCHR_INT)t;
+    floor_t -= (t < (float)floor_t);
+    return floor_t + ((t - (float)floor_t) > threshold);
+}
+
+// ---------------------------------------------------------------------------------------
+// Private function returning the ordered dithering threshold of a position: its 8 low
+//  bits reversed in 1d, or the 16x16 Bayer matrix (interleaving the bits of x ^ y and y,
+//  and reversing them) in 2d.
+// ---------------------------------------------------------------------------------------
+static float mchr_priv_ordered_threshold(MCHR_INT posX, MCHR_INT posY, bool is_2d) {
+    MCHR_UINT x = (MCHR_UINT)posX & 0xFFU, y = (MCHR_UINT)posY & 0xFU;
+    MCHR_UINT bits = x;
+    if (is_2d) {
+        MCHR_UINT x_xor_y = (x ^ y) & 0xFU;
+        x_xor_y = (x_xor_y | (x_xor_y << 2)) & 0x33U;
+        x_xor_y = (x_xor_y | (x_xor_y << 1)) & 0x55U;
+        y = (y | (y << 2)) & 0x33U;
+        y = (y | (y << 1)) & 0x55U;
+        bits = x_xor_y | (y << 1);
+    }
+    bits = ((bits >> 1) & 0x55U) | ((bits & 0x55U) << 1);
+    bits = ((bits >> 2) & 0x33U) | ((bits & 0x33U) << 2);
+    bits = ((bits >> 4) & 0x0FU) | ((bits & 0x0FU) << 4);
+    return ((float)bits + 0.5f) * (1.0f / 256.0f);
+}
+
+// ---------------------------------------------------------------------------------------
+// Private quantization of `count` consecutive values of a row, starting at position
+//  (first_x, y) (y is ignored in 1d). The shift and threshold of every value are found
+//  first, in a pass per rounding mode, so every loop is branch-free and vectorizable.
+// ---------------------------------------------------------------------------------------
+#define MCHR_PRIV_QUANTIZE_CHUNK 64
+
+static void mchr_priv_quantize_chunk(const mchr_priv_quantizer_t* quantizer, const float* values, MCHR_UINT count, MCHR_INT first_x, MCHR_INT y, MCHR_INT* out) {
+    assert(count <= MCHR_PRIV_QUANTIZE_CHUNK);
+    const float below_half = 0.49999997f;   // halves are rounded up
+    const MCHR_UINT seed = quantizer->seed;
+    float shift[MCHR_PRIV_QUANTIZE_CHUNK];
+    float threshold[MCHR_PRIV_QUANTIZE_CHUNK];
+    MCHR_UINT hash[MCHR_PRIV_QUANTIZE_CHUNK];
+
+    if (quantizer->rounding == MCHR_ROUNDING_STOCHASTIC || quantizer->rounding == MCHR_ROUNDING_TRIANGULAR_DITHER) {
+        if (quantizer->is_2d) {
+            for (MCHR_UINT i = 0; i < count; ++i) {
+                hash[i] = mchr_priv_hash_2d((MCHR_INT)((MCHR_UINT)first_x + i), y, seed);
+            }
+        } else {
+            for (MCHR_UINT i = 0; i < count; ++i) {
+                hash[i] = mchr_priv_hash_1d((MCHR_INT)((MCHR_UINT)first_x + i), seed);
+            }
+        }
+    }
+
+    switch (quantizer->rounding) {
+    case MCHR_ROUNDING_NEAREST:
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            shift[i] = 0.0f;
+            threshold[i] = below_half;
+        }
+        break;
+    case MCHR_ROUNDING_STOCHASTIC:
+        // rounds up when a uniform value in [0, 1) is below the fraction
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            shift[i] = 0.0f;
+            threshold[i] = (float)(hash[i] >> 8) * (1.0f / 16777216.0f);
+        }
+        break;
+    case MCHR_ROUNDING_TRIANGULAR_DITHER:
+        // difference of two uniform values, from the two halves of the hash
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            shift[i] = (float)(hash[i] & 0xFFFFU) * (1.0f / 65536.0f) - (float)(hash[i] >> 16) * (1.0f / 65536.0f);
+            threshold[i] = below_half;
+        }
+        break;
+    case MCHR_ROUNDING_ORDERED_DITHER:
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            shift[i] = 0.0f;
+        }
+        if (quantizer->is_2d) {
+            for (MCHR_UINT i = 0; i < count; ++i) {
+                threshold[i] = mchr_priv_ordered_threshold((MCHR_INT)((MCHR_UINT)first_x + i), y, true);
+            }
+        } else {
+            for (MCHR_UINT i = 0; i < count; ++i) {
+                threshold[i] = mchr_priv_ordered_threshold((MCHR_INT)((MCHR_UINT)first_x + i), 0, false);
+            }
+        }
+        break;
+    default:
+        assert(!"unknown rounding mode");
+        return;
+    }
+
+    const float scale = quantizer->scale, offset = quantizer->offset, low = quantizer->low, high = quantizer->high;
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        out[i] = mchr_priv_quantize(values[i], scale, offset, shift[i], threshold[i], low, high);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Private batch quantization of a row-major image (a single row in 1d), converting the
+//  results of every chunk to the output type.
+// ---------------------------------------------------------------------------------------
+typedef enum mchr_priv_quantize_type_t {
+    MCHR_PRIV_QUANTIZE_U8,
+    MCHR_PRIV_QUANTIZE_U16,
+    MCHR_PRIV_QUANTIZE_I16,
+    MCHR_PRIV_QUANTIZE_I32
+} mchr_priv_quantize_type_t;
+
+static void mchr_priv_quantize_batch(const float* values, MCHR_UINT width, MCHR_UINT height, float scale, float offset, mchr_rounding_t rounding,
+                                     MCHR_INT first_x, MCHR_INT first_y, bool is_2d, MCHR_UINT seed, mchr_priv_quantize_type_t type, void* out) {
+    static const MCHR_INT limits[4][2] = { { 0, 255 }, { 0, 65535 }, { -32768, 32767 }, { INT_MIN, INT_MAX } };
+    assert(width == 0 || height == 0 || (values && out));
+    mchr_priv_quantizer_t quantizer;
+    mchr_priv_quantizer_init(&quantizer, scale, offset, rounding, seed, is_2d, limits[type][0], limits[type][1]);
+
+    MCHR_INT chunk[MCHR_PRIV_QUANTIZE_CHUNK];
+    for (MCHR_UINT row = 0; row < height; ++row) {
+        for (MCHR_UINT first = 0; first < width; first += MCHR_PRIV_QUANTIZE_CHUNK) {
+            const MCHR_UINT count = (width - first < MCHR_PRIV_QUANTIZE_CHUNK) ? width - first : MCHR_PRIV_QUANTIZE_CHUNK;
+            const size_t index = (size_t)row * width + first;
+            mchr_priv_quantize_chunk(&quantizer, values + index, count, (MCHR_INT)((MCHR_UINT)first_x + first), (MCHR_INT)((MCHR_UINT)first_y + row), chunk);
+            switch (type) {
+            case MCHR_PRIV_QUANTIZE_U8:
+                for (MCHR_UINT i = 0; i < count; ++i) {
+                    ((unsigned char*)out)[index + i] = (unsigned char)chunk[i];
+                }
+                break;
+            case MCHR_PRIV_QUANTIZE_U16:
+                for (MCHR_UINT i = 0; i < count; ++i) {
+                    ((unsigned short*)out)[index + i] = (unsigned short)chunk[i];
+                }
+                break;
+            case MCHR_PRIV_QUANTIZE_I16:
+                for (MCHR_UINT i = 0; i < count; ++i) {
+                    ((short*)out)[index + i] = (short)chunk[i];
+                }
+                break;
+            case MCHR_PRIV_QUANTIZE_I32:
+                memcpy((MCHR_INT*)out + index, chunk, count * sizeof(MCHR_INT));
+                break;
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Quantization with stochastic rounding and dithering.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF MCHR_INT mchr_quantize_1d( float value, float scale, float offset, mchr_rounding_t rounding, MCHR_INT pos, MCHR_UINT seed, MCHR_INT min, MCHR_INT max ) {
+    mchr_priv_quantizer_t quantizer;
+    mchr_priv_quantizer_init(&quantizer, scale, offset, rounding, seed, false, min, max);
+    MCHR_INT result;
+    mchr_priv_quantize_chunk(&quantizer, &value, 1, pos, 0, &result);
+    return result;
+}
+
+MCHR_DEF MCHR_INT mchr_quantize_2d( float value, float scale, float offset, mchr_rounding_t rounding, MCHR_INT posX, MCHR_INT posY, MCHR_UINT seed, MCHR_INT min, MCHR_INT max ) {
+    mchr_priv_quantizer_t quantizer;
+    mchr_priv_quantizer_init(&quantizer, scale, offset, rounding, seed, true, min, max);
+    MCHR_INT result;
+    mchr_priv_quantize_chunk(&quantizer, &value, 1, posX, posY, &result);
+    return result;
+}
+
+MCHR_DEF void mchr_quantize_1d_u8_batch( const float* values, MCHR_UINT count, float scale, float offset, mchr_rounding_t rounding, MCHR_INT first_pos, MCHR_UINT seed, unsigned char* out ) {
+    mchr_priv_quantize_batch(values, count, 1, scale, offset, rounding, first_pos, 0, false, seed, MCHR_PRIV_QUANTIZE_U8, out);
+}
+
+MCHR_DEF void mchr_quantize_1d_u16_batch( const float* values, MCHR_UINT count, float scale, float offset, mchr_rounding_t rounding, MCHR_INT first_pos, MCHR_UINT seed, unsigned short* out ) {
+    mchr_priv_quantize_batch(values, count, 1, scale, offset, rounding, first_pos, 0, false, seed, MCHR_PRIV_QUANTIZE_U16, out);
+}
+
+MCHR_DEF void mchr_quantize_1d_i16_batch( const float* values, MCHR_UINT count, float scale, float offset, mchr_rounding_t rounding, MCHR_INT first_pos, MCHR_UINT seed, short* out ) {
+    mchr_priv_quantize_batch(values, count, 1, scale, offset, rounding, first_pos, 0, false, seed, MCHR_PRIV_QUANTIZE_I16, out);
+}
+
+MCHR_DEF void mchr_quantize_1d_i32_batch( const float* values, MCHR_UINT count, float scale, float offset, mchr_rounding_t rounding, MCHR_INT first_pos, MCHR_UINT seed, MCHR_INT* out ) {
+    mchr_priv_quantize_batch(values, count, 1, scale, offset, rounding, first_pos, 0, false, seed, MCHR_PRIV_QUANTIZE_I32, out);
+}
+
+MCHR_DEF void mchr_quantize_2d_u8_batch( const float* values, MCHR_UINT width, MCHR_UINT height, float scale, float offset, mchr_rounding_t rounding, MCHR_INT first_x, MCHR_INT first_y, MCHR_UINT seed, unsigned char* out ) {
+    mchr_priv_quantize_batch(values, width, height, scale, offset, rounding, first_x, first_y, true, seed, MCHR_PRIV_QUANTIZE_U8, out);
+}
+
+MCHR_DEF void mchr_quantize_2d_u16_batch( const float* values, MCHR_UINT width, MCHR_UINT height, float scale, float offset, mchr_rounding_t rounding, MCHR_INT first_x, MCHR_INT first_y, MCHR_UINT seed, unsigned short* out ) {
+    mchr_priv_quantize_batch(values, width, height, scale, offset, rounding, first_x, first_y, true, seed, MCHR_PRIV_QUANTIZE_U16, out);
+}
+
+MCHR_DEF void mchr_quantize_2d_i16_batch( const float* values, MCHR_UINT width, MCHR_UINT height, float scale, float offset, mchr_rounding_t rounding, MCHR_INT first_x, MCHR_INT first_y, MCHR_UINT seed, short* out ) {
+    mchr_priv_quantize_batch(values, width, height, scale, offset, rounding, first_x, first_y, true, seed, MCHR_PRIV_QUANTIZE_I16, out);
+}
+
+MCHR_DEF void mchr_quantize_2d_i32_batch( const float* values, MCHR_UINT width, MCHR_UINT height, float scale, float offset, mchr_rounding_t rounding, MCHR_INT first_x, MCHR_INT first_y, MCHR_UINT seed, MCHR_INT* out ) {
+    mchr_priv_quantize_batch(values, width, height, scale, offset, rounding, first_x, first_y, true, seed, MCHR_PRIV_QUANTIZE_I32, out);
+}
+
+// ---------------------------------------------------------------------------------------
+// Private function returning the value of a Brownian bridge at `middle`, given the values
+//  at both ends of the interval (a, b) it splits. Every index but the ends of the path
+//  is the middle of exactly one interval of the recursive subdivision.
+// ---------------------------------------------------------------------------------------
+static float mchr_priv_bridge_middle(MCHR_UINT a, MCHR_UINT middle, MCHR_UINT b, float value_a, float value_b, float std_dev, MCHR_UINT seed) {
+    const float left = (float)(middle - a), right = (float)(b - middle), width = (float)(b - a);
+    const float mean = value_a + (value_b - value_a) * (left / width);
+    const float deviation = std_dev * sqrtf(left * right / width);
+    return mean + deviation * mchr_priv_standard_normal(mchr_priv_hash_1d((MCHR_INT)middle, seed), 0);
+}
+
+// ---------------------------------------------------------------------------------------
+// Private function filling the values between a and b that fall in [first, last],
+//  skipping the intervals outside of it.
+// ---------------------------------------------------------------------------------------
+static void mchr_priv_bridge_fill(MCHR_UINT a, MCHR_UINT b, float value_a, float value_b, MCHR_UINT first, MCHR_UINT last, float std_dev, MCHR_UINT seed, float* out) {
+    if (b - a < 2 || last <= a || first >= b)
+        return;
+    const MCHR_UINT middle = a + (b - a) / 2;
+    const float value_middle = mchr_priv_bridge_middle(a, middle, b, value_a, value_b, std_dev, seed);
+    if (middle >= first && middle <= last)
+        out[middle - first] = value_middle;
+    mchr_priv_bridge_fill(a, middle, value_a, value_middle, first, last, std_dev, seed, out);
+    mchr_priv_bridge_fill(middle, b, value_middle, value_b, first, last, std_dev, seed, out);
+}
+
+// ---------------------------------------------------------------------------------------
+// Brownian bridge.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF float mchr_get_brownian_bridge( MCHR_UINT index, MCHR_UINT length, MCHR_UINT seed, float start, float end, float std_dev ) {
+    assert(index <= length);
+    if (index == 0)
+        return start;
+    if (index == length)
+        return end;
+
+    // descend through the intervals containing the index, until it is a middle
+    MCHR_UINT a = 0, b = length;
+    float value_a = start, value_b = end;
+    while (1) {
+        const MCHR_UINT middle = a + (b - a) / 2;
+        const float value_middle = mchr_priv_bridge_middle(a, middle, b, value_a, value_b, std_dev, seed);
+        if (index == middle)
+            return value_middle;
+        if (index < middle) {
+            b = middle;
+            value_b = value_middle;
+        } else {
+            a = middle;
+            value_a = value_middle;
+        }
+    }
+}
+
+MCHR_DEF void mchr_get_brownian_bridge_batch( MCHR_UINT first_index, MCHR_UINT count, MCHR_UINT length, MCHR_UINT seed, float start, float end, float std_dev, float* out ) {
+    if (count == 0)
+        return;
+    const MCHR_UINT last_index = first_index + count - 1;
+    assert(last_index >= first_index && last_index <= length);
+    if (first_index == 0)
+        out[0] = start;
+    if (last_index == length)
+        out[length - first_index] = end;
+    mchr_priv_bridge_fill(0, length, start, end, first_index, last_index, std_dev, seed, out);
+}
+
+// ---------------------------------------------------------------------------------------
+// Private hierarchical tree state. Nodes hold a count or a mass, and are split in halves
+//  along each axis in turn; the splits of a node are numbered like a binary heap (0 for
+//  the first axis, 1 + i for the second, 3 + 2i + j for the third), and each one is
+//  keyed by its number and the hash of the node.
+// ---------------------------------------------------------------------------------------
+typedef struct mchr_priv_tree_t {
+    MCHR_UINT dims;
+    MCHR_UINT seed;
+    bool is_mass;
+    float root_mean;
+    float root_mass;
+    float roughness;
+    // batch region, at the level being filled
+    MCHR_UINT level;
+    MCHR_INT first[3];
+    MCHR_UINT size[3];
+    void* out;
+} mchr_priv_tree_t;
+
+typedef struct mchr_priv_tree_value_t {
+    MCHR_UINT count;
+    float mass;
+} mchr_priv_tree_value_t;
+
+static void mchr_priv_tree_init(mchr_priv_tree_t* tree, MCHR_UINT dims, MCHR_UINT seed, bool is_mass, float root_mean, float root_mass, float roughness) {
+    tree->dims = dims;
+    tree->seed = seed;
+    tree->is_mass = is_mass;
+    tree->root_mean = root_mean;
+    tree->root_mass = root_mass;
+    tree->roughness = roughness;
+}
+
+// floor(value / 2^shift), also for negative values
+static MCHR_INT mchr_priv_tree_shift(MCHR_INT value, MCHR_UINT shift) {
+    return (value >= 0) ? (MCHR_INT)((MCHR_UINT)value >> shift) : (MCHR_INT)~(~(MCHR_UINT)value >> shift);
+}
+
+static MCHR_UINT mchr_priv_tree_key(const mchr_priv_tree_t* tree, MCHR_UINT level, const MCHR_INT* coords) {
+    if (tree->dims == 2)
+        return mchr_priv_hash_3d(coords[0], coords[1], (MCHR_INT)level, tree->seed);
+    return mchr_priv_hash_4d(coords[0], coords[1], coords[2], (MCHR_INT)level, tree->seed);
+}
+
+static mchr_priv_tree_value_t mchr_priv_tree_root(const mchr_priv_tree_t* tree, MCHR_UINT key) {
+    mchr_priv_tree_value_t value;
+    value.count = tree->is_mass ? 0 : mchr_priv_poisson(mchr_priv_hash_1d(-1, key), tree->root_mean);
+    value.mass = tree->root_mass;
+    return value;
+}
+
+static void mchr_priv_tree_split(const mchr_priv_tree_t* tree, MCHR_UINT key, MCHR_UINT split, mchr_priv_tree_value_t value,
+                                 mchr_priv_tree_value_t* out_low, mchr_priv_tree_value_t* out_high) {
+    MCHR_UINT hash = mchr_priv_hash_1d((MCHR_INT)split, key);
+    *out_low = value;
+    *out_high = value;
+    if (tree->is_mass) {
+        out_low->mass = value.mass * (0.5f + 0.5f * tree->roughness * mchr_priv_uint_to_neg_one_one(hash >> 7));
+        out_high->mass = value.mass - out_low->mass;
+    } else {
+        out_low->count = mchr_priv_binomial(hash, value.count, 0.5);
+        out_high->count = value.count - out_low->count;
+    }
+}
+
+// values of all the children of a node, indexed by their offsets (x + 2y + 4z)
+static void mchr_priv_tree_children(const mchr_priv_tree_t* tree, MCHR_UINT key, mchr_priv_tree_value_t value, mchr_priv_tree_value_t* out_children) {
+    // parts[depth][path], path being the side taken at each split so far (first axis as
+    //  its highest bit)
+    mchr_priv_tree_value_t parts[4][8];
+    parts[0][0] = value;
+    for (MCHR_UINT axis = 0; axis < tree->dims; ++axis) {
+        const MCHR_UINT paths = 1u << axis;
+        for (MCHR_UINT path = 0; path < paths; ++path) {
+            mchr_priv_tree_split(tree, key, paths - 1 + path, parts[axis][path], &parts[axis + 1][2 * path], &parts[axis + 1][2 * path + 1]);
+        }
+    }
+    for (MCHR_UINT child = 0; child < (1u << tree->dims); ++child) {
+        MCHR_UINT path = 0;
+        for (MCHR_UINT axis = 0; axis < tree->dims; ++axis) {
+            path = 2 * path + ((child >> axis) & 1);
+        }
+        out_children[child] = parts[tree->dims][path];
+    }
+}
+
+static mchr_priv_tree_value_t mchr_priv_tree_node(const mchr_priv_tree_t* tree, MCHR_UINT level, const MCHR_INT* coords) {
+    assert(level < 32);
+    MCHR_INT node[3] = { 0, 0, 0 };
+    for (MCHR_UINT axis = 0; axis < tree->dims; ++axis) {
+        node[axis] = mchr_priv_tree_shift(coords[axis], level);
+    }
+    mchr_priv_tree_value_t value = mchr_priv_tree_root(tree, mchr_priv_tree_key(tree, 0, node));
+
+    // descend from the root, splitting only towards the node
+    for (MCHR_UINT node_level = 0; node_level < level; ++node_level) {
+        const MCHR_UINT key = mchr_priv_tree_key(tree, node_level, node);
+        MCHR_UINT split = 0;
+        for (MCHR_UINT axis = 0; axis < tree->dims; ++axis) {
+            const MCHR_INT child = mchr_priv_tree_shift(coords[axis], level - node_level - 1);
+            const MCHR_UINT side = (MCHR_UINT)(child - 2 * node[axis]);
+            mchr_priv_tree_value_t low, high;
+            mchr_priv_tree_split(tree, key, split, value, &low, &high);
+            value = side ? high : low;
+            split = 2 * split + 1 + side;
+        }
+        for (MCHR_UINT axis = 0; axis < tree->dims; ++axis) {
+            node[axis] = mchr_priv_tree_shift(coords[axis], level - node_level - 1);
+        }
+    }
+    return value;
+}
+
+// fills the nodes of the batch region under a node; zero counts are already filled
+static void mchr_priv_tree_fill(const mchr_priv_tree_t* tree, MCHR_UINT node_level, const MCHR_INT* node, mchr_priv_tree_value_t value) {
+    const MCHR_UINT shift = tree->level - node_level;
+    for (MCHR_UINT axis = 0; axis < tree->dims; ++axis) {
+        // range of the region's nodes under this one, which is never empty; regions
+        //  crossing INT_MAX continue from INT_MIN, so their part past it is checked 2^32 lower
+        const long long node_first = (long long)node[axis] * ((long long)1 << shift);
+        const long long node_last = node_first + ((long long)1 << shift) - 1;
+        const long long region_first = tree->first[axis];
+        const long long region_last = region_first + tree->size[axis] - 1;
+        const long long wrap = (long long)1 << 32;
+        if ((node_last < region_first || node_first > region_last) && (node_last < region_first - wrap || node_first > region_last - wrap))
+            return;
+    }
+    if (!tree->is_mass && value.count == 0)
+        return;
+
+    if (shift == 0) {
+        size_t index = 0;
+        for (MCHR_UINT axis = tree->dims; axis-- > 0;) {
+            index = index * tree->size[axis] + ((MCHR_UINT)node[axis] - (MCHR_UINT)tree->first[axis]);
+        }
+        if (tree->is_mass)
+            ((float*)tree->out)[index] = value.mass;
+        else
+            ((MCHR_UINT*)tree->out)[index] = value.count;
+        return;
+    }
+
+    mchr_priv_tree_value_t children[8];
+    mchr_priv_tree_children(tree, mchr_priv_tree_key(tree, node_level, node), value, children);
+    for (MCHR_UINT child = 0; child < (1u << tree->dims); ++child) {
+        MCHR_INT child_node[3] = { 0, 0, 0 };
+        for (MCHR_UINT axis = 0; axis < tree->dims; ++axis) {
+            child_node[axis] = 2 * node[axis] + (MCHR_INT)((child >> axis) & 1);
+        }
+        mchr_priv_tree_fill(tree, node_level + 1, child_node, children[child]);
+    }
+}
+
+static void mchr_priv_tree_batch(mchr_priv_tree_t* tree, MCHR_UINT level, const MCHR_INT* first, const MCHR_UINT* size, void* out) {
+    assert(level < 32);
+    size_t total = 1;
+    tree->level = level;
+    for (MCHR_UINT axis = 0; axis < 3; ++axis) {
+        tree->first[axis] = (axis < tree->dims) ? first[axis] : 0;
+        tree->size[axis] = (axis < tree->dims) ? size[axis] : 1;
+        total *= tree->size[axis];
+    }
+    tree->out = out;
+    if (total == 0)
+        return;
+    assert(out);
+    if (!tree->is_mass)
+        memset(out, 0, total * sizeof(MCHR_UINT));
+
+    // roots over the region, which are (32 - level)-bit values wrapping like positions do
+    MCHR_INT root_first[3];
+    MCHR_UINT root_count[3];
+    for (MCHR_UINT axis = 0; axis < 3; ++axis) {
+        const MCHR_INT last = (MCHR_INT)((MCHR_UINT)tree->first[axis] + tree->size[axis] - 1);
+        root_first[axis] = mchr_priv_tree_shift(tree->first[axis], level);
+        root_count[axis] = (((MCHR_UINT)mchr_priv_tree_shift(last, level) - (MCHR_UINT)root_first[axis]) & (0xFFFFFFFFU >> level)) + 1;
+    }
+    MCHR_INT root[3] = { 0, 0, 0 };
+    for (MCHR_UINT k2 = 0; k2 < root_count[2]; ++k2) {
+        root[2] = mchr_priv_tree_shift((MCHR_INT)(((MCHR_UINT)root_first[2] + k2) << level), level);
+        for (MCHR_UINT k1 = 0; k1 < root_count[1]; ++k1) {
+            root[1] = mchr_priv_tree_shift((MCHR_INT)(((MCHR_UINT)root_first[1] + k1) << level), level);
+            for (MCHR_UINT k0 = 0; k0 < root_count[0]; ++k0) {
+                root[0] = mchr_priv_tree_shift((MCHR_INT)(((MCHR_UINT)root_first[0] + k0) << level), level);
+                mchr_priv_tree_fill(tree, 0, root, mchr_priv_tree_root(tree, mchr_priv_tree_key(tree, 0, root)));
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Quadtree and octree hierarchical values.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF MCHR_UINT mchr_get_quadtree_count( MCHR_UINT level, MCHR_INT x, MCHR_INT y, MCHR_UINT seed, float root_mean ) {
+    mchr_priv_tree_t tree;
+    mchr_priv_tree_init(&tree, 2, seed, false, root_mean, 0.0f, 0.0f);
+    const MCHR_INT coords[3] = { x, y, 0 };
+    return mchr_priv_tree_node(&tree, level, coords).count;
+}
+
+MCHR_DEF float mchr_get_quadtree_mass( MCHR_UINT level, MCHR_INT x, MCHR_INT y, MCHR_UINT seed, float root_mass, float roughness ) {
+    mchr_priv_tree_t tree;
+    mchr_priv_tree_init(&tree, 2, seed, true, 0.0f, root_mass, roughness);
+    const MCHR_INT coords[3] = { x, y, 0 };
+    return mchr_priv_tree_node(&tree, level, coords).mass;
+}
+
+MCHR_DEF void mchr_get_quadtree_count_batch( MCHR_UINT level, MCHR_INT first_x, MCHR_INT first_y, MCHR_UINT width, MCHR_UINT height, MCHR_UINT seed, float root_mean, MCHR_UINT* out ) {
+    mchr_priv_tree_t tree;
+    mchr_priv_tree_init(&tree, 2, seed, false, root_mean, 0.0f, 0.0f);
+    const MCHR_INT first[3] = { first_x, first_y, 0 };
+    const MCHR_UINT size[3] = { width, height, 1 };
+    mchr_priv_tree_batch(&tree, level, first, size, out);
+}
+
+MCHR_DEF void mchr_get_quadtree_mass_batch( MCHR_UINT level, MCHR_INT first_x, MCHR_INT first_y, MCHR_UINT width, MCHR_UINT height, MCHR_UINT seed, float root_mass, float roughness, float* out ) {
+    mchr_priv_tree_t tree;
+    mchr_priv_tree_init(&tree, 2, seed, true, 0.0f, root_mass, roughness);
+    const MCHR_INT first[3] = { first_x, first_y, 0 };
+    const MCHR_UINT size[3] = { width, height, 1 };
+    mchr_priv_tree_batch(&tree, level, first, size, out);
+}
+
+MCHR_DEF MCHR_UINT mchr_get_octree_count( MCHR_UINT level, MCHR_INT x, MCHR_INT y, MCHR_INT z, MCHR_UINT seed, float root_mean ) {
+    mchr_priv_tree_t tree;
+    mchr_priv_tree_init(&tree, 3, seed, false, root_mean, 0.0f, 0.0f);
+    const MCHR_INT coords[3] = { x, y, z };
+    return mchr_priv_tree_node(&tree, level, coords).count;
+}
+
+MCHR_DEF float mchr_get_octree_mass( MCHR_UINT level, MCHR_INT x, MCHR_INT y, MCHR_INT z, MCHR_UINT seed, float root_mass, float roughness ) {
+    mchr_priv_tree_t tree;
+    mchr_priv_tree_init(&tree, 3, seed, true, 0.0f, root_mass, roughness);
+    const MCHR_INT coords[3] = { x, y, z };
+    return mchr_priv_tree_node(&tree, level, coords).mass;
+}
+
+MCHR_DEF void mchr_get_octree_count_batch( MCHR_UINT level, MCHR_INT first_x, MCHR_INT first_y, MCHR_INT first_z, MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT seed, float root_mean, MCHR_UINT* out ) {
+    mchr_priv_tree_t tree;
+    mchr_priv_tree_init(&tree, 3, seed, false, root_mean, 0.0f, 0.0f);
+    const MCHR_INT first[3] = { first_x, first_y, first_z };
+    const MCHR_UINT size[3] = { width, height, depth };
+    mchr_priv_tree_batch(&tree, level, first, size, out);
+}
+
+MCHR_DEF void mchr_get_octree_mass_batch( MCHR_UINT level, MCHR_INT first_x, MCHR_INT first_y, MCHR_INT first_z, MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT seed, float root_mass, float roughness, float* out ) {
+    mchr_priv_tree_t tree;
+    mchr_priv_tree_init(&tree, 3, seed, true, 0.0f, root_mass, roughness);
+    const MCHR_INT first[3] = { first_x, first_y, first_z };
+    const MCHR_UINT size[3] = { width, height, depth };
+    mchr_priv_tree_batch(&tree, level, first, size, out);
+}
+
+// ---------------------------------------------------------------------------------------
+// Private timeline buckets. The events of a bucket are placed at the normalized partial
+//  sums of count + 1 exponential spacings, which gives sorted uniform order statistics
+//  without sorting.
+// ---------------------------------------------------------------------------------------
+#define MCHR_PRIV_TIMELINE_BUCKET_EVENTS 4.0
+
+static double mchr_priv_timeline_spacing(MCHR_UINT key, MCHR_UINT index) {
+    return -log(mchr_priv_key_uniform_double(key, index));
+}
+
+static MCHR_UINT mchr_priv_timeline_bucket(long long bucket, double bucket_length, double t0, double t1, MCHR_UINT seed,
+                                           double* out_times, MCHR_UINT* out_ids, MCHR_UINT capacity, MCHR_UINT found) {
+    const MCHR_UINT key = mchr_priv_hash_2d((MCHR_INT)(MCHR_UINT)bucket, (MCHR_INT)(MCHR_UINT)((unsigned long long)bucket >> 32), seed);
+    const MCHR_UINT count = mchr_priv_poisson(mchr_priv_hash_1d(-1, key), MCHR_PRIV_TIMELINE_BUCKET_EVENTS);
+    if (count == 0)
+        return 0;
+
+    double total = 0.0;
+    for (MCHR_UINT i = 0; i <= count; ++i) {
+        total += mchr_priv_timeline_spacing(key, i);
+    }
+    const MCHR_UINT id_key = mchr_priv_hash_1d(-2, key);
+    const double start = (double)bucket * bucket_length;
+    const double end = (double)(bucket + 1) * bucket_length;
+    const double scale = bucket_length / total;
+    MCHR_UINT added = 0;
+    double sum = 0.0;
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        sum += mchr_priv_timeline_spacing(key, i);
+        // rounding must not move events past the next bucket's, to keep them sorted
+        const double time = fmin(start + sum * scale, end);
+        if (time < t0)
+            continue;
+        if (time >= t1)
+            break;
+        if (found + added < capacity) {
+            out_times[found + added] = time;
+            if (out_ids)
+                out_ids[found + added] = mchr_priv_hash_1d((MCHR_INT)i, id_key);
+        }
+        added += 1;
+    }
+    return added;
+}
+
+// ---------------------------------------------------------------------------------------
+// Timelines.
+// ---------------------------------------------------------------------------------------
+MCHR_DEF MCHR_UINT mchr_get_timeline_events( double t0, double t1, float rate, MCHR_UINT seed, double* out_times, MCHR_UINT* out_ids, MCHR_UINT capacity ) {
+    assert(out_times != NULL || capacity == 0);
+    if (!(rate > 0.0f) || !(t1 > t0))
+        return 0;
+
+    const double bucket_length = MCHR_PRIV_TIMELINE_BUCKET_EVENTS / rate;
+    const double first_bucket = floor(t0 / bucket_length);
+    const double last_bucket = floor(t1 / bucket_length);
+    assert(fabs(first_bucket) < 4611686018427387904.0 && fabs(last_bucket) < 4611686018427387904.0);
+
+    // events are filtered by time alone, so the buckets next to the window are visited too,
+    //  in case rounding in the divisions above put a window end in the wrong bucket
+    MCHR_UINT found = 0;
+    for (long long bucket = (long long)first_bucket - 1; bucket <= (long long)last_bucket + 1; ++bucket) {
+        found += mchr_priv_timeline_bucket(bucket, bucket_length, t0, t1, seed, out_times, out_ids, capacity, found);
+    }
+    return found;
+}
+
 #endif // MCHR_IMPLEMENTATION
 
 /*
@@ -0,0 +1,3969 @@
+// mc_noise.h - v0.10 - public domain, initial release 2026-10-16 - Miguel A. Friginal
+//
+// Coherent noise functions built on mc_hash_rng.h.
+//
+// This is a single-header-file library that provides lattice noise functions for
+// procedural generation. Instead of permutation tables, the values at lattice points are
+// obtained by hashing their integer coordinates with the functions in mc_hash_rng.h, so
+// noise has no repetition period, seeding is free, and every function is a pure function
+// of its parameters. Besides scalar functions evaluating a single point, there are batch
+// functions evaluating arrays of points (SoA) and regular grids, which compute the lattice
+// hashes in vectorizable loops and reuse them between neighbouring samples.
+//
+//
+// This library is based on the work of many online sources, mainly:
+//
+//   Value Noise and Procedural Patterns by Scratchapixel
+//      https://www.scratchapixel.com/lessons/procedural-generation-virtual-worlds/procedural-patterns-noise-part-1
+//
+//   Improving Noise by Ken Perlin
+//      https://mrl.cs.nyu.edu/~perlin/paper445.pdf
+//
+//   Simplex noise demystified by Stefan Gustavson
+//      https://weber.itn.liu.se/~stegu/simplexnoise/simplexnoise.pdf
+//
+//   OpenSimplex2 by K.jpg
+//      https://github.com/KdotJPG/OpenSimplex2
+//
+//   A Cellular Texture Basis Function by Steven Worley
+//      https://dl.acm.org/doi/10.1145/237170.237267
+//
+//
+// History:
+//
+//      0.1 (2026-10-16) First version, with value noise.
+//      0.2 (2026-10-16) Added gradient noise.
+//      0.3 (2026-10-16) Added simplex noise.
+//      0.4 (2026-10-16) Added cellular noise.
+//      0.5 (2026-10-16) Added fractal noise.
+//      0.6 (2026-10-16) Added noise graphs.
+//      0.7 (2026-10-16) Added bounds.
+//      0.8 (2026-10-16) Added derivatives.
+//      0.9 (2026-10-16) Added curl noise.
+//      0.10 (2026-10-16) Added periodic noise.
+//
+//
+// Compiling:
+//
+//   This library depends on mc_hash_rng.h, which needs to be in the include path. In one
+//   C/C++ file that #includes this file, do
+//
+//      #define MCHR_IMPLEMENTATION
+//      #define MCN_IMPLEMENTATION
+//      #include "mc_noise.h"
+//
+//   (the implementation of mc_hash_rng.h can also be compiled in a different file).
+//
+//   Optionally, #define MCN_STATIC before including the header to cause definitions to be
+//   private to the implementation file (i.e. to be "static" instead of "extern"). The
+//   integer types are the ones selected by mc_hash_rng.h (see MCHR_USE_STDINT).
+//
+//
+// License:
+//
+//   See end of file for license information.
+//
+//
+// Usage:
+//
+//   All noise functions take floating point coordinates and an unsigned int seed, and,
+//   except for cellular noise, return values in the closed [-1,1] range:
+//
+//          float height = mcn_value_noise_2d(x * 0.01f, y * 0.01f, seed);
+//
+//   Batch functions take arrays of coordinates, one per axis, and write one result per
+//   point:
+//
+//          mcn_value_noise_3d_batch(xs, ys, zs, count, seed, densities);
+//
+//   Grid functions evaluate a regular grid of points, starting at a position and moving a
+//   fixed step along each axis, writing the results in row-major order (x changes
+//   fastest). Grid results are identical to evaluating each point at start + i * step:
+//
+//          float tile[64 * 64];
+//          mcn_value_noise_2d_grid(tile_x * 64 * 0.01f, tile_y * 64 * 0.01f, 0.01f, 0.01f,
+//                                  64, 64, seed, tile);
+//
+//
+// Noise types:
+//
+//   Value noise interpolates random values placed at the integer lattice points with a
+//   smoothstep curve. The value at a lattice point is the hash of its coordinates mapped
+//   to [-1,1], e.g. `mchr_get_2d_hash_uint(x, y, seed)` in 2D.
+//
+//   Gradient noise (Perlin's improved noise) interpolates, with a quintic curve, the dot
+//   products between random gradients at the lattice points and the offsets to the
+//   sample. Gradients are chosen by the hash of the lattice point instead of a 256-entry
+//   permutation table, so the noise never repeats. It's zero at every lattice point.
+//
+//   Simplex noise sums radially symmetric kernels centered at the vertices of the simplex
+//   (triangle, tetrahedron, ...) containing the sample, each weighting the dot product with
+//   the gradient of its vertex. It only visits n+1 lattice points instead of 2^n, so it's
+//   the cheapest of the gradient noises in 3D and 4D, and has less visible axis-aligned
+//   artifacts. Gradients are picked from the same sets as in gradient noise, with the hash
+//   of the skewed lattice coordinates of each vertex.
+//
+//   Cellular (Worley) noise places one feature point in every lattice cell, and returns
+//   the distances from the sample to the closest one (F1) and to the second closest one
+//   (F2), along with the id of the cell holding the closest point, which is the hash of
+//   the cell coordinates (e.g. `mchr_get_2d_hash_uint(x, y, seed)`). Ids can be used as
+//   seeds for any per-cell data, like the biome of a region. Distances are in lattice
+//   units, so cellular noise is not in the [-1,1] range:
+//
+//          float f2;
+//          MCHR_UINT cell_id;
+//          float f1 = mcn_cellular_noise_2d(x, y, 1.0f, MCN_DISTANCE_EUCLIDEAN, seed, &f2, &cell_id);
+//          float cracks = f2 - f1;
+//
+//   Fractal noise adds octaves of value, gradient or simplex noise, each at `lacunarity`
+//   times the frequency and `gain` times the amplitude of the previous one, normalized
+//   back to [-1,1]. Billow and ridged fractals fold every octave around zero to get
+//   rounded or sharp features, and the domain warp offsets the sample with extra noise
+//   evaluations before adding the octaves. Each octave is seeded with a hash of its index
+//   (see `mcn_get_octave_seed()`), so octaves are uncorrelated:
+//
+//          mcn_fractal_t terrain;
+//          mcn_fractal_init(&terrain, MCN_NOISE_SIMPLEX, MCN_FRACTAL_RIDGED, 6);
+//          terrain.frequency = 1.0f / 256.0f;
+//          terrain.warp_amplitude = 16.0f;
+//          terrain.warp_frequency = 1.0f / 512.0f;
+//          mcn_fractal_noise_2d_grid(&terrain, x0, y0, 1.0f, 1.0f, 64, 64, seed, heights);
+//
+//
+// Noise graphs:
+//
+//   A noise graph combines the coordinates, constants, noises and element-wise operations
+//   into a single function, like a terrain made of a warped fractal blended with a mask
+//   and remapped through a curve. Graphs are evaluated in chunks of points, running every
+//   node over the chunk before moving to the next one, so intermediate values stay in a
+//   few small buffers in L1 cache instead of a full array per node. Building a node that
+//   already exists returns the existing one, operations on constants are folded, and
+//   compiling fuses multiplications followed by additions and reuses buffers:
+//
+//          mcn_graph_node_t nodes[32];
+//          mcn_graph_t graph;
+//          mcn_graph_init(&graph, nodes, 32);
+//          MCHR_UINT scale = mcn_graph_constant(&graph, 1.0f / 256.0f);
+//          MCHR_UINT x = mcn_graph_mul(&graph, mcn_graph_x(&graph), scale);
+//          MCHR_UINT y = mcn_graph_mul(&graph, mcn_graph_y(&graph), scale);
+//          MCHR_UINT warp = mcn_graph_noise_2d(&graph, MCN_NOISE_GRADIENT, x, y, 1);
+//          MCHR_UINT warped_x = mcn_graph_add(&graph, x, mcn_graph_mul(&graph, warp, mcn_graph_constant(&graph, 0.5f)));
+//          MCHR_UINT hills = mcn_graph_fractal_2d(&graph, &terrain, warped_x, y, 2);
+//          MCHR_UINT mask = mcn_graph_noise_2d(&graph, MCN_NOISE_VALUE, x, y, 3);
+//          MCHR_UINT blend = mcn_graph_mix(&graph, hills, mcn_graph_constant(&graph, -0.2f), mask);
+//          MCHR_UINT height = mcn_graph_curve(&graph, blend, curve_x, curve_y, 4);
+//          mcn_graph_compile(&graph, height);
+//          mcn_graph_eval_2d_grid(&graph, x0, y0, 1.0f, 1.0f, 64, 64, seed, heights);
+//
+//
+// Bounds:
+//
+//   Bounds functions return a conservative range of the values of a noise inside an
+//   axis-aligned box, found from the lattice points around the box without evaluating the
+//   noise anywhere. Every value the noise takes in the box is guaranteed to be in the
+//   range, but the range can be wider than the actual one. They're meant to skip work on
+//   boxes whose outcome is known, like chunks of a density field that are all air:
+//
+//          float lo, hi;
+//          mcn_fractal_noise_3d_bounds(&density, x0, y0, z0, x0 + 31, y0 + 31, z0 + 31, seed, &lo, &hi);
+//          if (hi < 0.0f)
+//              return CHUNK_EMPTY;
+//
+//
+// Derivatives:
+//
+//   Value, gradient, simplex and fractal noise in 2D and 3D have `_deriv` versions that
+//   also return the partial derivatives of the noise along each axis, computed
+//   analytically along with the value for about 1.5 times the cost of the value alone,
+//   instead of the 4 or 6 extra evaluations of finite differences. Values are the same as
+//   the ones of the functions without derivatives. Normals of a heightmap come out as:
+//
+//          float dx, dy;
+//          float height = scale * mcn_fractal_noise_2d_deriv(&terrain, x, y, seed, &dx, &dy);
+//          normal = normalize(-scale * dx, -scale * dy, 1.0f);
+//
+//   Billow and ridged fractals have creases where an octave crosses zero; the
+//   derivatives there are the ones of either side.
+//
+//
+// Curl noise:
+//
+//   Curl noise functions return velocities of a divergence-free flow, the curl of a
+//   potential made of gradient noise, or of the given fractal noise in the fractal
+//   versions. Particles advected by it swirl around without gathering or spreading out,
+//   like in smoke. 2D velocities cost one noise evaluation with derivatives, and 3D
+//   velocities three, one per component of the potential. Particles are usually kept in
+//   SoA arrays and advanced in batches:
+//
+//          mcn_curl_noise_3d_batch(px, py, pz, count, seed, vx, vy, vz);
+//          for (int i = 0; i < count; ++i) {
+//              px[i] += vx[i] * dt;  py[i] += vy[i] * dt;  pz[i] += vz[i] * dt;
+//          }
+//
+//   Like the rest of the noise functions, these are deterministic across platforms, so
+//   simulations stay in sync between machines given the same particles and seed.
+//
+//
+// Periodic noise:
+//
+//   `_periodic` versions of value, gradient, cellular and fractal noise repeat after a
+//   whole number of lattice cells along each axis, by wrapping lattice coordinates before
+//   hashing them, so they tile seamlessly. A period of 0 leaves an axis unbounded, which
+//   makes looping animations out of 4D noise with a period only along time:
+//
+//          // a 256x256 texture tiling every 8 cells
+//          mcn_gradient_noise_2d_periodic_grid(0.0f, 0.0f, 8.0f / 256, 8.0f / 256, 256, 256, 8, 8, seed, texture);
+//          // clouds looping every 16 units of time
+//          float density = mcn_gradient_noise_4d_periodic(x, y, z, t, 0, 0, 0, 16, seed);
+//
+//   Fractal periods are in input units, and only tile when they are a whole number of
+//   cells at every octave (and in the warp), e.g. with integer frequencies and a
+//   lacunarity of 2. Simplex noise has no periodic versions, as its skewed lattice doesn't
+//   repeat along the axes.
+//
+//
+// Determinism:
+//
+//   Noise functions only use additions, multiplications, divisions, square roots,
+//   comparisons and absolute values on floats (no transcendental functions), which are
+//   exactly rounded by IEEE 754. Results are the same across platforms and compilers,
+//   and batch and grid functions return the same values as the single point ones, only
+//   if every operation is rounded to float on its own:
+//     - no reassociation or contraction into FMA: build with -ffp-contract=off and
+//       without -ffast-math (GCC contracts by default in its GNU modes, and Clang within
+//       expressions, as soon as the target has FMA instructions),
+//     - SSE rather than x87 math, which keeps intermediates in extended precision: the
+//       default on x86-64, while 32-bit x86 builds need -msse2 -mfpmath=sse.
+//   Other builds still give valid noise, just not bit-identical to these.
+//
+//
+// Thread-safety:
+//
+//   All functions are pure functions, and can be called from any thread, except for the
+//   ones building and compiling noise graphs. A compiled graph is only read while
+//   evaluating it, so it can be evaluated from many threads at once.
+
+#ifndef MCN_INCLUDE_MC_NOISE_H
+#define MCN_INCLUDE_MC_NOISE_H
+
+// std includes here
+#include "mc_hash_rng.h"
+
+#ifdef MCN_STATIC
+#define MCN_DEF static
+#else
+#ifdef __cplusplus
+#define MCN_DEF extern "C"
+#else
+#define MCN_DEF extern
+#endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ---------------------------------------------------------------------------------------
+// Value noise, in the closed [-1,1] range.
+// ---------------------------------------------------------------------------------------
+MCN_DEF float mcn_value_noise_1d( float x, MCHR_UINT seed );
+MCN_DEF float mcn_value_noise_2d( float x, float y, MCHR_UINT seed );
+MCN_DEF float mcn_value_noise_3d( float x, float y, float z, MCHR_UINT seed );
+MCN_DEF float mcn_value_noise_4d( float x, float y, float z, float w, MCHR_UINT seed );
+
+// ---------------------------------------------------------------------------------------
+// Same functions, evaluated for arrays of points.
+// ---------------------------------------------------------------------------------------
+MCN_DEF void mcn_value_noise_1d_batch( const float* x, MCHR_UINT count, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_value_noise_2d_batch( const float* x, const float* y, MCHR_UINT count, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_value_noise_3d_batch( const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_value_noise_4d_batch( const float* x, const float* y, const float* z, const float* w, MCHR_UINT count, MCHR_UINT seed, float* out );
+
+// ---------------------------------------------------------------------------------------
+// Same functions, evaluated for regular grids of points.
+// ---------------------------------------------------------------------------------------
+MCN_DEF void mcn_value_noise_1d_grid( float start_x, float step_x, MCHR_UINT width, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_value_noise_2d_grid( float start_x, float start_y, float step_x, float step_y, MCHR_UINT width, MCHR_UINT height, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_value_noise_3d_grid( float start_x, float start_y, float start_z, float step_x, float step_y, float step_z, MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT seed, float* out );
+
+// ---------------------------------------------------------------------------------------
+// Gradient (Perlin) noise, in the closed [-1,1] range, with batch and grid versions.
+// ---------------------------------------------------------------------------------------
+MCN_DEF float mcn_gradient_noise_2d( float x, float y, MCHR_UINT seed );
+MCN_DEF float mcn_gradient_noise_3d( float x, float y, float z, MCHR_UINT seed );
+MCN_DEF float mcn_gradient_noise_4d( float x, float y, float z, float w, MCHR_UINT seed );
+
+MCN_DEF void mcn_gradient_noise_2d_batch( const float* x, const float* y, MCHR_UINT count, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_gradient_noise_3d_batch( const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_gradient_noise_4d_batch( const float* x, const float* y, const float* z, const float* w, MCHR_UINT count, MCHR_UINT seed, float* out );
+
+MCN_DEF void mcn_gradient_noise_2d_grid( float start_x, float start_y, float step_x, float step_y, MCHR_UINT width, MCHR_UINT height, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_gradient_noise_3d_grid( float start_x, float start_y, float start_z, float step_x, float step_y, float step_z, MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT seed, float* out );
+
+// ---------------------------------------------------------------------------------------
+// Simplex noise, in the closed [-1,1] range, with batch versions.
+// ---------------------------------------------------------------------------------------
+MCN_DEF float mcn_simplex_noise_2d( float x, float y, MCHR_UINT seed );
+MCN_DEF float mcn_simplex_noise_3d( float x, float y, float z, MCHR_UINT seed );
+MCN_DEF float mcn_simplex_noise_4d( float x, float y, float z, float w, MCHR_UINT seed );
+
+MCN_DEF void mcn_simplex_noise_2d_batch( const float* x, const float* y, MCHR_UINT count, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_simplex_noise_3d_batch( const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_simplex_noise_4d_batch( const float* x, const float* y, const float* z, const float* w, MCHR_UINT count, MCHR_UINT seed, float* out );
+
+// ---------------------------------------------------------------------------------------
+// Cellular (Worley) noise: distances to the closest (F1) and second closest (F2) feature
+//  points, and the id of the cell containing the closest one. Jitter goes from 0 (feature
+//  points at the cell centers) to 1 (anywhere in their cells). The single point functions
+//  return F1, and any of the out pointers can be NULL.
+// ---------------------------------------------------------------------------------------
+typedef enum mcn_distance_t {
+    MCN_DISTANCE_EUCLIDEAN,
+    MCN_DISTANCE_EUCLIDEAN_SQUARED,
+    MCN_DISTANCE_MANHATTAN,
+    MCN_DISTANCE_CHEBYSHEV
+} mcn_distance_t;
+
+MCN_DEF float mcn_cellular_noise_2d( float x, float y, float jitter, mcn_distance_t distance, MCHR_UINT seed, float* out_f2, MCHR_UINT* out_cell_id );
+MCN_DEF float mcn_cellular_noise_3d( float x, float y, float z, float jitter, mcn_distance_t distance, MCHR_UINT seed, float* out_f2, MCHR_UINT* out_cell_id );
+
+MCN_DEF void mcn_cellular_noise_2d_batch( const float* x, const float* y, MCHR_UINT count, float jitter, mcn_distance_t distance, MCHR_UINT seed,
+                                          float* out_f1, float* out_f2, MCHR_UINT* out_cell_id );
+MCN_DEF void mcn_cellular_noise_3d_batch( const float* x, const float* y, const float* z, MCHR_UINT count, float jitter, mcn_distance_t distance, MCHR_UINT seed,
+                                          float* out_f1, float* out_f2, MCHR_UINT* out_cell_id );
+
+MCN_DEF void mcn_cellular_noise_2d_grid( float start_x, float start_y, float step_x, float step_y, MCHR_UINT width, MCHR_UINT height,
+                                         float jitter, mcn_distance_t distance, MCHR_UINT seed, float* out_f1, float* out_f2, MCHR_UINT* out_cell_id );
+MCN_DEF void mcn_cellular_noise_3d_grid( float start_x, float start_y, float start_z, float step_x, float step_y, float step_z,
+                                         MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth,
+                                         float jitter, mcn_distance_t distance, MCHR_UINT seed, float* out_f1, float* out_f2, MCHR_UINT* out_cell_id );
+
+// ---------------------------------------------------------------------------------------
+// Fractal noise: sums of octaves of value, gradient or simplex noise at increasing
+//  frequencies and decreasing amplitudes, optionally shaped into billows or ridges and
+//  sampled through a warped domain. Results are in the closed [-1,1] range. Initialize
+//  the description with `mcn_fractal_init()` and change any of its fields afterwards.
+// ---------------------------------------------------------------------------------------
+typedef enum mcn_noise_type_t {
+    MCN_NOISE_VALUE,
+    MCN_NOISE_GRADIENT,
+    MCN_NOISE_SIMPLEX
+} mcn_noise_type_t;
+
+typedef enum mcn_fractal_type_t {
+    MCN_FRACTAL_FBM,        // sum of octaves
+    MCN_FRACTAL_BILLOW,     // sum of 2|n|-1
+    MCN_FRACTAL_RIDGED      // sum of 2(1-|n|)^2-1
+} mcn_fractal_type_t;
+
+typedef struct mcn_fractal_t {
+    mcn_noise_type_t noise;
+    mcn_fractal_type_t type;
+    MCHR_UINT octaves;
+    float frequency;            // of the first octave
+    float lacunarity;           // frequency multiplier between octaves
+    float gain;                 // amplitude multiplier between octaves
+    float warp_amplitude;       // offset of the domain warp, 0 to disable it
+    float warp_frequency;
+} mcn_fractal_t;
+
+// Sets frequency 1, lacunarity 2, gain 0.5, and no domain warp.
+MCN_DEF void mcn_fractal_init( mcn_fractal_t* fractal, mcn_noise_type_t noise, mcn_fractal_type_t type, MCHR_UINT octaves );
+
+// Seed of an octave. The first octave uses the seed of the fractal, so a fractal with one
+//  octave is the same as its base noise.
+MCN_DEF MCHR_UINT mcn_get_octave_seed( MCHR_UINT seed, MCHR_UINT octave );
+
+MCN_DEF float mcn_fractal_noise_2d( const mcn_fractal_t* fractal, float x, float y, MCHR_UINT seed );
+MCN_DEF float mcn_fractal_noise_3d( const mcn_fractal_t* fractal, float x, float y, float z, MCHR_UINT seed );
+
+MCN_DEF void mcn_fractal_noise_2d_batch( const mcn_fractal_t* fractal, const float* x, const float* y, MCHR_UINT count, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_fractal_noise_3d_batch( const mcn_fractal_t* fractal, const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT seed, float* out );
+
+MCN_DEF void mcn_fractal_noise_2d_grid( const mcn_fractal_t* fractal, float start_x, float start_y, float step_x, float step_y,
+                                        MCHR_UINT width, MCHR_UINT height, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_fractal_noise_3d_grid( const mcn_fractal_t* fractal, float start_x, float start_y, float start_z, float step_x, float step_y, float step_z,
+                                        MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT seed, float* out );
+
+// ---------------------------------------------------------------------------------------
+// Noise graphs: expressions combining the coordinates, constants, noises and element-wise
+//  operations, evaluated in chunks of points that stay in L1 cache instead of one full
+//  buffer per node. Nodes live in an array provided by the caller and are identified by
+//  their index. Adding a node identical to an existing one returns the existing one, and
+//  operations on constants are folded into constants. Compile the graph for its output
+//  node before evaluating it; the evaluation seed is hashed with the seed of every noise
+//  node, so one graph generates any number of worlds.
+// ---------------------------------------------------------------------------------------
+#define MCN_GRAPH_NONE ((MCHR_UINT)-1)
+
+typedef enum mcn_graph_op_t {
+    MCN_GRAPH_X,
+    MCN_GRAPH_Y,
+    MCN_GRAPH_Z,
+    MCN_GRAPH_CONSTANT,
+    MCN_GRAPH_ADD,
+    MCN_GRAPH_SUB,
+    MCN_GRAPH_MUL,
+    MCN_GRAPH_MAD,          // a * b + c, only created by mcn_graph_compile()
+    MCN_GRAPH_MIN,
+    MCN_GRAPH_MAX,
+    MCN_GRAPH_ABS,
+    MCN_GRAPH_MIX,          // a + t * (b - a)
+    MCN_GRAPH_CLAMP,
+    MCN_GRAPH_CURVE,        // piecewise linear
+    MCN_GRAPH_NOISE,
+    MCN_GRAPH_FRACTAL
+} mcn_graph_op_t;
+
+typedef struct mcn_graph_node_t {
+    mcn_graph_op_t op;
+    MCHR_UINT inputs[3];
+    float values[2];            // constant value, or clamp range
+    MCHR_UINT seed;
+    mcn_noise_type_t noise;
+    mcn_fractal_t fractal;
+    const float* curve_x;       // curve points, not copied
+    const float* curve_y;
+    MCHR_UINT curve_count;
+    // set by mcn_graph_compile()
+    mcn_graph_op_t kernel_op;
+    MCHR_UINT kernel_inputs[3];
+    MCHR_UINT uses;
+    MCHR_UINT buffer;
+    int live;
+} mcn_graph_node_t;
+
+typedef struct mcn_graph_t {
+    mcn_graph_node_t* nodes;
+    MCHR_UINT capacity;
+    MCHR_UINT count;
+    MCHR_UINT output;           // MCN_GRAPH_NONE until compiled
+    MCHR_UINT buffer_count;
+    int uses_z;
+} mcn_graph_t;
+
+MCN_DEF void mcn_graph_init( mcn_graph_t* graph, mcn_graph_node_t* nodes, MCHR_UINT capacity );
+
+// Node builders. They return the index of the node, or MCN_GRAPH_NONE if the array is full.
+MCN_DEF MCHR_UINT mcn_graph_x( mcn_graph_t* graph );
+MCN_DEF MCHR_UINT mcn_graph_y( mcn_graph_t* graph );
+MCN_DEF MCHR_UINT mcn_graph_z( mcn_graph_t* graph );
+MCN_DEF MCHR_UINT mcn_graph_constant( mcn_graph_t* graph, float value );
+MCN_DEF MCHR_UINT mcn_graph_add( mcn_graph_t* graph, MCHR_UINT a, MCHR_UINT b );
+MCN_DEF MCHR_UINT mcn_graph_sub( mcn_graph_t* graph, MCHR_UINT a, MCHR_UINT b );
+MCN_DEF MCHR_UINT mcn_graph_mul( mcn_graph_t* graph, MCHR_UINT a, MCHR_UINT b );
+MCN_DEF MCHR_UINT mcn_graph_min( mcn_graph_t* graph, MCHR_UINT a, MCHR_UINT b );
+MCN_DEF MCHR_UINT mcn_graph_max( mcn_graph_t* graph, MCHR_UINT a, MCHR_UINT b );
+MCN_DEF MCHR_UINT mcn_graph_abs( mcn_graph_t* graph, MCHR_UINT a );
+MCN_DEF MCHR_UINT mcn_graph_mix( mcn_graph_t* graph, MCHR_UINT a, MCHR_UINT b, MCHR_UINT t );
+MCN_DEF MCHR_UINT mcn_graph_clamp( mcn_graph_t* graph, MCHR_UINT a, float min, float max );
+// Maps `a` through the piecewise linear curve going through `count` points sorted by x,
+//  clamping it to the first and last points. Two points with the same x make a step,
+//  whose upper y is taken from that x on. The points must outlive the graph.
+MCN_DEF MCHR_UINT mcn_graph_curve( mcn_graph_t* graph, MCHR_UINT a, const float* points_x, const float* points_y, MCHR_UINT count );
+MCN_DEF MCHR_UINT mcn_graph_noise_2d( mcn_graph_t* graph, mcn_noise_type_t noise, MCHR_UINT x, MCHR_UINT y, MCHR_UINT seed );
+MCN_DEF MCHR_UINT mcn_graph_noise_3d( mcn_graph_t* graph, mcn_noise_type_t noise, MCHR_UINT x, MCHR_UINT y, MCHR_UINT z, MCHR_UINT seed );
+MCN_DEF MCHR_UINT mcn_graph_fractal_2d( mcn_graph_t* graph, const mcn_fractal_t* fractal, MCHR_UINT x, MCHR_UINT y, MCHR_UINT seed );
+MCN_DEF MCHR_UINT mcn_graph_fractal_3d( mcn_graph_t* graph, const mcn_fractal_t* fractal, MCHR_UINT x, MCHR_UINT y, MCHR_UINT z, MCHR_UINT seed );
+
+// Prepares the graph to evaluate `output`. Returns 0 if that needs more than
+//  MCN_GRAPH_MAX_BUFFERS chunk buffers at once.
+MCN_DEF int mcn_graph_compile( mcn_graph_t* graph, MCHR_UINT output );
+
+// The noise of a node is seeded with `mchr_get_1d_hash_uint(node_seed, seed)`. The z
+//  coordinates can be NULL if the output doesn't depend on them.
+MCN_DEF float mcn_graph_eval( const mcn_graph_t* graph, float x, float y, float z, MCHR_UINT seed );
+MCN_DEF void mcn_graph_eval_batch( const mcn_graph_t* graph, const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_graph_eval_2d_grid( const mcn_graph_t* graph, float start_x, float start_y, float step_x, float step_y,
+                                     MCHR_UINT width, MCHR_UINT height, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_graph_eval_3d_grid( const mcn_graph_t* graph, float start_x, float start_y, float start_z, float step_x, float step_y, float step_z,
+                                     MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT seed, float* out );
+
+// ---------------------------------------------------------------------------------------
+// Bounds: conservative ranges of the values a noise takes inside an axis-aligned box, to
+//  skip boxes whose values are known in advance (e.g. chunks entirely above or below a
+//  density threshold). They come from the lattice points near the box, so they're tight
+//  for boxes up to a few lattice cells wide; larger boxes get the full range of the noise.
+//  Cellular bounds are for F1. Graph bounds need an array of 2 floats per graph node.
+// ---------------------------------------------------------------------------------------
+MCN_DEF void mcn_value_noise_2d_bounds( float min_x, float min_y, float max_x, float max_y, MCHR_UINT seed, float* out_min, float* out_max );
+MCN_DEF void mcn_value_noise_3d_bounds( float min_x, float min_y, float min_z, float max_x, float max_y, float max_z, MCHR_UINT seed,
+                                        float* out_min, float* out_max );
+MCN_DEF void mcn_gradient_noise_2d_bounds( float min_x, float min_y, float max_x, float max_y, MCHR_UINT seed, float* out_min, float* out_max );
+MCN_DEF void mcn_gradient_noise_3d_bounds( float min_x, float min_y, float min_z, float max_x, float max_y, float max_z, MCHR_UINT seed,
+                                           float* out_min, float* out_max );
+MCN_DEF void mcn_simplex_noise_2d_bounds( float min_x, float min_y, float max_x, float max_y, MCHR_UINT seed, float* out_min, float* out_max );
+MCN_DEF void mcn_simplex_noise_3d_bounds( float min_x, float min_y, float min_z, float max_x, float max_y, float max_z, MCHR_UINT seed,
+                                          float* out_min, float* out_max );
+MCN_DEF void mcn_cellular_noise_2d_bounds( float min_x, float min_y, float max_x, float max_y, float jitter, mcn_distance_t distance, MCHR_UINT seed,
+                                           float* out_min, float* out_max );
+MCN_DEF void mcn_cellular_noise_3d_bounds( float min_x, float min_y, float min_z, float max_x, float max_y, float max_z,
+                                           float jitter, mcn_distance_t distance, MCHR_UINT seed, float* out_min, float* out_max );
+MCN_DEF void mcn_fractal_noise_2d_bounds( const mcn_fractal_t* fractal, float min_x, float min_y, float max_x, float max_y, MCHR_UINT seed,
+                                          float* out_min, float* out_max );
+MCN_DEF void mcn_fractal_noise_3d_bounds( const mcn_fractal_t* fractal, float min_x, float min_y, float min_z, float max_x, float max_y, float max_z,
+                                          MCHR_UINT seed, float* out_min, float* out_max );
+MCN_DEF void mcn_graph_bounds_2d( const mcn_graph_t* graph, float min_x, float min_y, float max_x, float max_y, MCHR_UINT seed,
+                                  float* node_bounds, float* out_min, float* out_max );
+MCN_DEF void mcn_graph_bounds_3d( const mcn_graph_t* graph, float min_x, float min_y, float min_z, float max_x, float max_y, float max_z,
+                                  MCHR_UINT seed, float* node_bounds, float* out_min, float* out_max );
+
+// ---------------------------------------------------------------------------------------
+// Noise with derivatives: the same values as the functions above, along with their
+//  partial derivatives along each axis, computed analytically in the same pass.
+// ---------------------------------------------------------------------------------------
+MCN_DEF float mcn_value_noise_2d_deriv( float x, float y, MCHR_UINT seed, float* out_dx, float* out_dy );
+MCN_DEF float mcn_value_noise_3d_deriv( float x, float y, float z, MCHR_UINT seed, float* out_dx, float* out_dy, float* out_dz );
+MCN_DEF float mcn_gradient_noise_2d_deriv( float x, float y, MCHR_UINT seed, float* out_dx, float* out_dy );
+MCN_DEF float mcn_gradient_noise_3d_deriv( float x, float y, float z, MCHR_UINT seed, float* out_dx, float* out_dy, float* out_dz );
+MCN_DEF float mcn_simplex_noise_2d_deriv( float x, float y, MCHR_UINT seed, float* out_dx, float* out_dy );
+MCN_DEF float mcn_simplex_noise_3d_deriv( float x, float y, float z, MCHR_UINT seed, float* out_dx, float* out_dy, float* out_dz );
+MCN_DEF float mcn_fractal_noise_2d_deriv( const mcn_fractal_t* fractal, float x, float y, MCHR_UINT seed, float* out_dx, float* out_dy );
+MCN_DEF float mcn_fractal_noise_3d_deriv( const mcn_fractal_t* fractal, float x, float y, float z, MCHR_UINT seed,
+                                          float* out_dx, float* out_dy, float* out_dz );
+
+MCN_DEF void mcn_value_noise_2d_deriv_batch( const float* x, const float* y, MCHR_UINT count, MCHR_UINT seed, float* out, float* out_dx, float* out_dy );
+MCN_DEF void mcn_value_noise_3d_deriv_batch( const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT seed,
+                                             float* out, float* out_dx, float* out_dy, float* out_dz );
+MCN_DEF void mcn_gradient_noise_2d_deriv_batch( const float* x, const float* y, MCHR_UINT count, MCHR_UINT seed, float* out, float* out_dx, float* out_dy );
+MCN_DEF void mcn_gradient_noise_3d_deriv_batch( const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT seed,
+                                                float* out, float* out_dx, float* out_dy, float* out_dz );
+MCN_DEF void mcn_simplex_noise_2d_deriv_batch( const float* x, const float* y, MCHR_UINT count, MCHR_UINT seed, float* out, float* out_dx, float* out_dy );
+MCN_DEF void mcn_simplex_noise_3d_deriv_batch( const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT seed,
+                                               float* out, float* out_dx, float* out_dy, float* out_dz );
+MCN_DEF void mcn_fractal_noise_2d_deriv_batch( const mcn_fractal_t* fractal, const float* x, const float* y, MCHR_UINT count, MCHR_UINT seed,
+                                               float* out, float* out_dx, float* out_dy );
+MCN_DEF void mcn_fractal_noise_3d_deriv_batch( const mcn_fractal_t* fractal, const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT seed,
+                                               float* out, float* out_dx, float* out_dy, float* out_dz );
+
+// ---------------------------------------------------------------------------------------
+// Curl noise: divergence-free velocity fields, the curl of a potential made of gradient
+//  noise (or of the given fractal noise), with one noise per component in 3D.
+// ---------------------------------------------------------------------------------------
+MCN_DEF void mcn_curl_noise_2d( float x, float y, MCHR_UINT seed, float* out_vx, float* out_vy );
+MCN_DEF void mcn_curl_noise_3d( float x, float y, float z, MCHR_UINT seed, float* out_vx, float* out_vy, float* out_vz );
+MCN_DEF void mcn_fractal_curl_noise_2d( const mcn_fractal_t* fractal, float x, float y, MCHR_UINT seed, float* out_vx, float* out_vy );
+MCN_DEF void mcn_fractal_curl_noise_3d( const mcn_fractal_t* fractal, float x, float y, float z, MCHR_UINT seed,
+                                        float* out_vx, float* out_vy, float* out_vz );
+
+MCN_DEF void mcn_curl_noise_2d_batch( const float* x, const float* y, MCHR_UINT count, MCHR_UINT seed, float* out_vx, float* out_vy );
+MCN_DEF void mcn_curl_noise_3d_batch( const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT seed,
+                                      float* out_vx, float* out_vy, float* out_vz );
+MCN_DEF void mcn_fractal_curl_noise_2d_batch( const mcn_fractal_t* fractal, const float* x, const float* y, MCHR_UINT count, MCHR_UINT seed,
+                                              float* out_vx, float* out_vy );
+MCN_DEF void mcn_fractal_curl_noise_3d_batch( const mcn_fractal_t* fractal, const float* x, const float* y, const float* z, MCHR_UINT count,
+                                              MCHR_UINT seed, float* out_vx, float* out_vy, float* out_vz );
+
+// ---------------------------------------------------------------------------------------
+// Periodic noise: noise that repeats every `period` lattice cells along each axis, for
+//  tileable textures and looping animations. A period of 0 doesn't repeat along that axis.
+//  Fractal periods are in input units, and must give whole cells at every octave.
+// ---------------------------------------------------------------------------------------
+MCN_DEF float mcn_value_noise_2d_periodic( float x, float y, MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT seed );
+MCN_DEF float mcn_value_noise_3d_periodic( float x, float y, float z, MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT period_z, MCHR_UINT seed );
+MCN_DEF float mcn_value_noise_4d_periodic( float x, float y, float z, float w, MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT period_z,
+                                           MCHR_UINT period_w, MCHR_UINT seed );
+MCN_DEF float mcn_gradient_noise_2d_periodic( float x, float y, MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT seed );
+MCN_DEF float mcn_gradient_noise_3d_periodic( float x, float y, float z, MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT period_z, MCHR_UINT seed );
+MCN_DEF float mcn_gradient_noise_4d_periodic( float x, float y, float z, float w, MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT period_z,
+                                              MCHR_UINT period_w, MCHR_UINT seed );
+MCN_DEF float mcn_cellular_noise_2d_periodic( float x, float y, MCHR_UINT period_x, MCHR_UINT period_y, float jitter, mcn_distance_t distance,
+                                              MCHR_UINT seed, float* out_f2, MCHR_UINT* out_cell_id );
+MCN_DEF float mcn_cellular_noise_3d_periodic( float x, float y, float z, MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT period_z, float jitter,
+                                              mcn_distance_t distance, MCHR_UINT seed, float* out_f2, MCHR_UINT* out_cell_id );
+MCN_DEF float mcn_fractal_noise_2d_periodic( const mcn_fractal_t* fractal, float x, float y, MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT seed );
+MCN_DEF float mcn_fractal_noise_3d_periodic( const mcn_fractal_t* fractal, float x, float y, float z, MCHR_UINT period_x, MCHR_UINT period_y,
+                                             MCHR_UINT period_z, MCHR_UINT seed );
+
+MCN_DEF void mcn_value_noise_2d_periodic_batch( const float* x, const float* y, MCHR_UINT count, MCHR_UINT period_x, MCHR_UINT period_y,
+                                                MCHR_UINT seed, float* out );
+MCN_DEF void mcn_value_noise_3d_periodic_batch( const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT period_x,
+                                                MCHR_UINT period_y, MCHR_UINT period_z, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_value_noise_4d_periodic_batch( const float* x, const float* y, const float* z, const float* w, MCHR_UINT count, MCHR_UINT period_x,
+                                                MCHR_UINT period_y, MCHR_UINT period_z, MCHR_UINT period_w, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_gradient_noise_2d_periodic_batch( const float* x, const float* y, MCHR_UINT count, MCHR_UINT period_x, MCHR_UINT period_y,
+                                                   MCHR_UINT seed, float* out );
+MCN_DEF void mcn_gradient_noise_3d_periodic_batch( const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT period_x,
+                                                   MCHR_UINT period_y, MCHR_UINT period_z, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_gradient_noise_4d_periodic_batch( const float* x, const float* y, const float* z, const float* w, MCHR_UINT count,
+                                                   MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT period_z, MCHR_UINT period_w, MCHR_UINT seed,
+                                                   float* out );
+MCN_DEF void mcn_cellular_noise_2d_periodic_batch( const float* x, const float* y, MCHR_UINT count, MCHR_UINT period_x, MCHR_UINT period_y,
+                                                   float jitter, mcn_distance_t distance, MCHR_UINT seed, float* out_f1, float* out_f2,
+                                                   MCHR_UINT* out_cell_id );
+MCN_DEF void mcn_cellular_noise_3d_periodic_batch( const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT period_x,
+                                                   MCHR_UINT period_y, MCHR_UINT period_z, float jitter, mcn_distance_t distance, MCHR_UINT seed,
+                                                   float* out_f1, float* out_f2, MCHR_UINT* out_cell_id );
+MCN_DEF void mcn_fractal_noise_2d_periodic_batch( const mcn_fractal_t* fractal, const float* x, const float* y, MCHR_UINT count, MCHR_UINT period_x,
+                                                  MCHR_UINT period_y, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_fractal_noise_3d_periodic_batch( const mcn_fractal_t* fractal, const float* x, const float* y, const float* z, MCHR_UINT count,
+                                                  MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT period_z, MCHR_UINT seed, float* out );
+
+MCN_DEF void mcn_value_noise_2d_periodic_grid( float start_x, float start_y, float step_x, float step_y, MCHR_UINT width, MCHR_UINT height,
+                                               MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_value_noise_3d_periodic_grid( float start_x, float start_y, float start_z, float step_x, float step_y, float step_z,
+                                               MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT period_x, MCHR_UINT period_y,
+                                               MCHR_UINT period_z, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_gradient_noise_2d_periodic_grid( float start_x, float start_y, float step_x, float step_y, MCHR_UINT width, MCHR_UINT height,
+                                                  MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_gradient_noise_3d_periodic_grid( float start_x, float start_y, float start_z, float step_x, float step_y, float step_z,
+                                                  MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT period_x, MCHR_UINT period_y,
+                                                  MCHR_UINT period_z, MCHR_UINT seed, float* out );
+MCN_DEF void mcn_cellular_noise_2d_periodic_grid( float start_x, float start_y, float step_x, float step_y, MCHR_UINT width, MCHR_UINT height,
+                                                  MCHR_UINT period_x, MCHR_UINT period_y, float jitter, mcn_distance_t distance, MCHR_UINT seed,
+                                                  float* out_f1, float* out_f2, MCHR_UINT* out_cell_id );
+MCN_DEF void mcn_cellular_noise_3d_periodic_grid( float start_x, float start_y, float start_z, float step_x, float step_y, float step_z,
+                                                  MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT period_x, MCHR_UINT period_y,
+                                                  MCHR_UINT period_z, float jitter, mcn_distance_t distance, MCHR_UINT seed, float* out_f1,
+                                                  float* out_f2, MCHR_UINT* out_cell_id );
+MCN_DEF void mcn_fractal_noise_2d_periodic_grid( const mcn_fractal_t* fractal, float start_x, float start_y, float step_x, float step_y,
+                                                 MCHR_UINT width, MCHR_UINT height, MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT seed,
+                                                 float* out );
+MCN_DEF void mcn_fractal_noise_3d_periodic_grid( const mcn_fractal_t* fractal, float start_x, float start_y, float start_z, float step_x,
+                                                 float step_y, float step_z, MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT period_x,
+                                                 MCHR_UINT period_y, MCHR_UINT period_z, MCHR_UINT seed, float* out );
+
+#ifdef __cplusplus
+}
+#endif
+
+// END OF HEDER FILE ---------------------------------------------------------------------
+#endif // MCN_INCLUDE_MC_NOISE_H
+
+
+#if defined(MCN_IMPLEMENTATION) && !defined(MCN_IMPLEMENTATION_INCLUDED)
+#define MCN_IMPLEMENTATION_INCLUDED
+
+// std includes here
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+// ---------------------------------------------------------------------------------------
+// Batch functions work on chunks of points small enough to keep all intermediate arrays
+//  on the stack (and in L1 cache). Grid functions cache the hashes of the lattice rows
+//  crossed by a chunk, as long as they fit in MCN_ROW_CACHE entries (i.e. when the grid
+//  step is not much larger than the lattice spacing).
+// ---------------------------------------------------------------------------------------
+#define MCN_CHUNK 64
+#define MCN_ROW_CACHE (2 * MCN_CHUNK + 2)
+
+// Largest number of chunk buffers a noise graph can use at once.
+#ifndef MCN_GRAPH_MAX_BUFFERS
+#define MCN_GRAPH_MAX_BUFFERS 32
+#endif
+
+// Largest number of lattice points visited to bound a noise in a box. Larger boxes get the
+//  full range of the noise.
+#ifndef MCN_BOUNDS_MAX_POINTS
+#define MCN_BOUNDS_MAX_POINTS 4096
+#endif
+
+// ---------------------------------------------------------------------------------------
+// Private helper functions, written without branches so they can be vectorized.
+// ---------------------------------------------------------------------------------------
+static MCHR_INT mcn_priv_floor(float value) {
+    MCHR_INT truncated = (MCHR_INT)value;
+    return truncated - (value < (float)truncated);
+}
+
+static float mcn_priv_smoothstep(float t) {
+    return t * t * (3.0f - 2.0f * t);
+}
+
+static float mcn_priv_smoothstep_deriv(float t) {
+    return 6.0f * t * (1.0f - t);
+}
+
+static float mcn_priv_lerp(float a, float b, float t) {
+    return a + t * (b - a);
+}
+
+// Maps a hash to an equidistant float in the closed [-1,1] range.
+static float mcn_priv_hash_to_signed(MCHR_UINT hash) {
+    return (float)(hash >> 8) * (2.0f / 16777215.0f) - 1.0f;
+}
+
+// ---------------------------------------------------------------------------------------
+// Value noise, single point.
+// ---------------------------------------------------------------------------------------
+MCN_DEF float mcn_value_noise_1d( float x, MCHR_UINT seed ) {
+    MCHR_INT ix = mcn_priv_floor(x);
+    float sx = mcn_priv_smoothstep(x - (float)ix);
+    float v0 = mcn_priv_hash_to_signed(mchr_get_1d_hash_uint(ix, seed));
+    float v1 = mcn_priv_hash_to_signed(mchr_get_1d_hash_uint(ix + 1, seed));
+    return mcn_priv_lerp(v0, v1, sx);
+}
+
+MCN_DEF float mcn_value_noise_2d( float x, float y, MCHR_UINT seed ) {
+    MCHR_INT ix = mcn_priv_floor(x);
+    MCHR_INT iy = mcn_priv_floor(y);
+    float sx = mcn_priv_smoothstep(x - (float)ix);
+    float sy = mcn_priv_smoothstep(y - (float)iy);
+    float v00 = mcn_priv_hash_to_signed(mchr_get_2d_hash_uint(ix, iy, seed));
+    float v10 = mcn_priv_hash_to_signed(mchr_get_2d_hash_uint(ix + 1, iy, seed));
+    float v01 = mcn_priv_hash_to_signed(mchr_get_2d_hash_uint(ix, iy + 1, seed));
+    float v11 = mcn_priv_hash_to_signed(mchr_get_2d_hash_uint(ix + 1, iy + 1, seed));
+    return mcn_priv_lerp(mcn_priv_lerp(v00, v10, sx), mcn_priv_lerp(v01, v11, sx), sy);
+}
+
+MCN_DEF float mcn_value_noise_3d( float x, float y, float z, MCHR_UINT seed ) {
+    MCHR_INT ix = mcn_priv_floor(x);
+    MCHR_INT iy = mcn_priv_floor(y);
+    MCHR_INT iz = mcn_priv_floor(z);
+    float sx = mcn_priv_smoothstep(x - (float)ix);
+    float sy = mcn_priv_smoothstep(y - (float)iy);
+    float sz = mcn_priv_smoothstep(z - (float)iz);
+
+    float result[2];
+    for (MCHR_INT k = 0; k < 2; ++k) {
+        float v00 = mcn_priv_hash_to_signed(mchr_get_3d_hash_uint(ix, iy, iz + k, seed));
+        float v10 = mcn_priv_hash_to_signed(mchr_get_3d_hash_uint(ix + 1, iy, iz + k, seed));
+        float v01 = mcn_priv_hash_to_signed(mchr_get_3d_hash_uint(ix, iy + 1, iz + k, seed));
+        float v11 = mcn_priv_hash_to_signed(mchr_get_3d_hash_uint(ix + 1, iy + 1, iz + k, seed));
+        result[k] = mcn_priv_lerp(mcn_priv_lerp(v00, v10, sx), mcn_priv_lerp(v01, v11, sx), sy);
+    }
+    return mcn_priv_lerp(result[0], result[1], sz);
+}
+
+MCN_DEF float mcn_value_noise_4d( float x, float y, float z, float w, MCHR_UINT seed ) {
+    MCHR_INT ix = mcn_priv_floor(x);
+    MCHR_INT iy = mcn_priv_floor(y);
+    MCHR_INT iz = mcn_priv_floor(z);
+    MCHR_INT iw = mcn_priv_floor(w);
+    float sx = mcn_priv_smoothstep(x - (float)ix);
+    float sy = mcn_priv_smoothstep(y - (float)iy);
+    float sz = mcn_priv_smoothstep(z - (float)iz);
+    float sw = mcn_priv_smoothstep(w - (float)iw);
+
+    float result[2];
+    for (MCHR_INT l = 0; l < 2; ++l) {
+        float plane[2];
+        for (MCHR_INT k = 0; k < 2; ++k) {
+            float v00 = mcn_priv_hash_to_signed(mchr_get_4d_hash_uint(ix, iy, iz + k, iw + l, seed));
+            float v10 = mcn_priv_hash_to_signed(mchr_get_4d_hash_uint(ix + 1, iy, iz + k, iw + l, seed));
+            float v01 = mcn_priv_hash_to_signed(mchr_get_4d_hash_uint(ix, iy + 1, iz + k, iw + l, seed));
+            float v11 = mcn_priv_hash_to_signed(mchr_get_4d_hash_uint(ix + 1, iy + 1, iz + k, iw + l, seed));
+            plane[k] = mcn_priv_lerp(mcn_priv_lerp(v00, v10, sx), mcn_priv_lerp(v01, v11, sx), sy);
+        }
+        result[l] = mcn_priv_lerp(plane[0], plane[1], sz);
+    }
+    return mcn_priv_lerp(result[0], result[1], sw);
+}
+
+// ---------------------------------------------------------------------------------------
+// Gradient noise, single point. Each lattice point selects one of a small set of gradient
+//  vectors with the high bits of its hash (16 directions in 2D, Perlin's 12 cube edges
+//  padded to 16 in 3D, and the 32 tesseract edges in 4D), so the dot products need no
+//  branches. Results are scaled by the inverse of the largest value the gradient set can
+//  reach, so they never leave the [-1,1] range and get close to its ends.
+// ---------------------------------------------------------------------------------------
+static const float MCN_GRADIENT_2D_X[16] = { 1.0f, 0.92387953f, 0.70710678f, 0.38268343f, 0.0f, -0.38268343f, -0.70710678f, -0.92387953f,
+                                             -1.0f, -0.92387953f, -0.70710678f, -0.38268343f, 0.0f, 0.38268343f, 0.70710678f, 0.92387953f };
+static const float MCN_GRADIENT_2D_Y[16] = { 0.0f, 0.38268343f, 0.70710678f, 0.92387953f, 1.0f, 0.92387953f, 0.70710678f, 0.38268343f,
+                                             0.0f, -0.38268343f, -0.70710678f, -0.92387953f, -1.0f, -0.92387953f, -0.70710678f, -0.38268343f };
+
+static const float MCN_GRADIENT_3D_X[16] = { 1, -1,  1, -1,  1, -1,  1, -1,  0,  0,  0,  0,  1,  0, -1,  0 };
+static const float MCN_GRADIENT_3D_Y[16] = { 1,  1, -1, -1,  0,  0,  0,  0,  1, -1,  1, -1,  1, -1,  1, -1 };
+static const float MCN_GRADIENT_3D_Z[16] = { 0,  0,  0,  0,  1,  1, -1, -1,  1,  1, -1, -1,  0,  1,  0, -1 };
+
+static const float MCN_GRADIENT_4D_X[32] = { 0, 0, 0, 0, 0, 0, 0, 0,  1, -1,  1, -1,  1, -1,  1, -1,  1, -1,  1, -1,  1, -1,  1, -1,  1, -1,  1, -1,  1, -1,  1, -1 };
+static const float MCN_GRADIENT_4D_Y[32] = { 1, -1,  1, -1,  1, -1,  1, -1,  0, 0, 0, 0, 0, 0, 0, 0,  1,  1, -1, -1,  1,  1, -1, -1,  1,  1, -1, -1,  1,  1, -1, -1 };
+static const float MCN_GRADIENT_4D_Z[32] = { 1,  1, -1, -1,  1,  1, -1, -1,  1,  1, -1, -1,  1,  1, -1, -1,  0, 0, 0, 0, 0, 0, 0, 0,  1,  1,  1,  1, -1, -1, -1, -1 };
+static const float MCN_GRADIENT_4D_W[32] = { 1,  1,  1,  1, -1, -1, -1, -1,  1,  1,  1,  1, -1, -1, -1, -1,  1,  1,  1,  1, -1, -1, -1, -1,  0, 0, 0, 0, 0, 0, 0, 0 };
+
+// 1 / the largest possible value for the gradient sets above, indexed by dimension. As each
+//  corner picks its gradient independently, that is the maximum over the cell of the sum
+//  of the corner weights times the largest dot product of a gradient with the offset to
+//  the corner: 1/sqrt(2) at the center in 2D, ~1.0363538 in 3D and ~1.5365823 in 4D (off
+//  center, found numerically). The 3D and 4D factors are rounded down a little to keep
+//  float rounding inside the range.
+static const float MCN_GRADIENT_SCALE[5] = { 0.0f, 0.0f, 1.41421356f, 0.9649f, 0.6507f };
+
+static float mcn_priv_fade(float t) {
+    return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+static float mcn_priv_fade_deriv(float t) {
+    return 30.0f * t * t * (t * (t - 2.0f) + 1.0f);
+}
+
+static float mcn_priv_gradient_2d(MCHR_UINT hash, float x, float y) {
+    MCHR_UINT g = hash >> 28;
+    return MCN_GRADIENT_2D_X[g] * x + MCN_GRADIENT_2D_Y[g] * y;
+}
+
+static float mcn_priv_gradient_3d(MCHR_UINT hash, float x, float y, float z) {
+    MCHR_UINT g = hash >> 28;
+    return MCN_GRADIENT_3D_X[g] * x + MCN_GRADIENT_3D_Y[g] * y + MCN_GRADIENT_3D_Z[g] * z;
+}
+
+static float mcn_priv_gradient_4d(MCHR_UINT hash, float x, float y, float z, float w) {
+    MCHR_UINT g = hash >> 27;
+    return MCN_GRADIENT_4D_X[g] * x + MCN_GRADIENT_4D_Y[g] * y + MCN_GRADIENT_4D_Z[g] * z + MCN_GRADIENT_4D_W[g] * w;
+}
+
+MCN_DEF float mcn_gradient_noise_2d( float x, float y, MCHR_UINT seed ) {
+    MCHR_INT ix = mcn_priv_floor(x);
+    MCHR_INT iy = mcn_priv_floor(y);
+    float fx = x - (float)ix;
+    float fy = y - (float)iy;
+    float sx = mcn_priv_fade(fx);
+    float sy = mcn_priv_fade(fy);
+    float g00 = mcn_priv_gradient_2d(mchr_get_2d_hash_uint(ix, iy, seed), fx, fy);
+    float g10 = mcn_priv_gradient_2d(mchr_get_2d_hash_uint(ix + 1, iy, seed), fx - 1.0f, fy);
+    float g01 = mcn_priv_gradient_2d(mchr_get_2d_hash_uint(ix, iy + 1, seed), fx, fy - 1.0f);
+    float g11 = mcn_priv_gradient_2d(mchr_get_2d_hash_uint(ix + 1, iy + 1, seed), fx - 1.0f, fy - 1.0f);
+    return mcn_priv_lerp(mcn_priv_lerp(g00, g10, sx), mcn_priv_lerp(g01, g11, sx), sy) * MCN_GRADIENT_SCALE[2];
+}
+
+MCN_DEF float mcn_gradient_noise_3d( float x, float y, float z, MCHR_UINT seed ) {
+    MCHR_INT ix = mcn_priv_floor(x);
+    MCHR_INT iy = mcn_priv_floor(y);
+    MCHR_INT iz = mcn_priv_floor(z);
+    float fx = x - (float)ix;
+    float fy = y - (float)iy;
+    float fz = z - (float)iz;
+    float sx = mcn_priv_fade(fx);
+    float sy = mcn_priv_fade(fy);
+    float sz = mcn_priv_fade(fz);
+
+    float result[2];
+    for (MCHR_INT k = 0; k < 2; ++k) {
+        float dz = fz - (float)k;
+        float g00 = mcn_priv_gradient_3d(mchr_get_3d_hash_uint(ix, iy, iz + k, seed), fx, fy, dz);
+        float g10 = mcn_priv_gradient_3d(mchr_get_3d_hash_uint(ix + 1, iy, iz + k, seed), fx - 1.0f, fy, dz);
+        float g01 = mcn_priv_gradient_3d(mchr_get_3d_hash_uint(ix, iy + 1, iz + k, seed), fx, fy - 1.0f, dz);
+        float g11 = mcn_priv_gradient_3d(mchr_get_3d_hash_uint(ix + 1, iy + 1, iz + k, seed), fx - 1.0f, fy - 1.0f, dz);
+        result[k] = mcn_priv_lerp(mcn_priv_lerp(g00, g10, sx), mcn_priv_lerp(g01, g11, sx), sy);
+    }
+    return mcn_priv_lerp(result[0], result[1], sz) * MCN_GRADIENT_SCALE[3];
+}
+
+MCN_DEF float mcn_gradient_noise_4d( float x, float y, float z, float w, MCHR_UINT seed ) {
+    MCHR_INT ix = mcn_priv_floor(x);
+    MCHR_INT iy = mcn_priv_floor(y);
+    MCHR_INT iz = mcn_priv_floor(z);
+    MCHR_INT iw = mcn_priv_floor(w);
+    float fx = x - (float)ix;
+    float fy = y - (float)iy;
+    float fz = z - (float)iz;
+    float fw = w - (float)iw;
+    float sx = mcn_priv_fade(fx);
+    float sy = mcn_priv_fade(fy);
+    float sz = mcn_priv_fade(fz);
+    float sw = mcn_priv_fade(fw);
+
+    float result[2];
+    for (MCHR_INT l = 0; l < 2; ++l) {
+        float dw = fw - (float)l;
+        float plane[2];
+        for (MCHR_INT k = 0; k < 2; ++k) {
+            float dz = fz - (float)k;
+            float g00 = mcn_priv_gradient_4d(mchr_get_4d_hash_uint(ix, iy, iz + k, iw + l, seed), fx, fy, dz, dw);
+            float g10 = mcn_priv_gradient_4d(mchr_get_4d_hash_uint(ix + 1, iy, iz + k, iw + l, seed), fx - 1.0f, fy, dz, dw);
+            float g01 = mcn_priv_gradient_4d(mchr_get_4d_hash_uint(ix, iy + 1, iz + k, iw + l, seed), fx, fy - 1.0f, dz, dw);
+            float g11 = mcn_priv_gradient_4d(mchr_get_4d_hash_uint(ix + 1, iy + 1, iz + k, iw + l, seed), fx - 1.0f, fy - 1.0f, dz, dw);
+            plane[k] = mcn_priv_lerp(mcn_priv_lerp(g00, g10, sx), mcn_priv_lerp(g01, g11, sx), sy);
+        }
+        result[l] = mcn_priv_lerp(plane[0], plane[1], sz);
+    }
+    return mcn_priv_lerp(result[0], result[1], sw) * MCN_GRADIENT_SCALE[4];
+}
+
+// ---------------------------------------------------------------------------------------
+// Value and gradient noise share the batch and grid code, which only differs in the
+//  interpolation curve and in how the contribution of a cell corner is computed.
+// ---------------------------------------------------------------------------------------
+typedef enum mcn_priv_lattice_kind_t {
+    MCN_PRIV_VALUE,
+    MCN_PRIV_GRADIENT
+} mcn_priv_lattice_kind_t;
+
+static float mcn_priv_lattice_weight(mcn_priv_lattice_kind_t kind, float t) {
+    return (kind == MCN_PRIV_VALUE) ? mcn_priv_smoothstep(t) : mcn_priv_fade(t);
+}
+
+static float mcn_priv_lattice_scale(mcn_priv_lattice_kind_t kind, MCHR_UINT dims) {
+    return (kind == MCN_PRIV_VALUE) ? 1.0f : MCN_GRADIENT_SCALE[dims];
+}
+
+// ---------------------------------------------------------------------------------------
+// Periodic noise wraps lattice coordinates into [0, period) before hashing them, while the
+//  offsets inside the cells stay unwrapped. A period of 0 leaves a coordinate unwrapped.
+//  The quotient is estimated in double precision and corrected afterwards, so wrapping
+//  vectorizes without integer divisions.
+// ---------------------------------------------------------------------------------------
+static MCHR_INT mcn_priv_wrap(MCHR_INT cell, MCHR_INT period, double inv_period) {
+    MCHR_INT wrapped = cell - (MCHR_INT)((double)cell * inv_period) * period;
+    wrapped += (wrapped < 0) ? period : 0;
+    wrapped -= (wrapped >= period) ? period : 0;
+    return wrapped;
+}
+
+static void mcn_priv_wrap_lattice(MCHR_INT* cells, MCHR_UINT count, MCHR_UINT period) {
+    if (period == 0)
+        return;
+    const MCHR_INT p = (MCHR_INT)period;
+    const double inv_period = 1.0 / (double)period;
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        cells[i] = mcn_priv_wrap(cells[i], p, inv_period);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Lattice noise, arrays of points. Each chunk computes the lattice cell and interpolation
+//  weights of all points first, then hashes one cell corner for all points at a time
+//  (through the batch hashes in mc_hash_rng.h), accumulating the interpolation as it goes.
+// ---------------------------------------------------------------------------------------
+static void mcn_priv_value_noise_1d_chunk(const float* x, MCHR_UINT count, MCHR_UINT seed, float* out) {
+    MCHR_INT ix[MCN_CHUNK], ix1[MCN_CHUNK];
+    float sx[MCN_CHUNK];
+    MCHR_UINT h0[MCN_CHUNK], h1[MCN_CHUNK];
+
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        ix[i] = mcn_priv_floor(x[i]);
+        ix1[i] = ix[i] + 1;
+        sx[i] = mcn_priv_smoothstep(x[i] - (float)ix[i]);
+    }
+    mchr_get_1d_hash_uint_batch(ix, count, seed, h0);
+    mchr_get_1d_hash_uint_batch(ix1, count, seed, h1);
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        out[i] = mcn_priv_lerp(mcn_priv_hash_to_signed(h0[i]), mcn_priv_hash_to_signed(h1[i]), sx[i]);
+    }
+}
+
+// Interpolation of the corner values or gradients of a chunk of points. hashes[c] holds
+//  the hashes of corner c for every point, where bit d of c is the offset along dimension
+//  d. Operations are done in the same order as in the single point functions, so results
+//  are identical.
+static void mcn_priv_lattice_interpolate_2d(mcn_priv_lattice_kind_t kind, MCHR_UINT hashes[][MCN_CHUNK], const float* const* frac,
+                                            MCHR_UINT count, float* out, float* const* deriv) {
+    const float* fx = frac[0];
+    const float* fy = frac[1];
+    if (kind == MCN_PRIV_VALUE) {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            float sx = mcn_priv_smoothstep(fx[i]);
+            float sy = mcn_priv_smoothstep(fy[i]);
+            float a = mcn_priv_lerp(mcn_priv_hash_to_signed(hashes[0][i]), mcn_priv_hash_to_signed(hashes[1][i]), sx);
+            float b = mcn_priv_lerp(mcn_priv_hash_to_signed(hashes[2][i]), mcn_priv_hash_to_signed(hashes[3][i]), sx);
+            out[i] = mcn_priv_lerp(a, b, sy);
+        }
+    } else {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            float sx = mcn_priv_fade(fx[i]);
+            float sy = mcn_priv_fade(fy[i]);
+            float a = mcn_priv_lerp(mcn_priv_gradient_2d(hashes[0][i], fx[i], fy[i]), mcn_priv_gradient_2d(hashes[1][i], fx[i] - 1.0f, fy[i]), sx);
+            float b = mcn_priv_lerp(mcn_priv_gradient_2d(hashes[2][i], fx[i], fy[i] - 1.0f), mcn_priv_gradient_2d(hashes[3][i], fx[i] - 1.0f, fy[i] - 1.0f), sx);
+            out[i] = mcn_priv_lerp(a, b, sy) * MCN_GRADIENT_SCALE[2];
+        }
+    }
+    if (!deriv)
+        return;
+
+    // d/dx of lerp(lerp(c0, c1, sx), lerp(c2, c3, sx), sy) is sx' * lerp(c1 - c0, c3 - c2, sy),
+    //  plus, for gradient noise, the interpolation of the x components of the gradients
+    if (kind == MCN_PRIV_VALUE) {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            float sx = mcn_priv_smoothstep(fx[i]);
+            float sy = mcn_priv_smoothstep(fy[i]);
+            float v0 = mcn_priv_hash_to_signed(hashes[0][i]), v1 = mcn_priv_hash_to_signed(hashes[1][i]);
+            float v2 = mcn_priv_hash_to_signed(hashes[2][i]), v3 = mcn_priv_hash_to_signed(hashes[3][i]);
+            deriv[0][i] = mcn_priv_smoothstep_deriv(fx[i]) * mcn_priv_lerp(v1 - v0, v3 - v2, sy);
+            deriv[1][i] = mcn_priv_smoothstep_deriv(fy[i]) * (mcn_priv_lerp(v2, v3, sx) - mcn_priv_lerp(v0, v1, sx));
+        }
+    } else {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            float sx = mcn_priv_fade(fx[i]);
+            float sy = mcn_priv_fade(fy[i]);
+            MCHR_UINT h0 = hashes[0][i] >> 28, h1 = hashes[1][i] >> 28, h2 = hashes[2][i] >> 28, h3 = hashes[3][i] >> 28;
+            float g0 = mcn_priv_gradient_2d(hashes[0][i], fx[i], fy[i]);
+            float g1 = mcn_priv_gradient_2d(hashes[1][i], fx[i] - 1.0f, fy[i]);
+            float g2 = mcn_priv_gradient_2d(hashes[2][i], fx[i], fy[i] - 1.0f);
+            float g3 = mcn_priv_gradient_2d(hashes[3][i], fx[i] - 1.0f, fy[i] - 1.0f);
+            float gx = mcn_priv_lerp(mcn_priv_lerp(MCN_GRADIENT_2D_X[h0], MCN_GRADIENT_2D_X[h1], sx), mcn_priv_lerp(MCN_GRADIENT_2D_X[h2], MCN_GRADIENT_2D_X[h3], sx), sy);
+            float gy = mcn_priv_lerp(mcn_priv_lerp(MCN_GRADIENT_2D_Y[h0], MCN_GRADIENT_2D_Y[h1], sx), mcn_priv_lerp(MCN_GRADIENT_2D_Y[h2], MCN_GRADIENT_2D_Y[h3], sx), sy);
+            deriv[0][i] = (gx + mcn_priv_fade_deriv(fx[i]) * mcn_priv_lerp(g1 - g0, g3 - g2, sy)) * MCN_GRADIENT_SCALE[2];
+            deriv[1][i] = (gy + mcn_priv_fade_deriv(fy[i]) * (mcn_priv_lerp(g2, g3, sx) - mcn_priv_lerp(g0, g1, sx))) * MCN_GRADIENT_SCALE[2];
+        }
+    }
+}
+
+static void mcn_priv_lattice_interpolate_3d(mcn_priv_lattice_kind_t kind, MCHR_UINT hashes[][MCN_CHUNK], const float* const* frac,
+                                            MCHR_UINT count, float* out, float* const* deriv) {
+    const float* fx = frac[0];
+    const float* fy = frac[1];
+    const float* fz = frac[2];
+    if (kind == MCN_PRIV_VALUE) {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            float sx = mcn_priv_smoothstep(fx[i]);
+            float sy = mcn_priv_smoothstep(fy[i]);
+            float sz = mcn_priv_smoothstep(fz[i]);
+            float a = mcn_priv_lerp(mcn_priv_hash_to_signed(hashes[0][i]), mcn_priv_hash_to_signed(hashes[1][i]), sx);
+            float b = mcn_priv_lerp(mcn_priv_hash_to_signed(hashes[2][i]), mcn_priv_hash_to_signed(hashes[3][i]), sx);
+            float c = mcn_priv_lerp(mcn_priv_hash_to_signed(hashes[4][i]), mcn_priv_hash_to_signed(hashes[5][i]), sx);
+            float d = mcn_priv_lerp(mcn_priv_hash_to_signed(hashes[6][i]), mcn_priv_hash_to_signed(hashes[7][i]), sx);
+            out[i] = mcn_priv_lerp(mcn_priv_lerp(a, b, sy), mcn_priv_lerp(c, d, sy), sz);
+        }
+    } else {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            float sx = mcn_priv_fade(fx[i]);
+            float sy = mcn_priv_fade(fy[i]);
+            float sz = mcn_priv_fade(fz[i]);
+            float x0 = fx[i], y0 = fy[i], z0 = fz[i];
+            float x1 = x0 - 1.0f, y1 = y0 - 1.0f, z1 = z0 - 1.0f;
+            float a = mcn_priv_lerp(mcn_priv_gradient_3d(hashes[0][i], x0, y0, z0), mcn_priv_gradient_3d(hashes[1][i], x1, y0, z0), sx);
+            float b = mcn_priv_lerp(mcn_priv_gradient_3d(hashes[2][i], x0, y1, z0), mcn_priv_gradient_3d(hashes[3][i], x1, y1, z0), sx);
+            float c = mcn_priv_lerp(mcn_priv_gradient_3d(hashes[4][i], x0, y0, z1), mcn_priv_gradient_3d(hashes[5][i], x1, y0, z1), sx);
+            float d = mcn_priv_lerp(mcn_priv_gradient_3d(hashes[6][i], x0, y1, z1), mcn_priv_gradient_3d(hashes[7][i], x1, y1, z1), sx);
+            out[i] = mcn_priv_lerp(mcn_priv_lerp(a, b, sy), mcn_priv_lerp(c, d, sy), sz) * MCN_GRADIENT_SCALE[3];
+        }
+    }
+    if (!deriv)
+        return;
+
+    if (kind == MCN_PRIV_VALUE) {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            float sx = mcn_priv_smoothstep(fx[i]);
+            float sy = mcn_priv_smoothstep(fy[i]);
+            float sz = mcn_priv_smoothstep(fz[i]);
+            float v[8];
+            for (MCHR_UINT k = 0; k < 8; ++k) {
+                v[k] = mcn_priv_hash_to_signed(hashes[k][i]);
+            }
+            float a = mcn_priv_lerp(v[0], v[1], sx), b = mcn_priv_lerp(v[2], v[3], sx);
+            float c = mcn_priv_lerp(v[4], v[5], sx), d = mcn_priv_lerp(v[6], v[7], sx);
+            deriv[0][i] = mcn_priv_smoothstep_deriv(fx[i]) * mcn_priv_lerp(mcn_priv_lerp(v[1] - v[0], v[3] - v[2], sy), mcn_priv_lerp(v[5] - v[4], v[7] - v[6], sy), sz);
+            deriv[1][i] = mcn_priv_smoothstep_deriv(fy[i]) * mcn_priv_lerp(b - a, d - c, sz);
+            deriv[2][i] = mcn_priv_smoothstep_deriv(fz[i]) * (mcn_priv_lerp(c, d, sy) - mcn_priv_lerp(a, b, sy));
+        }
+    } else {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            float sx = mcn_priv_fade(fx[i]);
+            float sy = mcn_priv_fade(fy[i]);
+            float sz = mcn_priv_fade(fz[i]);
+            float x0 = fx[i], y0 = fy[i], z0 = fz[i];
+            float x1 = x0 - 1.0f, y1 = y0 - 1.0f, z1 = z0 - 1.0f;
+            float g[8], gx[8], gy[8], gz[8];
+            g[0] = mcn_priv_gradient_3d(hashes[0][i], x0, y0, z0);
+            g[1] = mcn_priv_gradient_3d(hashes[1][i], x1, y0, z0);
+            g[2] = mcn_priv_gradient_3d(hashes[2][i], x0, y1, z0);
+            g[3] = mcn_priv_gradient_3d(hashes[3][i], x1, y1, z0);
+            g[4] = mcn_priv_gradient_3d(hashes[4][i], x0, y0, z1);
+            g[5] = mcn_priv_gradient_3d(hashes[5][i], x1, y0, z1);
+            g[6] = mcn_priv_gradient_3d(hashes[6][i], x0, y1, z1);
+            g[7] = mcn_priv_gradient_3d(hashes[7][i], x1, y1, z1);
+            for (MCHR_UINT k = 0; k < 8; ++k) {
+                MCHR_UINT h = hashes[k][i] >> 28;
+                gx[k] = MCN_GRADIENT_3D_X[h];
+                gy[k] = MCN_GRADIENT_3D_Y[h];
+                gz[k] = MCN_GRADIENT_3D_Z[h];
+            }
+            float a = mcn_priv_lerp(g[0], g[1], sx), b = mcn_priv_lerp(g[2], g[3], sx);
+            float c = mcn_priv_lerp(g[4], g[5], sx), d = mcn_priv_lerp(g[6], g[7], sx);
+            float ix = mcn_priv_lerp(mcn_priv_lerp(mcn_priv_lerp(gx[0], gx[1], sx), mcn_priv_lerp(gx[2], gx[3], sx), sy),
+                                     mcn_priv_lerp(mcn_priv_lerp(gx[4], gx[5], sx), mcn_priv_lerp(gx[6], gx[7], sx), sy), sz);
+            float iy = mcn_priv_lerp(mcn_priv_lerp(mcn_priv_lerp(gy[0], gy[1], sx), mcn_priv_lerp(gy[2], gy[3], sx), sy),
+                                     mcn_priv_lerp(mcn_priv_lerp(gy[4], gy[5], sx), mcn_priv_lerp(gy[6], gy[7], sx), sy), sz);
+            float iz = mcn_priv_lerp(mcn_priv_lerp(mcn_priv_lerp(gz[0], gz[1], sx), mcn_priv_lerp(gz[2], gz[3], sx), sy),
+                                     mcn_priv_lerp(mcn_priv_lerp(gz[4], gz[5], sx), mcn_priv_lerp(gz[6], gz[7], sx), sy), sz);
+            deriv[0][i] = (ix + mcn_priv_fade_deriv(x0) * mcn_priv_lerp(mcn_priv_lerp(g[1] - g[0], g[3] - g[2], sy), mcn_priv_lerp(g[5] - g[4], g[7] - g[6], sy), sz)) * MCN_GRADIENT_SCALE[3];
+            deriv[1][i] = (iy + mcn_priv_fade_deriv(y0) * mcn_priv_lerp(b - a, d - c, sz)) * MCN_GRADIENT_SCALE[3];
+            deriv[2][i] = (iz + mcn_priv_fade_deriv(z0) * (mcn_priv_lerp(c, d, sy) - mcn_priv_lerp(a, b, sy))) * MCN_GRADIENT_SCALE[3];
+        }
+    }
+}
+
+static void mcn_priv_lattice_interpolate_4d(mcn_priv_lattice_kind_t kind, MCHR_UINT hashes[][MCN_CHUNK], const float* const* frac,
+                                            MCHR_UINT count, float* out) {
+    const float* fx = frac[0];
+    const float* fy = frac[1];
+    const float* fz = frac[2];
+    const float* fw = frac[3];
+    if (kind == MCN_PRIV_VALUE) {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            float sx = mcn_priv_smoothstep(fx[i]);
+            float sy = mcn_priv_smoothstep(fy[i]);
+            float sz = mcn_priv_smoothstep(fz[i]);
+            float sw = mcn_priv_smoothstep(fw[i]);
+            float plane[4];
+            for (MCHR_UINT k = 0; k < 4; ++k) {
+                const MCHR_UINT c = 4 * k;
+                float a = mcn_priv_lerp(mcn_priv_hash_to_signed(hashes[c][i]), mcn_priv_hash_to_signed(hashes[c + 1][i]), sx);
+                float b = mcn_priv_lerp(mcn_priv_hash_to_signed(hashes[c + 2][i]), mcn_priv_hash_to_signed(hashes[c + 3][i]), sx);
+                plane[k] = mcn_priv_lerp(a, b, sy);
+            }
+            out[i] = mcn_priv_lerp(mcn_priv_lerp(plane[0], plane[1], sz), mcn_priv_lerp(plane[2], plane[3], sz), sw);
+        }
+    } else {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            float sx = mcn_priv_fade(fx[i]);
+            float sy = mcn_priv_fade(fy[i]);
+            float sz = mcn_priv_fade(fz[i]);
+            float sw = mcn_priv_fade(fw[i]);
+            float plane[4];
+            for (MCHR_UINT k = 0; k < 4; ++k) {
+                const MCHR_UINT c = 4 * k;
+                float dz = fz[i] - (float)(k & 1);
+                float dw = fw[i] - (float)(k >> 1);
+                float a = mcn_priv_lerp(mcn_priv_gradient_4d(hashes[c][i], fx[i], fy[i], dz, dw), mcn_priv_gradient_4d(hashes[c + 1][i], fx[i] - 1.0f, fy[i], dz, dw), sx);
+                float b = mcn_priv_lerp(mcn_priv_gradient_4d(hashes[c + 2][i], fx[i], fy[i] - 1.0f, dz, dw), mcn_priv_gradient_4d(hashes[c + 3][i], fx[i] - 1.0f, fy[i] - 1.0f, dz, dw), sx);
+                plane[k] = mcn_priv_lerp(a, b, sy);
+            }
+            out[i] = mcn_priv_lerp(mcn_priv_lerp(plane[0], plane[1], sz), mcn_priv_lerp(plane[2], plane[3], sz), sw) * MCN_GRADIENT_SCALE[4];
+        }
+    }
+}
+
+// Lattice noise in 2 to 4 dimensions, for up to MCN_CHUNK points.
+static void mcn_priv_lattice_noise_chunk(mcn_priv_lattice_kind_t kind, const float* const* coords, MCHR_UINT dims,
+                                         MCHR_UINT count, MCHR_UINT seed, const MCHR_UINT* period, float* out, float* const* deriv) {
+    MCHR_INT lattice[4][2][MCN_CHUNK];
+    float frac_data[4][MCN_CHUNK];
+    MCHR_UINT hashes[16][MCN_CHUNK];
+    const float* frac[4];
+
+    for (MCHR_UINT d = 0; d < dims; ++d) {
+        const float* c = coords[d];
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            MCHR_INT cell = mcn_priv_floor(c[i]);
+            lattice[d][0][i] = cell;
+            lattice[d][1][i] = cell + 1;
+            frac_data[d][i] = c[i] - (float)cell;
+        }
+        frac[d] = frac_data[d];
+        if (period) {
+            mcn_priv_wrap_lattice(lattice[d][0], count, period[d]);
+            mcn_priv_wrap_lattice(lattice[d][1], count, period[d]);
+        }
+    }
+
+    const MCHR_UINT corners = 1U << dims;
+    for (MCHR_UINT c = 0; c < corners; ++c) {
+        const MCHR_INT* x = lattice[0][c & 1];
+        const MCHR_INT* y = lattice[1][(c >> 1) & 1];
+        if (dims == 2) {
+            mchr_get_2d_hash_uint_batch(x, y, count, seed, hashes[c]);
+        } else if (dims == 3) {
+            mchr_get_3d_hash_uint_batch(x, y, lattice[2][c >> 2], count, seed, hashes[c]);
+        } else {
+            mchr_get_4d_hash_uint_batch(x, y, lattice[2][(c >> 2) & 1], lattice[3][c >> 3], count, seed, hashes[c]);
+        }
+    }
+
+    if (dims == 2) {
+        mcn_priv_lattice_interpolate_2d(kind, hashes, frac, count, out, deriv);
+    } else if (dims == 3) {
+        mcn_priv_lattice_interpolate_3d(kind, hashes, frac, count, out, deriv);
+    } else {
+        assert(!deriv && "no derivatives in 4D");
+        mcn_priv_lattice_interpolate_4d(kind, hashes, frac, count, out);
+    }
+}
+
+static void mcn_priv_lattice_noise_batch(mcn_priv_lattice_kind_t kind, const float* const* coords, MCHR_UINT dims,
+                                         MCHR_UINT count, MCHR_UINT seed, const MCHR_UINT* period, float* out) {
+    for (MCHR_UINT first = 0; first < count; first += MCN_CHUNK) {
+        MCHR_UINT n = (count - first < MCN_CHUNK) ? count - first : MCN_CHUNK;
+        const float* chunk_coords[4];
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            chunk_coords[d] = coords[d] + first;
+        }
+        mcn_priv_lattice_noise_chunk(kind, chunk_coords, dims, n, seed, period, out + first, NULL);
+    }
+}
+
+MCN_DEF void mcn_value_noise_1d_batch( const float* x, MCHR_UINT count, MCHR_UINT seed, float* out ) {
+    for (MCHR_UINT first = 0; first < count; first += MCN_CHUNK) {
+        MCHR_UINT n = (count - first < MCN_CHUNK) ? count - first : MCN_CHUNK;
+        mcn_priv_value_noise_1d_chunk(x + first, n, seed, out + first);
+    }
+}
+
+MCN_DEF void mcn_value_noise_2d_batch( const float* x, const float* y, MCHR_UINT count, MCHR_UINT seed, float* out ) {
+    const float* coords[2] = { x, y };
+    mcn_priv_lattice_noise_batch(MCN_PRIV_VALUE, coords, 2, count, seed, NULL, out);
+}
+
+MCN_DEF void mcn_value_noise_3d_batch( const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT seed, float* out ) {
+    const float* coords[3] = { x, y, z };
+    mcn_priv_lattice_noise_batch(MCN_PRIV_VALUE, coords, 3, count, seed, NULL, out);
+}
+
+MCN_DEF void mcn_value_noise_4d_batch( const float* x, const float* y, const float* z, const float* w, MCHR_UINT count, MCHR_UINT seed, float* out ) {
+    const float* coords[4] = { x, y, z, w };
+    mcn_priv_lattice_noise_batch(MCN_PRIV_VALUE, coords, 4, count, seed, NULL, out);
+}
+
+MCN_DEF void mcn_gradient_noise_2d_batch( const float* x, const float* y, MCHR_UINT count, MCHR_UINT seed, float* out ) {
+    const float* coords[2] = { x, y };
+    mcn_priv_lattice_noise_batch(MCN_PRIV_GRADIENT, coords, 2, count, seed, NULL, out);
+}
+
+MCN_DEF void mcn_gradient_noise_3d_batch( const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT seed, float* out ) {
+    const float* coords[3] = { x, y, z };
+    mcn_priv_lattice_noise_batch(MCN_PRIV_GRADIENT, coords, 3, count, seed, NULL, out);
+}
+
+MCN_DEF void mcn_gradient_noise_4d_batch( const float* x, const float* y, const float* z, const float* w, MCHR_UINT count, MCHR_UINT seed, float* out ) {
+    const float* coords[4] = { x, y, z, w };
+    mcn_priv_lattice_noise_batch(MCN_PRIV_GRADIENT, coords, 4, count, seed, NULL, out);
+}
+
+// ---------------------------------------------------------------------------------------
+// Lattice row cache used by the grid functions: the hashes of consecutive lattice points
+//  along x, from `first_x` to `first_x + count - 1`, at fixed y (and z) lattice
+//  coordinates. Rows are only recomputed when a grid row falls into a different cell.
+// ---------------------------------------------------------------------------------------
+typedef struct mcn_priv_row_cache_t {
+    MCHR_INT first_x;
+    MCHR_UINT count;
+    MCHR_INT y, z;
+    int valid;
+    MCHR_UINT hashes[MCN_ROW_CACHE];
+} mcn_priv_row_cache_t;
+
+static int mcn_priv_row_cache_matches(const mcn_priv_row_cache_t* row, MCHR_INT first_x, MCHR_UINT count, MCHR_INT y, MCHR_INT z) {
+    return row->valid && row->first_x == first_x && row->count == count && row->y == y && row->z == z;
+}
+
+static void mcn_priv_row_cache_update(mcn_priv_row_cache_t* row, MCHR_UINT dims, MCHR_INT first_x, MCHR_UINT count,
+                                      MCHR_INT y, MCHR_INT z, MCHR_UINT seed, const MCHR_UINT* period) {
+    if (mcn_priv_row_cache_matches(row, first_x, count, y, z))
+        return;
+
+    MCHR_INT xs[MCN_ROW_CACHE], ys[MCN_ROW_CACHE], zs[MCN_ROW_CACHE];
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        xs[i] = first_x + (MCHR_INT)i;
+        ys[i] = y;
+        zs[i] = z;
+    }
+    if (period) {
+        mcn_priv_wrap_lattice(xs, count, period[0]);
+        if (dims > 1)
+            mcn_priv_wrap_lattice(ys, count, period[1]);
+        if (dims > 2)
+            mcn_priv_wrap_lattice(zs, count, period[2]);
+    }
+    if (dims == 1) {
+        mchr_get_1d_hash_uint_batch(xs, count, seed, row->hashes);
+    } else if (dims == 2) {
+        mchr_get_2d_hash_uint_batch(xs, ys, count, seed, row->hashes);
+    } else {
+        mchr_get_3d_hash_uint_batch(xs, ys, zs, count, seed, row->hashes);
+    }
+    row->first_x = first_x;
+    row->count = count;
+    row->y = y;
+    row->z = z;
+    row->valid = 1;
+}
+
+// ---------------------------------------------------------------------------------------
+// Private function preparing the columns of a grid chunk: the coordinates, lattice cells,
+//  offsets inside the cells and interpolation weights along x (unless `weights` is NULL).
+//  Returns the number of lattice points spanned.
+// ---------------------------------------------------------------------------------------
+static MCHR_UINT mcn_priv_grid_columns(mcn_priv_lattice_kind_t kind, float start_x, float step_x, MCHR_UINT first, MCHR_UINT count,
+                                       float* xs, MCHR_INT* cells, float* frac, float* weights, MCHR_INT* out_min_cell) {
+    MCHR_INT min_cell = 0, max_cell = 0;
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        xs[i] = start_x + (float)(first + i) * step_x;
+        cells[i] = mcn_priv_floor(xs[i]);
+        frac[i] = xs[i] - (float)cells[i];
+        if (weights)
+            weights[i] = mcn_priv_lattice_weight(kind, frac[i]);
+        if (i == 0 || cells[i] < min_cell)
+            min_cell = cells[i];
+        if (i == 0 || cells[i] > max_cell)
+            max_cell = cells[i];
+    }
+    *out_min_cell = min_cell;
+    return (MCHR_UINT)(max_cell - min_cell) + 2;
+}
+
+// ---------------------------------------------------------------------------------------
+// Private function interpolating along x the corners stored in a cached lattice row. The
+//  offsets dy and dz from the row to the samples are ignored by value noise.
+// ---------------------------------------------------------------------------------------
+static void mcn_priv_grid_row_edge(mcn_priv_lattice_kind_t kind, MCHR_UINT dims, const MCHR_UINT* hashes, const MCHR_INT* cells,
+                                   MCHR_INT min_cell, const float* fx, const float* sx, float dy, float dz,
+                                   MCHR_UINT count, float* out) {
+    if (kind == MCN_PRIV_VALUE) {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            MCHR_UINT k = (MCHR_UINT)(cells[i] - min_cell);
+            out[i] = mcn_priv_lerp(mcn_priv_hash_to_signed(hashes[k]), mcn_priv_hash_to_signed(hashes[k + 1]), sx[i]);
+        }
+    } else if (dims == 2) {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            MCHR_UINT k = (MCHR_UINT)(cells[i] - min_cell);
+            out[i] = mcn_priv_lerp(mcn_priv_gradient_2d(hashes[k], fx[i], dy), mcn_priv_gradient_2d(hashes[k + 1], fx[i] - 1.0f, dy), sx[i]);
+        }
+    } else {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            MCHR_UINT k = (MCHR_UINT)(cells[i] - min_cell);
+            out[i] = mcn_priv_lerp(mcn_priv_gradient_3d(hashes[k], fx[i], dy, dz), mcn_priv_gradient_3d(hashes[k + 1], fx[i] - 1.0f, dy, dz), sx[i]);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Lattice noise, regular grids.
+// ---------------------------------------------------------------------------------------
+MCN_DEF void mcn_value_noise_1d_grid( float start_x, float step_x, MCHR_UINT width, MCHR_UINT seed, float* out ) {
+    mcn_priv_row_cache_t row;
+    row.valid = 0;
+
+    for (MCHR_UINT first = 0; first < width; first += MCN_CHUNK) {
+        MCHR_UINT n = (width - first < MCN_CHUNK) ? width - first : MCN_CHUNK;
+        float xs[MCN_CHUNK], fx[MCN_CHUNK], sx[MCN_CHUNK];
+        MCHR_INT cells[MCN_CHUNK], min_cell;
+        MCHR_UINT span = mcn_priv_grid_columns(MCN_PRIV_VALUE, start_x, step_x, first, n, xs, cells, fx, sx, &min_cell);
+
+        if (span > MCN_ROW_CACHE) {
+            mcn_priv_value_noise_1d_chunk(xs, n, seed, out + first);
+            continue;
+        }
+        mcn_priv_row_cache_update(&row, 1, min_cell, span, 0, 0, seed, NULL);
+        mcn_priv_grid_row_edge(MCN_PRIV_VALUE, 1, row.hashes, cells, min_cell, fx, sx, 0.0f, 0.0f, n, out + first);
+    }
+}
+
+static void mcn_priv_lattice_noise_2d_grid(mcn_priv_lattice_kind_t kind, float start_x, float start_y, float step_x, float step_y,
+                                           MCHR_UINT width, MCHR_UINT height, MCHR_UINT seed, const MCHR_UINT* period, float* out) {
+    mcn_priv_row_cache_t rows[2];
+    const float scale = mcn_priv_lattice_scale(kind, 2);
+
+    for (MCHR_UINT first = 0; first < width; first += MCN_CHUNK) {
+        MCHR_UINT n = (width - first < MCN_CHUNK) ? width - first : MCN_CHUNK;
+        float xs[MCN_CHUNK], fx[MCN_CHUNK], sx[MCN_CHUNK];
+        MCHR_INT cells[MCN_CHUNK], min_cell;
+        MCHR_UINT span = mcn_priv_grid_columns(kind, start_x, step_x, first, n, xs, cells, fx, sx, &min_cell);
+        rows[0].valid = rows[1].valid = 0;
+
+        for (MCHR_UINT r = 0; r < height; ++r) {
+            float y = start_y + (float)r * step_y;
+            float* row_out = out + (size_t)r * width + first;
+
+            if (span > MCN_ROW_CACHE) {
+                float ys[MCN_CHUNK];
+                for (MCHR_UINT i = 0; i < n; ++i) {
+                    ys[i] = y;
+                }
+                const float* coords[2] = { xs, ys };
+                mcn_priv_lattice_noise_chunk(kind, coords, 2, n, seed, period, row_out, NULL);
+                continue;
+            }
+
+            MCHR_INT iy = mcn_priv_floor(y);
+            float fy = y - (float)iy;
+            float sy = mcn_priv_lattice_weight(kind, fy);
+            // moving one cell up reuses the previous top row as the new bottom one
+            if (mcn_priv_row_cache_matches(&rows[1], min_cell, span, iy, 0)) {
+                mcn_priv_row_cache_t swap = rows[0];
+                rows[0] = rows[1];
+                rows[1] = swap;
+            }
+            mcn_priv_row_cache_update(&rows[0], 2, min_cell, span, iy, 0, seed, period);
+            mcn_priv_row_cache_update(&rows[1], 2, min_cell, span, iy + 1, 0, seed, period);
+
+            float bottom[MCN_CHUNK], top[MCN_CHUNK];
+            mcn_priv_grid_row_edge(kind, 2, rows[0].hashes, cells, min_cell, fx, sx, fy, 0.0f, n, bottom);
+            mcn_priv_grid_row_edge(kind, 2, rows[1].hashes, cells, min_cell, fx, sx, fy - 1.0f, 0.0f, n, top);
+            if (kind == MCN_PRIV_VALUE) {
+                for (MCHR_UINT i = 0; i < n; ++i) {
+                    row_out[i] = mcn_priv_lerp(bottom[i], top[i], sy);
+                }
+            } else {
+                for (MCHR_UINT i = 0; i < n; ++i) {
+                    row_out[i] = mcn_priv_lerp(bottom[i], top[i], sy) * scale;
+                }
+            }
+        }
+    }
+}
+
+static void mcn_priv_lattice_noise_3d_grid(mcn_priv_lattice_kind_t kind, float start_x, float start_y, float start_z,
+                                           float step_x, float step_y, float step_z,
+                                           MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT seed, const MCHR_UINT* period, float* out) {
+    mcn_priv_row_cache_t rows[4];
+    const float scale = mcn_priv_lattice_scale(kind, 3);
+
+    for (MCHR_UINT first = 0; first < width; first += MCN_CHUNK) {
+        MCHR_UINT n = (width - first < MCN_CHUNK) ? width - first : MCN_CHUNK;
+        float xs[MCN_CHUNK], fx[MCN_CHUNK], sx[MCN_CHUNK];
+        MCHR_INT cells[MCN_CHUNK], min_cell;
+        MCHR_UINT span = mcn_priv_grid_columns(kind, start_x, step_x, first, n, xs, cells, fx, sx, &min_cell);
+        rows[0].valid = rows[1].valid = rows[2].valid = rows[3].valid = 0;
+
+        for (MCHR_UINT s = 0; s < depth; ++s) {
+            float z = start_z + (float)s * step_z;
+            MCHR_INT iz = mcn_priv_floor(z);
+            float fz = z - (float)iz;
+            float sz = mcn_priv_lattice_weight(kind, fz);
+
+            for (MCHR_UINT r = 0; r < height; ++r) {
+                float y = start_y + (float)r * step_y;
+                float* row_out = out + ((size_t)s * height + r) * width + first;
+
+                if (span > MCN_ROW_CACHE) {
+                    float ys[MCN_CHUNK], zs[MCN_CHUNK];
+                    for (MCHR_UINT i = 0; i < n; ++i) {
+                        ys[i] = y;
+                        zs[i] = z;
+                    }
+                    const float* coords[3] = { xs, ys, zs };
+                    mcn_priv_lattice_noise_chunk(kind, coords, 3, n, seed, period, row_out, NULL);
+                    continue;
+                }
+
+                MCHR_INT iy = mcn_priv_floor(y);
+                float fy = y - (float)iy;
+                float sy = mcn_priv_lattice_weight(kind, fy);
+                // rows[2 * dz + dy] holds the lattice row at (iy + dy, iz + dz)
+                float edge[4][MCN_CHUNK];
+                for (MCHR_UINT c = 0; c < 4; ++c) {
+                    MCHR_INT dy = (MCHR_INT)(c & 1);
+                    MCHR_INT dz = (MCHR_INT)(c >> 1);
+                    mcn_priv_row_cache_update(&rows[c], 3, min_cell, span, iy + dy, iz + dz, seed, period);
+                    mcn_priv_grid_row_edge(kind, 3, rows[c].hashes, cells, min_cell, fx, sx, fy - (float)dy, fz - (float)dz, n, edge[c]);
+                }
+                for (MCHR_UINT i = 0; i < n; ++i) {
+                    row_out[i] = mcn_priv_lerp(mcn_priv_lerp(edge[0][i], edge[1][i], sy), mcn_priv_lerp(edge[2][i], edge[3][i], sy), sz) * scale;
+                }
+            }
+        }
+    }
+}
+
+MCN_DEF void mcn_value_noise_2d_grid( float start_x, float start_y, float step_x, float step_y, MCHR_UINT width, MCHR_UINT height, MCHR_UINT seed, float* out ) {
+    mcn_priv_lattice_noise_2d_grid(MCN_PRIV_VALUE, start_x, start_y, step_x, step_y, width, height, seed, NULL, out);
+}
+
+MCN_DEF void mcn_value_noise_3d_grid( float start_x, float start_y, float start_z, float step_x, float step_y, float step_z, MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT seed, float* out ) {
+    mcn_priv_lattice_noise_3d_grid(MCN_PRIV_VALUE, start_x, start_y, start_z, step_x, step_y, step_z, width, height, depth, seed, NULL, out);
+}
+
+MCN_DEF void mcn_gradient_noise_2d_grid( float start_x, float start_y, float step_x, float step_y, MCHR_UINT width, MCHR_UINT height, MCHR_UINT seed, float* out ) {
+    mcn_priv_lattice_noise_2d_grid(MCN_PRIV_GRADIENT, start_x, start_y, step_x, step_y, width, height, seed, NULL, out);
+}
+
+MCN_DEF void mcn_gradient_noise_3d_grid( float start_x, float start_y, float start_z, float step_x, float step_y, float step_z, MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT seed, float* out ) {
+    mcn_priv_lattice_noise_3d_grid(MCN_PRIV_GRADIENT, start_x, start_y, start_z, step_x, step_y, step_z, width, height, depth, seed, NULL, out);
+}
+
+// ---------------------------------------------------------------------------------------
+// Simplex noise. Space is skewed so that every lattice cell splits into n! simplices, and
+//  a point only sums the radial kernels of the n+1 vertices of its simplex (3 lattice
+//  points in 2D, 4 in 3D and 5 in 4D, instead of 4, 8 and 16). The simplex is found by
+//  ranking the offsets inside the skewed cell, so there are no branches. As in
+//  OpenSimplex2, the squared kernel radius is 0.5, which keeps the noise continuous in
+//  every dimension (the 0.6 of the original implementation doesn't in 3D and 4D). Results
+//  are scaled by the inverse of the largest sum of kernels times dot products possible
+//  with the gradient sets above, found numerically and rounded down.
+// ---------------------------------------------------------------------------------------
+static const float MCN_SIMPLEX_RADIUS2 = 0.5f;
+
+// (sqrt(n+1)-1)/n and (1-1/sqrt(n+1))/n, indexed by dimension.
+static const float MCN_SIMPLEX_SKEW[5] = { 0.0f, 0.0f, 0.36602540f, 0.33333333f, 0.30901699f };
+static const float MCN_SIMPLEX_UNSKEW[5] = { 0.0f, 0.0f, 0.21132487f, 0.16666667f, 0.13819660f };
+
+static const float MCN_SIMPLEX_SCALE[5] = { 0.0f, 0.0f, 99.20f, 76.88f, 62.77f };
+
+static float mcn_priv_simplex_kernel(float dist2) {
+    float t = MCN_SIMPLEX_RADIUS2 - dist2;
+    // same as max(t, 0), exactly, but compilers don't turn it into a branch
+    t = 0.5f * (t + fabsf(t));
+    t *= t;
+    return t * t;
+}
+
+MCN_DEF float mcn_simplex_noise_2d( float x, float y, MCHR_UINT seed ) {
+    float s = (x + y) * MCN_SIMPLEX_SKEW[2];
+    MCHR_INT ix = mcn_priv_floor(x + s);
+    MCHR_INT iy = mcn_priv_floor(y + s);
+    float t = (float)(ix + iy) * MCN_SIMPLEX_UNSKEW[2];
+    float x0 = x - ((float)ix - t);
+    float y0 = y - ((float)iy - t);
+    MCHR_INT rx = (x0 > y0);
+    MCHR_INT ry = (y0 >= x0);
+
+    float result = 0.0f;
+    for (MCHR_INT v = 0; v <= 2; ++v) {
+        MCHR_INT ox = (rx >= 2 - v);
+        MCHR_INT oy = (ry >= 2 - v);
+        float offset = (float)v * MCN_SIMPLEX_UNSKEW[2];
+        float dx = x0 - (float)ox + offset;
+        float dy = y0 - (float)oy + offset;
+        MCHR_UINT hash = mchr_get_2d_hash_uint(ix + ox, iy + oy, seed);
+        result += mcn_priv_simplex_kernel(dx * dx + dy * dy) * mcn_priv_gradient_2d(hash, dx, dy);
+    }
+    return result * MCN_SIMPLEX_SCALE[2];
+}
+
+MCN_DEF float mcn_simplex_noise_3d( float x, float y, float z, MCHR_UINT seed ) {
+    float s = (x + y + z) * MCN_SIMPLEX_SKEW[3];
+    MCHR_INT ix = mcn_priv_floor(x + s);
+    MCHR_INT iy = mcn_priv_floor(y + s);
+    MCHR_INT iz = mcn_priv_floor(z + s);
+    float t = (float)(ix + iy + iz) * MCN_SIMPLEX_UNSKEW[3];
+    float x0 = x - ((float)ix - t);
+    float y0 = y - ((float)iy - t);
+    float z0 = z - ((float)iz - t);
+    // ties are broken in favour of the first axis
+    MCHR_INT rx = (x0 > y0) + (x0 > z0);
+    MCHR_INT ry = (y0 >= x0) + (y0 > z0);
+    MCHR_INT rz = (z0 >= x0) + (z0 >= y0);
+
+    float result = 0.0f;
+    for (MCHR_INT v = 0; v <= 3; ++v) {
+        MCHR_INT ox = (rx >= 3 - v);
+        MCHR_INT oy = (ry >= 3 - v);
+        MCHR_INT oz = (rz >= 3 - v);
+        float offset = (float)v * MCN_SIMPLEX_UNSKEW[3];
+        float dx = x0 - (float)ox + offset;
+        float dy = y0 - (float)oy + offset;
+        float dz = z0 - (float)oz + offset;
+        MCHR_UINT hash = mchr_get_3d_hash_uint(ix + ox, iy + oy, iz + oz, seed);
+        result += mcn_priv_simplex_kernel(dx * dx + dy * dy + dz * dz) * mcn_priv_gradient_3d(hash, dx, dy, dz);
+    }
+    return result * MCN_SIMPLEX_SCALE[3];
+}
+
+MCN_DEF float mcn_simplex_noise_4d( float x, float y, float z, float w, MCHR_UINT seed ) {
+    float s = (x + y + z + w) * MCN_SIMPLEX_SKEW[4];
+    MCHR_INT ix = mcn_priv_floor(x + s);
+    MCHR_INT iy = mcn_priv_floor(y + s);
+    MCHR_INT iz = mcn_priv_floor(z + s);
+    MCHR_INT iw = mcn_priv_floor(w + s);
+    float t = (float)(ix + iy + iz + iw) * MCN_SIMPLEX_UNSKEW[4];
+    float x0 = x - ((float)ix - t);
+    float y0 = y - ((float)iy - t);
+    float z0 = z - ((float)iz - t);
+    float w0 = w - ((float)iw - t);
+    MCHR_INT rx = (x0 > y0) + (x0 > z0) + (x0 > w0);
+    MCHR_INT ry = (y0 >= x0) + (y0 > z0) + (y0 > w0);
+    MCHR_INT rz = (z0 >= x0) + (z0 >= y0) + (z0 > w0);
+    MCHR_INT rw = (w0 >= x0) + (w0 >= y0) + (w0 >= z0);
+
+    float result = 0.0f;
+    for (MCHR_INT v = 0; v <= 4; ++v) {
+        MCHR_INT ox = (rx >= 4 - v);
+        MCHR_INT oy = (ry >= 4 - v);
+        MCHR_INT oz = (rz >= 4 - v);
+        MCHR_INT ow = (rw >= 4 - v);
+        float offset = (float)v * MCN_SIMPLEX_UNSKEW[4];
+        float dx = x0 - (float)ox + offset;
+        float dy = y0 - (float)oy + offset;
+        float dz = z0 - (float)oz + offset;
+        float dw = w0 - (float)ow + offset;
+        MCHR_UINT hash = mchr_get_4d_hash_uint(ix + ox, iy + oy, iz + oz, iw + ow, seed);
+        result += mcn_priv_simplex_kernel(dx * dx + dy * dy + dz * dz + dw * dw) * mcn_priv_gradient_4d(hash, dx, dy, dz, dw);
+    }
+    return result * MCN_SIMPLEX_SCALE[4];
+}
+
+// ---------------------------------------------------------------------------------------
+// Simplex noise, arrays of points. Each chunk finds the skewed cells and simplex ranks of
+//  all points first, then hashes one simplex vertex for all points at a time, adding its
+//  contribution. Operations are done in the same order as in the single point functions,
+//  so results are identical.
+// ---------------------------------------------------------------------------------------
+static void mcn_priv_simplex_noise_chunk(const float* const* coords, MCHR_UINT dims, MCHR_UINT count, MCHR_UINT seed, float* out,
+                                         float* const* deriv) {
+    MCHR_INT cell[4][MCN_CHUNK], rank[4][MCN_CHUNK], corner[4][MCN_CHUNK];
+    float offset[4][MCN_CHUNK], delta[4][MCN_CHUNK];
+    float skew[MCN_CHUNK];
+    MCHR_UINT hashes[MCN_CHUNK];
+
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        skew[i] = coords[0][i];
+    }
+    for (MCHR_UINT d = 1; d < dims; ++d) {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            skew[i] += coords[d][i];
+        }
+    }
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        skew[i] *= MCN_SIMPLEX_SKEW[dims];
+    }
+    for (MCHR_UINT d = 0; d < dims; ++d) {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            cell[d][i] = mcn_priv_floor(coords[d][i] + skew[i]);
+        }
+    }
+    // the unskewed cell origin is reused as the skew array from now on
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        MCHR_INT sum = cell[0][i];
+        for (MCHR_UINT d = 1; d < dims; ++d) {
+            sum += cell[d][i];
+        }
+        skew[i] = (float)sum * MCN_SIMPLEX_UNSKEW[dims];
+    }
+    for (MCHR_UINT d = 0; d < dims; ++d) {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            offset[d][i] = coords[d][i] - ((float)cell[d][i] - skew[i]);
+            rank[d][i] = 0;
+        }
+    }
+    for (MCHR_UINT a = 0; a < dims; ++a) {
+        for (MCHR_UINT b = 0; b < dims; ++b) {
+            if (a < b) {
+                for (MCHR_UINT i = 0; i < count; ++i) {
+                    rank[a][i] += (offset[a][i] > offset[b][i]);
+                }
+            } else if (a > b) {
+                for (MCHR_UINT i = 0; i < count; ++i) {
+                    rank[a][i] += (offset[a][i] >= offset[b][i]);
+                }
+            }
+        }
+    }
+
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        out[i] = 0.0f;
+    }
+    assert(!deriv || dims <= 3);
+    for (MCHR_UINT d = 0; deriv && d < dims; ++d) {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            deriv[d][i] = 0.0f;
+        }
+    }
+    for (MCHR_UINT v = 0; v <= dims; ++v) {
+        const MCHR_INT threshold = (MCHR_INT)(dims - v);
+        const float vertex_offset = (float)v * MCN_SIMPLEX_UNSKEW[dims];
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            for (MCHR_UINT i = 0; i < count; ++i) {
+                MCHR_INT o = (rank[d][i] >= threshold);
+                corner[d][i] = cell[d][i] + o;
+                delta[d][i] = offset[d][i] - (float)o + vertex_offset;
+            }
+        }
+
+        const float* dx = delta[0];
+        const float* dy = delta[1];
+        const float* dz = delta[2];
+        const float* dw = delta[3];
+        if (dims == 2) {
+            mchr_get_2d_hash_uint_batch(corner[0], corner[1], count, seed, hashes);
+            for (MCHR_UINT i = 0; i < count; ++i) {
+                out[i] += mcn_priv_simplex_kernel(dx[i] * dx[i] + dy[i] * dy[i]) * mcn_priv_gradient_2d(hashes[i], dx[i], dy[i]);
+            }
+        } else if (dims == 3) {
+            mchr_get_3d_hash_uint_batch(corner[0], corner[1], corner[2], count, seed, hashes);
+            for (MCHR_UINT i = 0; i < count; ++i) {
+                out[i] += mcn_priv_simplex_kernel(dx[i] * dx[i] + dy[i] * dy[i] + dz[i] * dz[i]) * mcn_priv_gradient_3d(hashes[i], dx[i], dy[i], dz[i]);
+            }
+        } else {
+            mchr_get_4d_hash_uint_batch(corner[0], corner[1], corner[2], corner[3], count, seed, hashes);
+            for (MCHR_UINT i = 0; i < count; ++i) {
+                out[i] += mcn_priv_simplex_kernel(dx[i] * dx[i] + dy[i] * dy[i] + dz[i] * dz[i] + dw[i] * dw[i]) *
+                          mcn_priv_gradient_4d(hashes[i], dx[i], dy[i], dz[i], dw[i]);
+            }
+        }
+
+        // the derivative of t^4 * (g . d), with t = r^2 - |d|^2, is t^4 * g - 8 * t^3 * (g . d) * d
+        if (deriv && dims == 2) {
+            for (MCHR_UINT i = 0; i < count; ++i) {
+                MCHR_UINT h = hashes[i] >> 28;
+                float t = MCN_SIMPLEX_RADIUS2 - (dx[i] * dx[i] + dy[i] * dy[i]);
+                t = 0.5f * (t + fabsf(t));
+                float t3 = t * t * t;
+                float slope = -8.0f * t3 * mcn_priv_gradient_2d(hashes[i], dx[i], dy[i]);
+                deriv[0][i] += t3 * t * MCN_GRADIENT_2D_X[h] + slope * dx[i];
+                deriv[1][i] += t3 * t * MCN_GRADIENT_2D_Y[h] + slope * dy[i];
+            }
+        } else if (deriv) {
+            for (MCHR_UINT i = 0; i < count; ++i) {
+                MCHR_UINT h = hashes[i] >> 28;
+                float t = MCN_SIMPLEX_RADIUS2 - (dx[i] * dx[i] + dy[i] * dy[i] + dz[i] * dz[i]);
+                t = 0.5f * (t + fabsf(t));
+                float t3 = t * t * t;
+                float slope = -8.0f * t3 * mcn_priv_gradient_3d(hashes[i], dx[i], dy[i], dz[i]);
+                deriv[0][i] += t3 * t * MCN_GRADIENT_3D_X[h] + slope * dx[i];
+                deriv[1][i] += t3 * t * MCN_GRADIENT_3D_Y[h] + slope * dy[i];
+                deriv[2][i] += t3 * t * MCN_GRADIENT_3D_Z[h] + slope * dz[i];
+            }
+        }
+    }
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        out[i] *= MCN_SIMPLEX_SCALE[dims];
+    }
+    for (MCHR_UINT d = 0; deriv && d < dims; ++d) {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            deriv[d][i] *= MCN_SIMPLEX_SCALE[dims];
+        }
+    }
+}
+
+static void mcn_priv_simplex_noise_batch(const float* const* coords, MCHR_UINT dims, MCHR_UINT count, MCHR_UINT seed, float* out) {
+    for (MCHR_UINT first = 0; first < count; first += MCN_CHUNK) {
+        MCHR_UINT n = (count - first < MCN_CHUNK) ? count - first : MCN_CHUNK;
+        const float* chunk_coords[4];
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            chunk_coords[d] = coords[d] + first;
+        }
+        mcn_priv_simplex_noise_chunk(chunk_coords, dims, n, seed, out + first, NULL);
+    }
+}
+
+MCN_DEF void mcn_simplex_noise_2d_batch( const float* x, const float* y, MCHR_UINT count, MCHR_UINT seed, float* out ) {
+    const float* coords[2] = { x, y };
+    mcn_priv_simplex_noise_batch(coords, 2, count, seed, out);
+}
+
+MCN_DEF void mcn_simplex_noise_3d_batch( const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT seed, float* out ) {
+    const float* coords[3] = { x, y, z };
+    mcn_priv_simplex_noise_batch(coords, 3, count, seed, out);
+}
+
+MCN_DEF void mcn_simplex_noise_4d_batch( const float* x, const float* y, const float* z, const float* w, MCHR_UINT count, MCHR_UINT seed, float* out ) {
+    const float* coords[4] = { x, y, z, w };
+    mcn_priv_simplex_noise_batch(coords, 4, count, seed, out);
+}
+
+// ---------------------------------------------------------------------------------------
+// Cellular noise. Every lattice cell holds one feature point, placed with the bits of the
+//  cell hash (16 bits per axis in 2D, and 11, 11 and 10 bits in 3D), which is also the id
+//  of the cell. As in most implementations, only the 3x3 (or 3x3x3) cells around the
+//  sample are searched, so with jitters over ~0.65 F2, and very rarely F1, can be slightly
+//  larger than the true distances. Offsets are computed relative to the cell of the
+//  sample, so precision doesn't degrade far from the origin.
+// ---------------------------------------------------------------------------------------
+static float mcn_priv_feature_offset(MCHR_UINT bits, float scale, float jitter) {
+    return 0.5f + jitter * (((float)bits + 0.5f) * scale - 0.5f);
+}
+
+static void mcn_priv_feature_2d(MCHR_UINT hash, float jitter, float* out_x, float* out_y) {
+    *out_x = mcn_priv_feature_offset(hash & 0xffff, 1.0f / 65536.0f, jitter);
+    *out_y = mcn_priv_feature_offset(hash >> 16, 1.0f / 65536.0f, jitter);
+}
+
+static void mcn_priv_feature_3d(MCHR_UINT hash, float jitter, float* out_x, float* out_y, float* out_z) {
+    *out_x = mcn_priv_feature_offset(hash & 0x7ff, 1.0f / 2048.0f, jitter);
+    *out_y = mcn_priv_feature_offset((hash >> 11) & 0x7ff, 1.0f / 2048.0f, jitter);
+    *out_z = mcn_priv_feature_offset(hash >> 22, 1.0f / 1024.0f, jitter);
+}
+
+// Euclidean distances are compared squared, and only the final F1 and F2 are square rooted.
+static float mcn_priv_cellular_distance(mcn_distance_t distance, const float* delta, MCHR_UINT dims) {
+    float result;
+    if (distance == MCN_DISTANCE_MANHATTAN) {
+        result = fabsf(delta[0]);
+        for (MCHR_UINT d = 1; d < dims; ++d) {
+            result += fabsf(delta[d]);
+        }
+    } else if (distance == MCN_DISTANCE_CHEBYSHEV) {
+        result = fabsf(delta[0]);
+        for (MCHR_UINT d = 1; d < dims; ++d) {
+            float a = fabsf(delta[d]);
+            result = (result < a) ? a : result;
+        }
+    } else {
+        result = delta[0] * delta[0];
+        for (MCHR_UINT d = 1; d < dims; ++d) {
+            result += delta[d] * delta[d];
+        }
+    }
+    return result;
+}
+
+// Keeps the two smallest distances, and the hash of the closest point. Ties keep the first.
+static void mcn_priv_cellular_update(float dist, MCHR_UINT hash, float* f1, float* f2, MCHR_UINT* id) {
+    float lo = (dist < *f1) ? dist : *f1;
+    float hi = (dist < *f1) ? *f1 : dist;
+    *f2 = (hi < *f2) ? hi : *f2;
+    *id = (dist < *f1) ? hash : *id;
+    *f1 = lo;
+}
+
+static float mcn_priv_cellular_finish(mcn_distance_t distance, float value) {
+    return (distance == MCN_DISTANCE_EUCLIDEAN) ? sqrtf(value) : value;
+}
+
+MCN_DEF float mcn_cellular_noise_2d( float x, float y, float jitter, mcn_distance_t distance, MCHR_UINT seed, float* out_f2, MCHR_UINT* out_cell_id ) {
+    MCHR_INT ix = mcn_priv_floor(x);
+    MCHR_INT iy = mcn_priv_floor(y);
+    float fx = x - (float)ix;
+    float fy = y - (float)iy;
+
+    float f1 = FLT_MAX, f2 = FLT_MAX;
+    MCHR_UINT id = 0;
+    for (MCHR_INT dy = -1; dy <= 1; ++dy) {
+        for (MCHR_INT dx = -1; dx <= 1; ++dx) {
+            MCHR_UINT hash = mchr_get_2d_hash_uint(ix + dx, iy + dy, seed);
+            float ox, oy;
+            mcn_priv_feature_2d(hash, jitter, &ox, &oy);
+            float delta[2] = { (float)dx + ox - fx, (float)dy + oy - fy };
+            mcn_priv_cellular_update(mcn_priv_cellular_distance(distance, delta, 2), hash, &f1, &f2, &id);
+        }
+    }
+    if (out_f2)
+        *out_f2 = mcn_priv_cellular_finish(distance, f2);
+    if (out_cell_id)
+        *out_cell_id = id;
+    return mcn_priv_cellular_finish(distance, f1);
+}
+
+MCN_DEF float mcn_cellular_noise_3d( float x, float y, float z, float jitter, mcn_distance_t distance, MCHR_UINT seed, float* out_f2, MCHR_UINT* out_cell_id ) {
+    MCHR_INT ix = mcn_priv_floor(x);
+    MCHR_INT iy = mcn_priv_floor(y);
+    MCHR_INT iz = mcn_priv_floor(z);
+    float fx = x - (float)ix;
+    float fy = y - (float)iy;
+    float fz = z - (float)iz;
+
+    float f1 = FLT_MAX, f2 = FLT_MAX;
+    MCHR_UINT id = 0;
+    for (MCHR_INT dz = -1; dz <= 1; ++dz) {
+        for (MCHR_INT dy = -1; dy <= 1; ++dy) {
+            for (MCHR_INT dx = -1; dx <= 1; ++dx) {
+                MCHR_UINT hash = mchr_get_3d_hash_uint(ix + dx, iy + dy, iz + dz, seed);
+                float ox, oy, oz;
+                mcn_priv_feature_3d(hash, jitter, &ox, &oy, &oz);
+                float delta[3] = { (float)dx + ox - fx, (float)dy + oy - fy, (float)dz + oz - fz };
+                mcn_priv_cellular_update(mcn_priv_cellular_distance(distance, delta, 3), hash, &f1, &f2, &id);
+            }
+        }
+    }
+    if (out_f2)
+        *out_f2 = mcn_priv_cellular_finish(distance, f2);
+    if (out_cell_id)
+        *out_cell_id = id;
+    return mcn_priv_cellular_finish(distance, f1);
+}
+
+// ---------------------------------------------------------------------------------------
+// Cellular noise, arrays of points. Candidate cells are visited in the same order as in
+//  the single point functions, one candidate for all the points of a chunk at a time, and
+//  the intermediate results are kept in `mcn_priv_cellular_state_t`.
+// ---------------------------------------------------------------------------------------
+typedef struct mcn_priv_cellular_state_t {
+    float frac[3][MCN_CHUNK];
+    MCHR_UINT hash[MCN_CHUNK];
+    float feature[3][MCN_CHUNK];
+    float delta[3][MCN_CHUNK];
+    float dist[MCN_CHUNK];
+    float f1[MCN_CHUNK];
+    float f2[MCN_CHUNK];
+    MCHR_UINT id[MCN_CHUNK];
+} mcn_priv_cellular_state_t;
+
+static void mcn_priv_cellular_begin(mcn_priv_cellular_state_t* state, MCHR_UINT count) {
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        state->f1[i] = FLT_MAX;
+        state->f2[i] = FLT_MAX;
+        state->id[i] = 0;
+    }
+}
+
+// Computes the feature points inside their cells from the hashes of the cells.
+static void mcn_priv_cellular_features(MCHR_UINT dims, const MCHR_UINT* hashes, float jitter, MCHR_UINT count, float* const* out) {
+    if (dims == 2) {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            mcn_priv_feature_2d(hashes[i], jitter, &out[0][i], &out[1][i]);
+        }
+    } else {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            mcn_priv_feature_3d(hashes[i], jitter, &out[0][i], &out[1][i], &out[2][i]);
+        }
+    }
+}
+
+// Adds the candidate feature points in state->hash and state->feature, which belong to the
+//  cells at (dx, dy, dz) from the ones of the points.
+static void mcn_priv_cellular_candidate(mcn_priv_cellular_state_t* state, MCHR_UINT dims, MCHR_INT dx, MCHR_INT dy, MCHR_INT dz,
+                                        mcn_distance_t distance, MCHR_UINT count) {
+    const MCHR_INT offset[3] = { dx, dy, dz };
+    for (MCHR_UINT d = 0; d < dims; ++d) {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            state->delta[d][i] = (float)offset[d] + state->feature[d][i] - state->frac[d][i];
+        }
+    }
+
+    float* dist = state->dist;
+    if (distance == MCN_DISTANCE_MANHATTAN) {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            dist[i] = fabsf(state->delta[0][i]);
+        }
+        for (MCHR_UINT d = 1; d < dims; ++d) {
+            for (MCHR_UINT i = 0; i < count; ++i) {
+                dist[i] += fabsf(state->delta[d][i]);
+            }
+        }
+    } else if (distance == MCN_DISTANCE_CHEBYSHEV) {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            dist[i] = fabsf(state->delta[0][i]);
+        }
+        for (MCHR_UINT d = 1; d < dims; ++d) {
+            for (MCHR_UINT i = 0; i < count; ++i) {
+                float a = fabsf(state->delta[d][i]);
+                dist[i] = (dist[i] < a) ? a : dist[i];
+            }
+        }
+    } else {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            dist[i] = state->delta[0][i] * state->delta[0][i];
+        }
+        for (MCHR_UINT d = 1; d < dims; ++d) {
+            for (MCHR_UINT i = 0; i < count; ++i) {
+                dist[i] += state->delta[d][i] * state->delta[d][i];
+            }
+        }
+    }
+
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        mcn_priv_cellular_update(dist[i], state->hash[i], &state->f1[i], &state->f2[i], &state->id[i]);
+    }
+}
+
+static void mcn_priv_cellular_end(const mcn_priv_cellular_state_t* state, mcn_distance_t distance, MCHR_UINT count,
+                                  float* out_f1, float* out_f2, MCHR_UINT* out_cell_id) {
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        if (out_f1)
+            out_f1[i] = mcn_priv_cellular_finish(distance, state->f1[i]);
+        if (out_f2)
+            out_f2[i] = mcn_priv_cellular_finish(distance, state->f2[i]);
+        if (out_cell_id)
+            out_cell_id[i] = state->id[i];
+    }
+}
+
+static void mcn_priv_cellular_chunk(const float* const* coords, MCHR_UINT dims, MCHR_UINT count, float jitter, mcn_distance_t distance,
+                                    MCHR_UINT seed, const MCHR_UINT* period, float* out_f1, float* out_f2, MCHR_UINT* out_cell_id) {
+    mcn_priv_cellular_state_t state;
+    // lattice coordinates of the cells at offsets -1, 0 and 1 from the ones of the points
+    MCHR_INT around[3][3][MCN_CHUNK];
+    float* features[3] = { state.feature[0], state.feature[1], state.feature[2] };
+
+    for (MCHR_UINT d = 0; d < dims; ++d) {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            MCHR_INT cell = mcn_priv_floor(coords[d][i]);
+            state.frac[d][i] = coords[d][i] - (float)cell;
+            around[d][0][i] = cell - 1;
+            around[d][1][i] = cell;
+            around[d][2][i] = cell + 1;
+        }
+        for (MCHR_UINT k = 0; period && k < 3; ++k) {
+            mcn_priv_wrap_lattice(around[d][k], count, period[d]);
+        }
+    }
+    mcn_priv_cellular_begin(&state, count);
+
+    const MCHR_INT range_z = (dims == 3) ? 1 : 0;
+    for (MCHR_INT dz = -range_z; dz <= range_z; ++dz) {
+        for (MCHR_INT dy = -1; dy <= 1; ++dy) {
+            for (MCHR_INT dx = -1; dx <= 1; ++dx) {
+                if (dims == 2) {
+                    mchr_get_2d_hash_uint_batch(around[0][dx + 1], around[1][dy + 1], count, seed, state.hash);
+                } else {
+                    mchr_get_3d_hash_uint_batch(around[0][dx + 1], around[1][dy + 1], around[2][dz + 1], count, seed, state.hash);
+                }
+                mcn_priv_cellular_features(dims, state.hash, jitter, count, features);
+                mcn_priv_cellular_candidate(&state, dims, dx, dy, dz, distance, count);
+            }
+        }
+    }
+    mcn_priv_cellular_end(&state, distance, count, out_f1, out_f2, out_cell_id);
+}
+
+static void mcn_priv_cellular_batch(const float* const* coords, MCHR_UINT dims, MCHR_UINT count, float jitter, mcn_distance_t distance,
+                                    MCHR_UINT seed, const MCHR_UINT* period, float* out_f1, float* out_f2, MCHR_UINT* out_cell_id) {
+    for (MCHR_UINT first = 0; first < count; first += MCN_CHUNK) {
+        MCHR_UINT n = (count - first < MCN_CHUNK) ? count - first : MCN_CHUNK;
+        const float* chunk_coords[3];
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            chunk_coords[d] = coords[d] + first;
+        }
+        mcn_priv_cellular_chunk(chunk_coords, dims, n, jitter, distance, seed, period, out_f1 ? out_f1 + first : NULL,
+                                out_f2 ? out_f2 + first : NULL, out_cell_id ? out_cell_id + first : NULL);
+    }
+}
+
+MCN_DEF void mcn_cellular_noise_2d_batch( const float* x, const float* y, MCHR_UINT count, float jitter, mcn_distance_t distance, MCHR_UINT seed,
+                                          float* out_f1, float* out_f2, MCHR_UINT* out_cell_id ) {
+    const float* coords[2] = { x, y };
+    mcn_priv_cellular_batch(coords, 2, count, jitter, distance, seed, NULL, out_f1, out_f2, out_cell_id);
+}
+
+MCN_DEF void mcn_cellular_noise_3d_batch( const float* x, const float* y, const float* z, MCHR_UINT count, float jitter, mcn_distance_t distance, MCHR_UINT seed,
+                                          float* out_f1, float* out_f2, MCHR_UINT* out_cell_id ) {
+    const float* coords[3] = { x, y, z };
+    mcn_priv_cellular_batch(coords, 3, count, jitter, distance, seed, NULL, out_f1, out_f2, out_cell_id);
+}
+
+// ---------------------------------------------------------------------------------------
+// Cellular noise, regular grids. The feature points of a chunk of columns are read from
+//  cached lattice rows, holding the hashes and feature points of the 3 (or 3x3) rows of
+//  cells around the grid row, so each feature point is computed once for all the samples
+//  around it instead of 9 (or 27) times per sample. Rows are kept in slots sorted by
+//  (dz, dy), and moving to the next grid row only recomputes the rows it doesn't share
+//  with the previous one.
+// ---------------------------------------------------------------------------------------
+typedef struct mcn_priv_feature_row_t {
+    mcn_priv_row_cache_t lattice;
+    float feature[3][MCN_ROW_CACHE];
+} mcn_priv_feature_row_t;
+
+static void mcn_priv_cellular_grid(MCHR_UINT dims, float start_x, float start_y, float start_z, float step_x, float step_y, float step_z,
+                                   MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, float jitter, mcn_distance_t distance,
+                                   MCHR_UINT seed, const MCHR_UINT* period, float* out_f1, float* out_f2, MCHR_UINT* out_cell_id) {
+    mcn_priv_feature_row_t storage[9];
+    mcn_priv_feature_row_t* rows[9];
+    const MCHR_UINT slots = (dims == 2) ? 3 : 9;
+
+    for (MCHR_UINT first = 0; first < width; first += MCN_CHUNK) {
+        MCHR_UINT n = (width - first < MCN_CHUNK) ? width - first : MCN_CHUNK;
+        float xs[MCN_CHUNK];
+        MCHR_INT cells[MCN_CHUNK], min_cell;
+        mcn_priv_cellular_state_t state;
+        // lattice points from min_cell - 1 to max_cell + 1
+        MCHR_UINT span = mcn_priv_grid_columns(MCN_PRIV_VALUE, start_x, step_x, first, n, xs, cells, state.frac[0], NULL, &min_cell) + 1;
+        for (MCHR_UINT k = 0; k < slots; ++k) {
+            storage[k].lattice.valid = 0;
+            rows[k] = &storage[k];
+        }
+
+        for (MCHR_UINT s = 0; s < depth; ++s) {
+            float z = start_z + (float)s * step_z;
+            MCHR_INT iz = mcn_priv_floor(z);
+            float fz = z - (float)iz;
+
+            for (MCHR_UINT r = 0; r < height; ++r) {
+                float y = start_y + (float)r * step_y;
+                size_t offset = ((size_t)s * height + r) * width + first;
+                float* f1 = out_f1 ? out_f1 + offset : NULL;
+                float* f2 = out_f2 ? out_f2 + offset : NULL;
+                MCHR_UINT* ids = out_cell_id ? out_cell_id + offset : NULL;
+
+                if (span > MCN_ROW_CACHE) {
+                    float ys[MCN_CHUNK], zs[MCN_CHUNK];
+                    for (MCHR_UINT i = 0; i < n; ++i) {
+                        ys[i] = y;
+                        zs[i] = z;
+                    }
+                    const float* coords[3] = { xs, ys, zs };
+                    mcn_priv_cellular_chunk(coords, dims, n, jitter, distance, seed, period, f1, f2, ids);
+                    continue;
+                }
+
+                MCHR_INT iy = mcn_priv_floor(y);
+                float fy = y - (float)iy;
+                for (MCHR_UINT i = 0; i < n; ++i) {
+                    state.frac[1][i] = fy;
+                    state.frac[2][i] = fz;
+                }
+                mcn_priv_cellular_begin(&state, n);
+
+                for (MCHR_UINT k = 0; k < slots; ++k) {
+                    MCHR_INT dy = (MCHR_INT)(k % 3) - 1;
+                    MCHR_INT dz = (dims == 2) ? 0 : (MCHR_INT)(k / 3) - 1;
+                    MCHR_INT row_z = (dims == 2) ? 0 : iz + dz;
+                    for (MCHR_UINT other = k + 1; other < slots; ++other) {
+                        if (mcn_priv_row_cache_matches(&rows[other]->lattice, min_cell - 1, span, iy + dy, row_z)) {
+                            mcn_priv_feature_row_t* swap = rows[k];
+                            rows[k] = rows[other];
+                            rows[other] = swap;
+                            break;
+                        }
+                    }
+                    mcn_priv_feature_row_t* row = rows[k];
+                    if (!mcn_priv_row_cache_matches(&row->lattice, min_cell - 1, span, iy + dy, row_z)) {
+                        float* features[3] = { row->feature[0], row->feature[1], row->feature[2] };
+                        mcn_priv_row_cache_update(&row->lattice, dims, min_cell - 1, span, iy + dy, row_z, seed, period);
+                        mcn_priv_cellular_features(dims, row->lattice.hashes, jitter, span, features);
+                    }
+
+                    for (MCHR_INT dx = -1; dx <= 1; ++dx) {
+                        for (MCHR_UINT i = 0; i < n; ++i) {
+                            MCHR_UINT column = (MCHR_UINT)(cells[i] - min_cell + 1 + dx);
+                            state.hash[i] = row->lattice.hashes[column];
+                            for (MCHR_UINT d = 0; d < dims; ++d) {
+                                state.feature[d][i] = row->feature[d][column];
+                            }
+                        }
+                        mcn_priv_cellular_candidate(&state, dims, dx, dy, dz, distance, n);
+                    }
+                }
+                mcn_priv_cellular_end(&state, distance, n, f1, f2, ids);
+            }
+        }
+    }
+}
+
+MCN_DEF void mcn_cellular_noise_2d_grid( float start_x, float start_y, float step_x, float step_y, MCHR_UINT width, MCHR_UINT height,
+                                         float jitter, mcn_distance_t distance, MCHR_UINT seed, float* out_f1, float* out_f2, MCHR_UINT* out_cell_id ) {
+    mcn_priv_cellular_grid(2, start_x, start_y, 0.0f, step_x, step_y, 0.0f, width, height, 1, jitter, distance, seed, NULL, out_f1, out_f2, out_cell_id);
+}
+
+MCN_DEF void mcn_cellular_noise_3d_grid( float start_x, float start_y, float start_z, float step_x, float step_y, float step_z,
+                                         MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth,
+                                         float jitter, mcn_distance_t distance, MCHR_UINT seed, float* out_f1, float* out_f2, MCHR_UINT* out_cell_id ) {
+    mcn_priv_cellular_grid(3, start_x, start_y, start_z, step_x, step_y, step_z, width, height, depth, jitter, distance, seed, NULL, out_f1, out_f2, out_cell_id);
+}
+
+// ---------------------------------------------------------------------------------------
+// Fractal noise. Octave seeds are hashes of the octave index with the fractal seed, and
+//  the seeds of the domain warp are hashes of negative indices, so they never overlap.
+// ---------------------------------------------------------------------------------------
+MCN_DEF void mcn_fractal_init( mcn_fractal_t* fractal, mcn_noise_type_t noise, mcn_fractal_type_t type, MCHR_UINT octaves ) {
+    assert(fractal);
+    assert(octaves > 0);
+    fractal->noise = noise;
+    fractal->type = type;
+    fractal->octaves = octaves;
+    fractal->frequency = 1.0f;
+    fractal->lacunarity = 2.0f;
+    fractal->gain = 0.5f;
+    fractal->warp_amplitude = 0.0f;
+    fractal->warp_frequency = 1.0f;
+}
+
+MCN_DEF MCHR_UINT mcn_get_octave_seed( MCHR_UINT seed, MCHR_UINT octave ) {
+    return (octave == 0) ? seed : mchr_get_1d_hash_uint((MCHR_INT)octave, seed);
+}
+
+static MCHR_UINT mcn_priv_warp_seed(MCHR_UINT seed, MCHR_UINT axis) {
+    return mchr_get_1d_hash_uint(-1 - (MCHR_INT)axis, seed);
+}
+
+static float mcn_priv_fractal_shape(mcn_fractal_type_t type, float value) {
+    if (type == MCN_FRACTAL_BILLOW)
+        return 2.0f * fabsf(value) - 1.0f;
+    if (type == MCN_FRACTAL_RIDGED) {
+        float ridge = 1.0f - fabsf(value);
+        return 2.0f * ridge * ridge - 1.0f;
+    }
+    return value;
+}
+
+static float mcn_priv_base_noise(mcn_noise_type_t noise, const float* p, MCHR_UINT dims, MCHR_UINT seed) {
+    if (dims == 2) {
+        if (noise == MCN_NOISE_VALUE)
+            return mcn_value_noise_2d(p[0], p[1], seed);
+        if (noise == MCN_NOISE_GRADIENT)
+            return mcn_gradient_noise_2d(p[0], p[1], seed);
+        return mcn_simplex_noise_2d(p[0], p[1], seed);
+    }
+    if (noise == MCN_NOISE_VALUE)
+        return mcn_value_noise_3d(p[0], p[1], p[2], seed);
+    if (noise == MCN_NOISE_GRADIENT)
+        return mcn_gradient_noise_3d(p[0], p[1], p[2], seed);
+    return mcn_simplex_noise_3d(p[0], p[1], p[2], seed);
+}
+
+static float mcn_priv_fractal_noise(const mcn_fractal_t* fractal, const float* coords, MCHR_UINT dims, MCHR_UINT seed) {
+    assert(fractal && fractal->octaves > 0);
+    float p[3], q[3];
+    for (MCHR_UINT d = 0; d < dims; ++d) {
+        p[d] = coords[d];
+    }
+    if (fractal->warp_amplitude != 0.0f) {
+        float offset[3];
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            q[d] = p[d] * fractal->warp_frequency;
+        }
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            offset[d] = mcn_priv_base_noise(fractal->noise, q, dims, mcn_priv_warp_seed(seed, d));
+        }
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            p[d] += fractal->warp_amplitude * offset[d];
+        }
+    }
+
+    float sum = 0.0f, total = 0.0f;
+    float frequency = fractal->frequency, amplitude = 1.0f;
+    for (MCHR_UINT octave = 0; octave < fractal->octaves; ++octave) {
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            q[d] = p[d] * frequency;
+        }
+        float value = mcn_priv_base_noise(fractal->noise, q, dims, mcn_get_octave_seed(seed, octave));
+        sum += amplitude * mcn_priv_fractal_shape(fractal->type, value);
+        total += amplitude;
+        frequency *= fractal->lacunarity;
+        amplitude *= fractal->gain;
+    }
+    return sum / total;
+}
+
+MCN_DEF float mcn_fractal_noise_2d( const mcn_fractal_t* fractal, float x, float y, MCHR_UINT seed ) {
+    const float coords[2] = { x, y };
+    return mcn_priv_fractal_noise(fractal, coords, 2, seed);
+}
+
+MCN_DEF float mcn_fractal_noise_3d( const mcn_fractal_t* fractal, float x, float y, float z, MCHR_UINT seed ) {
+    const float coords[3] = { x, y, z };
+    return mcn_priv_fractal_noise(fractal, coords, 3, seed);
+}
+
+// ---------------------------------------------------------------------------------------
+// Fractal noise, arrays of points. All the octaves of a chunk of points are evaluated
+//  before moving to the next chunk, so the coordinates, octave values and sums stay in L1
+//  cache, and every octave goes through the vectorized chunk functions of its base noise.
+// ---------------------------------------------------------------------------------------
+static void mcn_priv_base_noise_chunk(mcn_noise_type_t noise, const float* const* coords, MCHR_UINT dims,
+                                      MCHR_UINT count, MCHR_UINT seed, const MCHR_UINT* period, float* out, float* const* deriv) {
+    if (noise == MCN_NOISE_SIMPLEX) {
+        assert(!period && "simplex noise is not periodic");
+        mcn_priv_simplex_noise_chunk(coords, dims, count, seed, out, deriv);
+    } else {
+        mcn_priv_lattice_kind_t kind = (noise == MCN_NOISE_VALUE) ? MCN_PRIV_VALUE : MCN_PRIV_GRADIENT;
+        mcn_priv_lattice_noise_chunk(kind, coords, dims, count, seed, period, out, deriv);
+    }
+}
+
+// Periods of the lattice of a noise sampled at the given frequency, rounded to integers.
+static void mcn_priv_scale_period(const MCHR_UINT* period, MCHR_UINT dims, float frequency, MCHR_UINT* out) {
+    for (MCHR_UINT d = 0; period && d < dims; ++d) {
+        out[d] = (MCHR_UINT)((float)period[d] * frequency + 0.5f);
+    }
+}
+
+static void mcn_priv_fractal_noise_chunk(const mcn_fractal_t* fractal, const float* const* coords, MCHR_UINT dims,
+                                         MCHR_UINT count, MCHR_UINT seed, const MCHR_UINT* period, float* out, float* const* deriv) {
+    float warped[3][MCN_CHUNK], scaled[3][MCN_CHUNK];
+    float value[MCN_CHUNK], sum[MCN_CHUNK];
+    // derivatives of the warp offsets (jacobian of the warped position) and of the octaves
+    float warp_deriv[3][3][MCN_CHUNK], value_deriv[3][MCN_CHUNK];
+    float* value_deriv_ptr[3] = { value_deriv[0], value_deriv[1], value_deriv[2] };
+    const float* p[3] = { coords[0], coords[1], dims > 2 ? coords[2] : NULL };
+    const float* q[3] = { scaled[0], scaled[1], scaled[2] };
+    const int warp = (fractal->warp_amplitude != 0.0f);
+    // periods of the lattices of the octaves (and the warp), in their own scaled units
+    MCHR_UINT octave_period[3];
+    const MCHR_UINT* scaled_period = period ? octave_period : NULL;
+
+    if (warp) {
+        mcn_priv_scale_period(period, dims, fractal->warp_frequency, octave_period);
+        float offset[3][MCN_CHUNK];
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            for (MCHR_UINT i = 0; i < count; ++i) {
+                scaled[d][i] = p[d][i] * fractal->warp_frequency;
+            }
+        }
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            float* offset_deriv[3] = { warp_deriv[d][0], warp_deriv[d][1], warp_deriv[d][2] };
+            mcn_priv_base_noise_chunk(fractal->noise, q, dims, count, mcn_priv_warp_seed(seed, d), scaled_period, offset[d], deriv ? offset_deriv : NULL);
+        }
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            for (MCHR_UINT i = 0; i < count; ++i) {
+                warped[d][i] = p[d][i] + fractal->warp_amplitude * offset[d][i];
+            }
+            p[d] = warped[d];
+        }
+        // d(warped_d)/d(x_e) = [d == e] + amplitude * warp_frequency * d(offset_d)/d(q_e)
+        const float scale = fractal->warp_amplitude * fractal->warp_frequency;
+        for (MCHR_UINT d = 0; deriv && d < dims; ++d) {
+            for (MCHR_UINT e = 0; e < dims; ++e) {
+                for (MCHR_UINT i = 0; i < count; ++i) {
+                    warp_deriv[d][e][i] = scale * warp_deriv[d][e][i] + ((d == e) ? 1.0f : 0.0f);
+                }
+            }
+        }
+    }
+
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        sum[i] = 0.0f;
+    }
+    for (MCHR_UINT d = 0; deriv && d < dims; ++d) {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            deriv[d][i] = 0.0f;
+        }
+    }
+    float total = 0.0f;
+    float frequency = fractal->frequency, amplitude = 1.0f;
+    for (MCHR_UINT octave = 0; octave < fractal->octaves; ++octave) {
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            for (MCHR_UINT i = 0; i < count; ++i) {
+                scaled[d][i] = p[d][i] * frequency;
+            }
+        }
+        mcn_priv_scale_period(period, dims, frequency, octave_period);
+        mcn_priv_base_noise_chunk(fractal->noise, q, dims, count, mcn_get_octave_seed(seed, octave), scaled_period,
+                                  value, deriv ? value_deriv_ptr : NULL);
+        if (deriv) {
+            // chain rule through the shape of the octave, its frequency and the warp, in
+            //  value_deriv before the shape changes the values
+            float chain[MCN_CHUNK];
+            for (MCHR_UINT i = 0; i < count; ++i) {
+                float sign = (value[i] < 0.0f) ? -1.0f : 1.0f;
+                float shape = (fractal->type == MCN_FRACTAL_BILLOW) ? 2.0f * sign
+                            : ((fractal->type == MCN_FRACTAL_RIDGED) ? -4.0f * (1.0f - fabsf(value[i])) * sign : 1.0f);
+                chain[i] = amplitude * frequency * shape;
+            }
+            for (MCHR_UINT e = 0; e < dims; ++e) {
+                for (MCHR_UINT i = 0; i < count; ++i) {
+                    float d_value = value_deriv[e][i];
+                    if (warp) {
+                        d_value = 0.0f;
+                        for (MCHR_UINT d = 0; d < dims; ++d) {
+                            d_value += value_deriv[d][i] * warp_deriv[d][e][i];
+                        }
+                    }
+                    deriv[e][i] += chain[i] * d_value;
+                }
+            }
+        }
+        switch (fractal->type) {
+        case MCN_FRACTAL_BILLOW:
+            for (MCHR_UINT i = 0; i < count; ++i) {
+                sum[i] += amplitude * (2.0f * fabsf(value[i]) - 1.0f);
+            }
+            break;
+        case MCN_FRACTAL_RIDGED:
+            for (MCHR_UINT i = 0; i < count; ++i) {
+                float ridge = 1.0f - fabsf(value[i]);
+                sum[i] += amplitude * (2.0f * ridge * ridge - 1.0f);
+            }
+            break;
+        default:
+            for (MCHR_UINT i = 0; i < count; ++i) {
+                sum[i] += amplitude * value[i];
+            }
+            break;
+        }
+        total += amplitude;
+        frequency *= fractal->lacunarity;
+        amplitude *= fractal->gain;
+    }
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        out[i] = sum[i] / total;
+    }
+    for (MCHR_UINT d = 0; deriv && d < dims; ++d) {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            deriv[d][i] /= total;
+        }
+    }
+}
+
+static void mcn_priv_fractal_noise_batch(const mcn_fractal_t* fractal, const float* const* coords, MCHR_UINT dims,
+                                         MCHR_UINT count, MCHR_UINT seed, const MCHR_UINT* period, float* out) {
+    assert(fractal && fractal->octaves > 0);
+    for (MCHR_UINT first = 0; first < count; first += MCN_CHUNK) {
+        MCHR_UINT n = (count - first < MCN_CHUNK) ? count - first : MCN_CHUNK;
+        const float* chunk_coords[3];
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            chunk_coords[d] = coords[d] + first;
+        }
+        mcn_priv_fractal_noise_chunk(fractal, chunk_coords, dims, n, seed, period, out + first, NULL);
+    }
+}
+
+MCN_DEF void mcn_fractal_noise_2d_batch( const mcn_fractal_t* fractal, const float* x, const float* y, MCHR_UINT count, MCHR_UINT seed, float* out ) {
+    const float* coords[2] = { x, y };
+    mcn_priv_fractal_noise_batch(fractal, coords, 2, count, seed, NULL, out);
+}
+
+MCN_DEF void mcn_fractal_noise_3d_batch( const mcn_fractal_t* fractal, const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT seed, float* out ) {
+    const float* coords[3] = { x, y, z };
+    mcn_priv_fractal_noise_batch(fractal, coords, 3, count, seed, NULL, out);
+}
+
+// ---------------------------------------------------------------------------------------
+// Fractal noise, regular grids. Every octave samples its base noise at a different
+//  frequency (and through the warp, at irregular positions), so the grid is evaluated
+//  as rows of chunks of points instead of reusing lattice rows.
+// ---------------------------------------------------------------------------------------
+static void mcn_priv_fractal_noise_grid(const mcn_fractal_t* fractal, MCHR_UINT dims, float start_x, float start_y, float start_z,
+                                        float step_x, float step_y, float step_z, MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth,
+                                        MCHR_UINT seed, const MCHR_UINT* period, float* out) {
+    assert(fractal && fractal->octaves > 0);
+    for (MCHR_UINT first = 0; first < width; first += MCN_CHUNK) {
+        MCHR_UINT n = (width - first < MCN_CHUNK) ? width - first : MCN_CHUNK;
+        float xs[MCN_CHUNK], ys[MCN_CHUNK], zs[MCN_CHUNK];
+        const float* coords[3] = { xs, ys, zs };
+        for (MCHR_UINT i = 0; i < n; ++i) {
+            xs[i] = start_x + (float)(first + i) * step_x;
+        }
+        for (MCHR_UINT s = 0; s < depth; ++s) {
+            float z = start_z + (float)s * step_z;
+            for (MCHR_UINT r = 0; r < height; ++r) {
+                float y = start_y + (float)r * step_y;
+                for (MCHR_UINT i = 0; i < n; ++i) {
+                    ys[i] = y;
+                    zs[i] = z;
+                }
+                mcn_priv_fractal_noise_chunk(fractal, coords, dims, n, seed, period, out + ((size_t)s * height + r) * width + first, NULL);
+            }
+        }
+    }
+}
+
+MCN_DEF void mcn_fractal_noise_2d_grid( const mcn_fractal_t* fractal, float start_x, float start_y, float step_x, float step_y,
+                                        MCHR_UINT width, MCHR_UINT height, MCHR_UINT seed, float* out ) {
+    mcn_priv_fractal_noise_grid(fractal, 2, start_x, start_y, 0.0f, step_x, step_y, 0.0f, width, height, 1, seed, NULL, out);
+}
+
+MCN_DEF void mcn_fractal_noise_3d_grid( const mcn_fractal_t* fractal, float start_x, float start_y, float start_z, float step_x, float step_y, float step_z,
+                                        MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT seed, float* out ) {
+    mcn_priv_fractal_noise_grid(fractal, 3, start_x, start_y, start_z, step_x, step_y, step_z, width, height, depth, seed, NULL, out);
+}
+
+// ---------------------------------------------------------------------------------------
+// Noise graphs. Nodes always come after their inputs, so the array is already in
+//  evaluation order. Compiling marks the nodes the output depends on, fuses every
+//  multiplication only used by an addition into a multiply-add, and assigns chunk buffers
+//  like registers, reusing the ones of nodes that are not needed anymore, so a long chain
+//  of operations runs over a handful of L1-resident buffers. Constants get a buffer filled
+//  once per evaluation.
+// ---------------------------------------------------------------------------------------
+MCN_DEF void mcn_graph_init( mcn_graph_t* graph, mcn_graph_node_t* nodes, MCHR_UINT capacity ) {
+    assert(graph);
+    assert(nodes || capacity == 0);
+    graph->nodes = nodes;
+    graph->capacity = capacity;
+    graph->count = 0;
+    graph->output = MCN_GRAPH_NONE;
+    graph->buffer_count = 0;
+    graph->uses_z = 0;
+}
+
+static int mcn_priv_graph_is_coordinate(mcn_graph_op_t op) {
+    return op <= MCN_GRAPH_Z;
+}
+
+static int mcn_priv_graph_is_elementwise(mcn_graph_op_t op) {
+    return op >= MCN_GRAPH_ADD && op <= MCN_GRAPH_CURVE;
+}
+
+static MCHR_UINT mcn_priv_graph_input_count(mcn_graph_op_t op, const MCHR_UINT* inputs) {
+    switch (op) {
+    case MCN_GRAPH_X:
+    case MCN_GRAPH_Y:
+    case MCN_GRAPH_Z:
+    case MCN_GRAPH_CONSTANT:
+        return 0;
+    case MCN_GRAPH_ABS:
+    case MCN_GRAPH_CLAMP:
+    case MCN_GRAPH_CURVE:
+        return 1;
+    case MCN_GRAPH_MAD:
+    case MCN_GRAPH_MIX:
+        return 3;
+    case MCN_GRAPH_NOISE:
+    case MCN_GRAPH_FRACTAL:
+        return (inputs[2] == MCN_GRAPH_NONE) ? 2 : 3;
+    default:
+        return 2;
+    }
+}
+
+// Runs the operation of a node for up to MCN_CHUNK values. `out` never aliases the inputs.
+static void mcn_priv_graph_kernel(const mcn_graph_node_t* node, mcn_graph_op_t op, const float* const* in, MCHR_UINT dims,
+                                  MCHR_UINT count, MCHR_UINT seed, float* out) {
+    const float* a = in[0];
+    const float* b = in[1];
+    const float* c = in[2];
+    switch (op) {
+    case MCN_GRAPH_ADD:
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            out[i] = a[i] + b[i];
+        }
+        break;
+    case MCN_GRAPH_SUB:
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            out[i] = a[i] - b[i];
+        }
+        break;
+    case MCN_GRAPH_MUL:
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            out[i] = a[i] * b[i];
+        }
+        break;
+    case MCN_GRAPH_MAD:
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            out[i] = a[i] * b[i] + c[i];
+        }
+        break;
+    case MCN_GRAPH_MIN:
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            out[i] = (b[i] < a[i]) ? b[i] : a[i];
+        }
+        break;
+    case MCN_GRAPH_MAX:
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            out[i] = (a[i] < b[i]) ? b[i] : a[i];
+        }
+        break;
+    case MCN_GRAPH_ABS:
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            out[i] = fabsf(a[i]);
+        }
+        break;
+    case MCN_GRAPH_MIX:
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            out[i] = mcn_priv_lerp(a[i], b[i], c[i]);
+        }
+        break;
+    case MCN_GRAPH_CLAMP: {
+        const float lo = node->values[0], hi = node->values[1];
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            float v = (a[i] < lo) ? lo : a[i];
+            out[i] = (hi < v) ? hi : v;
+        }
+        break;
+    }
+    case MCN_GRAPH_CURVE: {
+        // the first y plus the rise of every segment times the part of it below the value,
+        //  so there's no search for the segment; zero-width segments are steps, taken by
+        //  values from their x on
+        const float* px = node->curve_x;
+        const float* py = node->curve_y;
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            out[i] = py[0];
+        }
+        for (MCHR_UINT k = 0; k + 1 < node->curve_count; ++k) {
+            const float x0 = px[k];
+            const float rise = py[k + 1] - py[k];
+            if (!(x0 < px[k + 1])) {
+                for (MCHR_UINT i = 0; i < count; ++i) {
+                    out[i] += (a[i] >= x0) ? rise : 0.0f;
+                }
+                continue;
+            }
+            const float inv_width = 1.0f / (px[k + 1] - x0);
+            for (MCHR_UINT i = 0; i < count; ++i) {
+                float t = (a[i] - x0) * inv_width;
+                t = (t < 0.0f) ? 0.0f : t;
+                t = (1.0f < t) ? 1.0f : t;
+                out[i] += rise * t;
+            }
+        }
+        break;
+    }
+    case MCN_GRAPH_NOISE:
+        mcn_priv_base_noise_chunk(node->noise, in, dims, count, seed, NULL, out, NULL);
+        break;
+    case MCN_GRAPH_FRACTAL:
+        mcn_priv_fractal_noise_chunk(&node->fractal, in, dims, count, seed, NULL, out, NULL);
+        break;
+    default:
+        assert(0 && "not a kernel operation");
+        break;
+    }
+}
+
+static int mcn_priv_graph_equal(const mcn_graph_node_t* a, const mcn_graph_node_t* b) {
+    if (a->op != b->op || a->seed != b->seed || a->inputs[0] != b->inputs[0] || a->inputs[1] != b->inputs[1] || a->inputs[2] != b->inputs[2])
+        return 0;
+    // bitwise, so that 0 and -0 are different constants
+    if (memcmp(a->values, b->values, sizeof(a->values)) != 0)
+        return 0;
+    if (a->op == MCN_GRAPH_NOISE)
+        return a->noise == b->noise;
+    if (a->op == MCN_GRAPH_FRACTAL) {
+        const mcn_fractal_t* fa = &a->fractal;
+        const mcn_fractal_t* fb = &b->fractal;
+        return fa->noise == fb->noise && fa->type == fb->type && fa->octaves == fb->octaves && fa->frequency == fb->frequency &&
+               fa->lacunarity == fb->lacunarity && fa->gain == fb->gain && fa->warp_amplitude == fb->warp_amplitude &&
+               fa->warp_frequency == fb->warp_frequency;
+    }
+    if (a->op == MCN_GRAPH_CURVE)
+        return a->curve_x == b->curve_x && a->curve_y == b->curve_y && a->curve_count == b->curve_count;
+    return 1;
+}
+
+static mcn_graph_node_t mcn_priv_graph_node(mcn_graph_op_t op, MCHR_UINT a, MCHR_UINT b, MCHR_UINT c) {
+    mcn_graph_node_t node;
+    memset(&node, 0, sizeof(node));
+    node.op = op;
+    node.inputs[0] = a;
+    node.inputs[1] = b;
+    node.inputs[2] = c;
+    return node;
+}
+
+// Adds a node unless there's an identical one already (common subexpression elimination).
+//  Element-wise operations on constants are evaluated right away.
+static MCHR_UINT mcn_priv_graph_add(mcn_graph_t* graph, const mcn_graph_node_t* node) {
+    assert(graph);
+    const MCHR_UINT inputs = mcn_priv_graph_input_count(node->op, node->inputs);
+    int constant = mcn_priv_graph_is_elementwise(node->op);
+    for (MCHR_UINT k = 0; k < inputs; ++k) {
+        if (node->inputs[k] >= graph->count)
+            return MCN_GRAPH_NONE;
+        constant = constant && graph->nodes[node->inputs[k]].op == MCN_GRAPH_CONSTANT;
+    }
+    if (constant) {
+        const float* in[3] = { NULL, NULL, NULL };
+        float value;
+        for (MCHR_UINT k = 0; k < inputs; ++k) {
+            in[k] = graph->nodes[node->inputs[k]].values;
+        }
+        mcn_priv_graph_kernel(node, node->op, in, 0, 1, 0, &value);
+        return mcn_graph_constant(graph, value);
+    }
+
+    for (MCHR_UINT k = 0; k < graph->count; ++k) {
+        if (mcn_priv_graph_equal(&graph->nodes[k], node))
+            return k;
+    }
+    if (graph->count == graph->capacity)
+        return MCN_GRAPH_NONE;
+    graph->nodes[graph->count] = *node;
+    return graph->count++;
+}
+
+// Additions and multiplications are commutative in IEEE 754 too, so their inputs are
+//  sorted to find more common subexpressions.
+static MCHR_UINT mcn_priv_graph_binary(mcn_graph_t* graph, mcn_graph_op_t op, MCHR_UINT a, MCHR_UINT b) {
+    if ((op == MCN_GRAPH_ADD || op == MCN_GRAPH_MUL) && b < a) {
+        MCHR_UINT swap = a;
+        a = b;
+        b = swap;
+    }
+    mcn_graph_node_t node = mcn_priv_graph_node(op, a, b, MCN_GRAPH_NONE);
+    return mcn_priv_graph_add(graph, &node);
+}
+
+MCN_DEF MCHR_UINT mcn_graph_x( mcn_graph_t* graph ) {
+    mcn_graph_node_t node = mcn_priv_graph_node(MCN_GRAPH_X, MCN_GRAPH_NONE, MCN_GRAPH_NONE, MCN_GRAPH_NONE);
+    return mcn_priv_graph_add(graph, &node);
+}
+
+MCN_DEF MCHR_UINT mcn_graph_y( mcn_graph_t* graph ) {
+    mcn_graph_node_t node = mcn_priv_graph_node(MCN_GRAPH_Y, MCN_GRAPH_NONE, MCN_GRAPH_NONE, MCN_GRAPH_NONE);
+    return mcn_priv_graph_add(graph, &node);
+}
+
+MCN_DEF MCHR_UINT mcn_graph_z( mcn_graph_t* graph ) {
+    mcn_graph_node_t node = mcn_priv_graph_node(MCN_GRAPH_Z, MCN_GRAPH_NONE, MCN_GRAPH_NONE, MCN_GRAPH_NONE);
+    return mcn_priv_graph_add(graph, &node);
+}
+
+MCN_DEF MCHR_UINT mcn_graph_constant( mcn_graph_t* graph, float value ) {
+    mcn_graph_node_t node = mcn_priv_graph_node(MCN_GRAPH_CONSTANT, MCN_GRAPH_NONE, MCN_GRAPH_NONE, MCN_GRAPH_NONE);
+    node.values[0] = value;
+    return mcn_priv_graph_add(graph, &node);
+}
+
+MCN_DEF MCHR_UINT mcn_graph_add( mcn_graph_t* graph, MCHR_UINT a, MCHR_UINT b ) {
+    return mcn_priv_graph_binary(graph, MCN_GRAPH_ADD, a, b);
+}
+
+MCN_DEF MCHR_UINT mcn_graph_sub( mcn_graph_t* graph, MCHR_UINT a, MCHR_UINT b ) {
+    return mcn_priv_graph_binary(graph, MCN_GRAPH_SUB, a, b);
+}
+
+MCN_DEF MCHR_UINT mcn_graph_mul( mcn_graph_t* graph, MCHR_UINT a, MCHR_UINT b ) {
+    return mcn_priv_graph_binary(graph, MCN_GRAPH_MUL, a, b);
+}
+
+MCN_DEF MCHR_UINT mcn_graph_min( mcn_graph_t* graph, MCHR_UINT a, MCHR_UINT b ) {
+    return mcn_priv_graph_binary(graph, MCN_GRAPH_MIN, a, b);
+}
+
+MCN_DEF MCHR_UINT mcn_graph_max( mcn_graph_t* graph, MCHR_UINT a, MCHR_UINT b ) {
+    return mcn_priv_graph_binary(graph, MCN_GRAPH_MAX, a, b);
+}
+
+MCN_DEF MCHR_UINT mcn_graph_abs( mcn_graph_t* graph, MCHR_UINT a ) {
+    mcn_graph_node_t node = mcn_priv_graph_node(MCN_GRAPH_ABS, a, MCN_GRAPH_NONE, MCN_GRAPH_NONE);
+    return mcn_priv_graph_add(graph, &node);
+}
+
+MCN_DEF MCHR_UINT mcn_graph_mix( mcn_graph_t* graph, MCHR_UINT a, MCHR_UINT b, MCHR_UINT t ) {
+    mcn_graph_node_t node = mcn_priv_graph_node(MCN_GRAPH_MIX, a, b, t);
+    return mcn_priv_graph_add(graph, &node);
+}
+
+MCN_DEF MCHR_UINT mcn_graph_clamp( mcn_graph_t* graph, MCHR_UINT a, float min, float max ) {
+    assert(min <= max);
+    mcn_graph_node_t node = mcn_priv_graph_node(MCN_GRAPH_CLAMP, a, MCN_GRAPH_NONE, MCN_GRAPH_NONE);
+    node.values[0] = min;
+    node.values[1] = max;
+    return mcn_priv_graph_add(graph, &node);
+}
+
+MCN_DEF MCHR_UINT mcn_graph_curve( mcn_graph_t* graph, MCHR_UINT a, const float* points_x, const float* points_y, MCHR_UINT count ) {
+    assert(points_x && points_y && count > 0);
+    mcn_graph_node_t node = mcn_priv_graph_node(MCN_GRAPH_CURVE, a, MCN_GRAPH_NONE, MCN_GRAPH_NONE);
+    node.curve_x = points_x;
+    node.curve_y = points_y;
+    node.curve_count = count;
+    return mcn_priv_graph_add(graph, &node);
+}
+
+MCN_DEF MCHR_UINT mcn_graph_noise_2d( mcn_graph_t* graph, mcn_noise_type_t noise, MCHR_UINT x, MCHR_UINT y, MCHR_UINT seed ) {
+    mcn_graph_node_t node = mcn_priv_graph_node(MCN_GRAPH_NOISE, x, y, MCN_GRAPH_NONE);
+    node.noise = noise;
+    node.seed = seed;
+    return mcn_priv_graph_add(graph, &node);
+}
+
+MCN_DEF MCHR_UINT mcn_graph_noise_3d( mcn_graph_t* graph, mcn_noise_type_t noise, MCHR_UINT x, MCHR_UINT y, MCHR_UINT z, MCHR_UINT seed ) {
+    assert(z != MCN_GRAPH_NONE);
+    mcn_graph_node_t node = mcn_priv_graph_node(MCN_GRAPH_NOISE, x, y, z);
+    node.noise = noise;
+    node.seed = seed;
+    return mcn_priv_graph_add(graph, &node);
+}
+
+MCN_DEF MCHR_UINT mcn_graph_fractal_2d( mcn_graph_t* graph, const mcn_fractal_t* fractal, MCHR_UINT x, MCHR_UINT y, MCHR_UINT seed ) {
+    assert(fractal && fractal->octaves > 0);
+    mcn_graph_node_t node = mcn_priv_graph_node(MCN_GRAPH_FRACTAL, x, y, MCN_GRAPH_NONE);
+    node.fractal = *fractal;
+    node.seed = seed;
+    return mcn_priv_graph_add(graph, &node);
+}
+
+MCN_DEF MCHR_UINT mcn_graph_fractal_3d( mcn_graph_t* graph, const mcn_fractal_t* fractal, MCHR_UINT x, MCHR_UINT y, MCHR_UINT z, MCHR_UINT seed ) {
+    assert(fractal && fractal->octaves > 0);
+    assert(z != MCN_GRAPH_NONE);
+    mcn_graph_node_t node = mcn_priv_graph_node(MCN_GRAPH_FRACTAL, x, y, z);
+    node.fractal = *fractal;
+    node.seed = seed;
+    return mcn_priv_graph_add(graph, &node);
+}
+
+static void mcn_priv_graph_count_uses(mcn_graph_t* graph) {
+    for (MCHR_UINT k = 0; k < graph->count; ++k) {
+        graph->nodes[k].uses = 0;
+    }
+    for (MCHR_UINT k = 0; k < graph->count; ++k) {
+        const mcn_graph_node_t* node = &graph->nodes[k];
+        if (!node->live)
+            continue;
+        for (MCHR_UINT j = 0; j < mcn_priv_graph_input_count(node->kernel_op, node->kernel_inputs); ++j) {
+            graph->nodes[node->kernel_inputs[j]].uses++;
+        }
+    }
+}
+
+MCN_DEF int mcn_graph_compile( mcn_graph_t* graph, MCHR_UINT output ) {
+    assert(graph);
+    assert(output < graph->count);
+    mcn_graph_node_t* nodes = graph->nodes;
+    graph->output = MCN_GRAPH_NONE;
+
+    // nodes the output depends on
+    for (MCHR_UINT k = 0; k < graph->count; ++k) {
+        mcn_graph_node_t* node = &nodes[k];
+        node->kernel_op = node->op;
+        node->kernel_inputs[0] = node->inputs[0];
+        node->kernel_inputs[1] = node->inputs[1];
+        node->kernel_inputs[2] = node->inputs[2];
+        node->buffer = MCN_GRAPH_NONE;
+        node->live = (k == output);
+    }
+    for (MCHR_UINT k = output + 1; k-- > 0;) {
+        if (!nodes[k].live)
+            continue;
+        for (MCHR_UINT j = 0; j < mcn_priv_graph_input_count(nodes[k].op, nodes[k].inputs); ++j) {
+            nodes[nodes[k].inputs[j]].live = 1;
+        }
+    }
+
+    // a * b + c, when the product isn't used anywhere else
+    mcn_priv_graph_count_uses(graph);
+    for (MCHR_UINT k = 0; k <= output; ++k) {
+        mcn_graph_node_t* node = &nodes[k];
+        if (!node->live || node->op != MCN_GRAPH_ADD)
+            continue;
+        for (MCHR_UINT j = 0; j < 2; ++j) {
+            mcn_graph_node_t* product = &nodes[node->inputs[j]];
+            if (product->op == MCN_GRAPH_MUL && product->uses == 1 && node->inputs[j] != output) {
+                node->kernel_op = MCN_GRAPH_MAD;
+                node->kernel_inputs[0] = product->inputs[0];
+                node->kernel_inputs[1] = product->inputs[1];
+                node->kernel_inputs[2] = node->inputs[1 - j];
+                product->live = 0;
+                break;
+            }
+        }
+    }
+    mcn_priv_graph_count_uses(graph);
+
+    // buffers: first the constants, which keep theirs, then the other nodes in evaluation
+    //  order. The output is written directly to the results, and the coordinates are read
+    //  from the arguments.
+    int used[MCN_GRAPH_MAX_BUFFERS] = { 0 };
+    MCHR_UINT buffer_count = 0;
+    graph->uses_z = 0;
+    for (int constants = 1; constants >= 0; --constants) {
+        for (MCHR_UINT k = 0; k <= output; ++k) {
+            mcn_graph_node_t* node = &nodes[k];
+            if (!node->live || (node->op == MCN_GRAPH_CONSTANT) != constants)
+                continue;
+            graph->uses_z |= (node->op == MCN_GRAPH_Z);
+            if (mcn_priv_graph_is_coordinate(node->op))
+                continue;
+            if (k != output || constants) {
+                MCHR_UINT b = 0;
+                while (b < MCN_GRAPH_MAX_BUFFERS && used[b])
+                    ++b;
+                if (b == MCN_GRAPH_MAX_BUFFERS)
+                    return 0;
+                used[b] = 1;
+                node->buffer = b;
+                buffer_count = (b + 1 > buffer_count) ? b + 1 : buffer_count;
+            }
+            for (MCHR_UINT j = 0; j < mcn_priv_graph_input_count(node->kernel_op, node->kernel_inputs); ++j) {
+                mcn_graph_node_t* input = &nodes[node->kernel_inputs[j]];
+                if (--input->uses == 0 && input->buffer != MCN_GRAPH_NONE && input->op != MCN_GRAPH_CONSTANT)
+                    used[input->buffer] = 0;
+            }
+        }
+    }
+    graph->output = output;
+    graph->buffer_count = buffer_count;
+    return 1;
+}
+
+static void mcn_priv_graph_eval_chunk(const mcn_graph_t* graph, float (*buffers)[MCN_CHUNK], const float* const* coords,
+                                      MCHR_UINT count, MCHR_UINT seed, float* out) {
+    const mcn_graph_node_t* nodes = graph->nodes;
+    for (MCHR_UINT k = 0; k <= graph->output; ++k) {
+        const mcn_graph_node_t* node = &nodes[k];
+        if (!node->live || node->op == MCN_GRAPH_CONSTANT || mcn_priv_graph_is_coordinate(node->op))
+            continue;
+        const MCHR_UINT inputs = mcn_priv_graph_input_count(node->kernel_op, node->kernel_inputs);
+        const float* in[3] = { NULL, NULL, NULL };
+        for (MCHR_UINT j = 0; j < inputs; ++j) {
+            const mcn_graph_node_t* input = &nodes[node->kernel_inputs[j]];
+            in[j] = mcn_priv_graph_is_coordinate(input->op) ? coords[input->op - MCN_GRAPH_X] : buffers[input->buffer];
+        }
+        MCHR_UINT node_seed = mchr_get_1d_hash_uint((MCHR_INT)node->seed, seed);
+        float* result = (k == graph->output) ? out : buffers[node->buffer];
+        mcn_priv_graph_kernel(node, node->kernel_op, in, inputs, count, node_seed, result);
+    }
+
+    const mcn_graph_node_t* output = &nodes[graph->output];
+    if (output->op == MCN_GRAPH_CONSTANT || mcn_priv_graph_is_coordinate(output->op)) {
+        const float* source = (output->op == MCN_GRAPH_CONSTANT) ? buffers[output->buffer] : coords[output->op - MCN_GRAPH_X];
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            out[i] = source[i];
+        }
+    }
+}
+
+static void mcn_priv_graph_fill_constants(const mcn_graph_t* graph, float (*buffers)[MCN_CHUNK]) {
+    for (MCHR_UINT k = 0; k <= graph->output; ++k) {
+        const mcn_graph_node_t* node = &graph->nodes[k];
+        if (node->live && node->op == MCN_GRAPH_CONSTANT) {
+            for (MCHR_UINT i = 0; i < MCN_CHUNK; ++i) {
+                buffers[node->buffer][i] = node->values[0];
+            }
+        }
+    }
+}
+
+MCN_DEF void mcn_graph_eval_batch( const mcn_graph_t* graph, const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT seed, float* out ) {
+    assert(graph && graph->output != MCN_GRAPH_NONE);
+    assert(z || !graph->uses_z);
+    float buffers[MCN_GRAPH_MAX_BUFFERS][MCN_CHUNK];
+    mcn_priv_graph_fill_constants(graph, buffers);
+    for (MCHR_UINT first = 0; first < count; first += MCN_CHUNK) {
+        MCHR_UINT n = (count - first < MCN_CHUNK) ? count - first : MCN_CHUNK;
+        const float* coords[3] = { x + first, y + first, z ? z + first : NULL };
+        mcn_priv_graph_eval_chunk(graph, buffers, coords, n, seed, out + first);
+    }
+}
+
+MCN_DEF float mcn_graph_eval( const mcn_graph_t* graph, float x, float y, float z, MCHR_UINT seed ) {
+    float result;
+    mcn_graph_eval_batch(graph, &x, &y, &z, 1, seed, &result);
+    return result;
+}
+
+static void mcn_priv_graph_eval_grid(const mcn_graph_t* graph, float start_x, float start_y, float start_z, float step_x, float step_y, float step_z,
+                                     MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT seed, float* out) {
+    assert(graph && graph->output != MCN_GRAPH_NONE);
+    float buffers[MCN_GRAPH_MAX_BUFFERS][MCN_CHUNK];
+    mcn_priv_graph_fill_constants(graph, buffers);
+    for (MCHR_UINT first = 0; first < width; first += MCN_CHUNK) {
+        MCHR_UINT n = (width - first < MCN_CHUNK) ? width - first : MCN_CHUNK;
+        float xs[MCN_CHUNK], ys[MCN_CHUNK], zs[MCN_CHUNK];
+        const float* coords[3] = { xs, ys, zs };
+        for (MCHR_UINT i = 0; i < n; ++i) {
+            xs[i] = start_x + (float)(first + i) * step_x;
+        }
+        for (MCHR_UINT s = 0; s < depth; ++s) {
+            float z = start_z + (float)s * step_z;
+            for (MCHR_UINT r = 0; r < height; ++r) {
+                float y = start_y + (float)r * step_y;
+                for (MCHR_UINT i = 0; i < n; ++i) {
+                    ys[i] = y;
+                    zs[i] = z;
+                }
+                mcn_priv_graph_eval_chunk(graph, buffers, coords, n, seed, out + ((size_t)s * height + r) * width + first);
+            }
+        }
+    }
+}
+
+MCN_DEF void mcn_graph_eval_2d_grid( const mcn_graph_t* graph, float start_x, float start_y, float step_x, float step_y,
+                                     MCHR_UINT width, MCHR_UINT height, MCHR_UINT seed, float* out ) {
+    mcn_priv_graph_eval_grid(graph, start_x, start_y, 0.0f, step_x, step_y, 0.0f, width, height, 1, seed, out);
+}
+
+MCN_DEF void mcn_graph_eval_3d_grid( const mcn_graph_t* graph, float start_x, float start_y, float start_z, float step_x, float step_y, float step_z,
+                                     MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT seed, float* out ) {
+    mcn_priv_graph_eval_grid(graph, start_x, start_y, start_z, step_x, step_y, step_z, width, height, depth, seed, out);
+}
+
+// ---------------------------------------------------------------------------------------
+// Bounds. Every noise is a sum or interpolation of contributions from the lattice points
+//  around the sample, so bounding the contribution of each lattice point over the box
+//  (with interval arithmetic on the offsets) bounds the noise. Results are widened by a
+//  small margin to cover rounding differences with the actual evaluation.
+// ---------------------------------------------------------------------------------------
+static const float MCN_BOUNDS_MARGIN = 1e-5f;
+
+static void mcn_priv_bounds_widen(float* bounds) {
+    bounds[0] -= MCN_BOUNDS_MARGIN * (1.0f + fabsf(bounds[0]));
+    bounds[1] += MCN_BOUNDS_MARGIN * (1.0f + fabsf(bounds[1]));
+}
+
+static void mcn_priv_bounds_clamp(float* bounds, float lo, float hi) {
+    bounds[0] = (bounds[0] < lo) ? lo : bounds[0];
+    bounds[1] = (hi < bounds[1]) ? hi : bounds[1];
+}
+
+static void mcn_priv_bounds_include(float* bounds, float lo, float hi) {
+    bounds[0] = (lo < bounds[0]) ? lo : bounds[0];
+    bounds[1] = (bounds[1] < hi) ? hi : bounds[1];
+}
+
+// Interval of g . (p - origin) for p in the box.
+static void mcn_priv_bounds_dot(const float* g, const float* lo, const float* hi, const float* origin, MCHR_UINT dims, float* out) {
+    out[0] = out[1] = 0.0f;
+    for (MCHR_UINT d = 0; d < dims; ++d) {
+        float a = g[d] * (lo[d] - origin[d]);
+        float b = g[d] * (hi[d] - origin[d]);
+        out[0] += (a < b) ? a : b;
+        out[1] += (a < b) ? b : a;
+    }
+}
+
+static MCHR_UINT mcn_priv_lattice_hash(const MCHR_INT* p, MCHR_UINT dims, MCHR_UINT seed) {
+    return (dims == 2) ? mchr_get_2d_hash_uint(p[0], p[1], seed) : mchr_get_3d_hash_uint(p[0], p[1], p[2], seed);
+}
+
+static void mcn_priv_gradient_vector(MCHR_UINT hash, MCHR_UINT dims, float* out) {
+    MCHR_UINT g = hash >> 28;
+    if (dims == 2) {
+        out[0] = MCN_GRADIENT_2D_X[g];
+        out[1] = MCN_GRADIENT_2D_Y[g];
+    } else {
+        out[0] = MCN_GRADIENT_3D_X[g];
+        out[1] = MCN_GRADIENT_3D_Y[g];
+        out[2] = MCN_GRADIENT_3D_Z[g];
+    }
+}
+
+// Range of lattice points from floor(lo) - below to floor(hi) + above on each axis, and
+//  their count, or 0 if there are more than MCN_BOUNDS_MAX_POINTS (or the box is invalid).
+static MCHR_UINT mcn_priv_bounds_lattice(const float* lo, const float* hi, MCHR_UINT dims, MCHR_INT below, MCHR_INT above,
+                                         MCHR_INT* first, MCHR_INT* last) {
+    double count = 1.0;
+    for (MCHR_UINT d = 0; d < dims; ++d) {
+        if (!(lo[d] <= hi[d]) || !(fabsf(lo[d]) < 1e9f) || !(fabsf(hi[d]) < 1e9f))
+            return 0;
+        first[d] = mcn_priv_floor(lo[d]) - below;
+        last[d] = mcn_priv_floor(hi[d]) + above;
+        count *= (double)(last[d] - first[d] + 1);
+    }
+    return (count <= MCN_BOUNDS_MAX_POINTS) ? (MCHR_UINT)count : 0;
+}
+
+// Next point of the range, in row-major order.
+static void mcn_priv_bounds_next(MCHR_INT* p, const MCHR_INT* first, const MCHR_INT* last, MCHR_UINT dims) {
+    for (MCHR_UINT d = 0; d < dims; ++d) {
+        if (p[d] < last[d]) {
+            ++p[d];
+            return;
+        }
+        p[d] = first[d];
+    }
+}
+
+// Range of a + t * (b - a) for a, b and t in intervals, t within [0,1]. It's linear in
+//  each of them, so the extremes are at the ends of the intervals.
+static void mcn_priv_bounds_lerp(const float* a, const float* b, const float* t, float* out) {
+    float lo0 = mcn_priv_lerp(a[0], b[0], t[0]), lo1 = mcn_priv_lerp(a[0], b[0], t[1]);
+    float hi0 = mcn_priv_lerp(a[1], b[1], t[0]), hi1 = mcn_priv_lerp(a[1], b[1], t[1]);
+    out[0] = (lo1 < lo0) ? lo1 : lo0;
+    out[1] = (hi0 < hi1) ? hi1 : hi0;
+}
+
+// Value and gradient noise interpolate the values (or the dot products with the offset to
+//  the sample) of the corners of their cell. Each cell overlapping the box is bounded by
+//  interpolating the ranges of its corners, over the part of the box inside the cell,
+//  with the ranges of the interpolation weights.
+static void mcn_priv_lattice_bounds(mcn_priv_lattice_kind_t kind, const float* lo, const float* hi, MCHR_UINT dims,
+                                    MCHR_UINT seed, float* out) {
+    MCHR_INT first[3], last[3], p[3];
+    const MCHR_UINT count = mcn_priv_bounds_lattice(lo, hi, dims, 0, 0, first, last);
+    out[0] = -1.0f;
+    out[1] = 1.0f;
+    if (count == 0)
+        return;
+
+    out[0] = FLT_MAX;
+    out[1] = -FLT_MAX;
+    for (MCHR_UINT d = 0; d < dims; ++d) {
+        p[d] = first[d];
+    }
+    for (MCHR_UINT k = 0; k < count; ++k, mcn_priv_bounds_next(p, first, last, dims)) {
+        float cell_lo[3], cell_hi[3], weights[3][2], corners[8][2];
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            cell_lo[d] = ((float)p[d] < lo[d]) ? lo[d] : (float)p[d];
+            cell_hi[d] = (hi[d] < (float)(p[d] + 1)) ? hi[d] : (float)(p[d] + 1);
+            float f0 = cell_lo[d] - (float)p[d], f1 = cell_hi[d] - (float)p[d];
+            weights[d][0] = (kind == MCN_PRIV_VALUE) ? mcn_priv_smoothstep(f0) : mcn_priv_fade(f0);
+            weights[d][1] = (kind == MCN_PRIV_VALUE) ? mcn_priv_smoothstep(f1) : mcn_priv_fade(f1);
+        }
+        for (MCHR_UINT c = 0; c < (1U << dims); ++c) {
+            MCHR_INT corner[3];
+            float origin[3], g[3];
+            for (MCHR_UINT d = 0; d < dims; ++d) {
+                corner[d] = p[d] + (MCHR_INT)((c >> d) & 1);
+                origin[d] = (float)corner[d];
+            }
+            MCHR_UINT hash = mcn_priv_lattice_hash(corner, dims, seed);
+            if (kind == MCN_PRIV_VALUE) {
+                corners[c][0] = corners[c][1] = mcn_priv_hash_to_signed(hash);
+            } else {
+                mcn_priv_gradient_vector(hash, dims, g);
+                mcn_priv_bounds_dot(g, cell_lo, cell_hi, origin, dims, corners[c]);
+            }
+        }
+        // interpolate along x, then y, then z, halving the corners every time
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            for (MCHR_UINT c = 0; c < (1U << (dims - d - 1)); ++c) {
+                mcn_priv_bounds_lerp(corners[2 * c], corners[2 * c + 1], weights[d], corners[c]);
+            }
+        }
+        mcn_priv_bounds_include(out, corners[0][0], corners[0][1]);
+    }
+    if (kind == MCN_PRIV_GRADIENT) {
+        out[0] *= MCN_GRADIENT_SCALE[dims];
+        out[1] *= MCN_GRADIENT_SCALE[dims];
+    }
+    mcn_priv_bounds_widen(out);
+    mcn_priv_bounds_clamp(out, -1.0f, 1.0f);
+}
+
+// Skewed lattice coordinates of the vertices of the simplex containing a point, in the
+//  same order and with the same operations as the noise functions.
+static void mcn_priv_simplex_vertices(const float* p, MCHR_UINT dims, MCHR_INT (*out)[3]) {
+    MCHR_INT cell[3], rank[3], sum = 0;
+    float offset[3], s = p[0];
+    for (MCHR_UINT d = 1; d < dims; ++d) {
+        s += p[d];
+    }
+    s *= MCN_SIMPLEX_SKEW[dims];
+    for (MCHR_UINT d = 0; d < dims; ++d) {
+        cell[d] = mcn_priv_floor(p[d] + s);
+        sum += cell[d];
+    }
+    float t = (float)sum * MCN_SIMPLEX_UNSKEW[dims];
+    for (MCHR_UINT d = 0; d < dims; ++d) {
+        offset[d] = p[d] - ((float)cell[d] - t);
+    }
+    for (MCHR_UINT d = 0; d < dims; ++d) {
+        rank[d] = 0;
+        for (MCHR_UINT e = 0; e < dims; ++e) {
+            rank[d] += (e < d) ? (offset[d] >= offset[e]) : (e > d && offset[d] > offset[e]);
+        }
+    }
+    for (MCHR_UINT v = 0; v <= dims; ++v) {
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            out[v][d] = cell[d] + (rank[d] >= (MCHR_INT)(dims - v));
+        }
+    }
+}
+
+// Simplex noise adds the contributions of the vertices of the simplex containing the
+//  sample. Each one is a falloff, within its values at the farthest and closest points of
+//  the box, times a dot product bounded over the box. When the box is inside a single
+//  simplex (all its corners are) only its vertices are added; otherwise every vertex in
+//  the skewed cells overlapping the box is, with zero included in its range, since it
+//  doesn't contribute to the samples in other simplices.
+static void mcn_priv_simplex_vertex_bounds(const MCHR_INT* vertex, const float* lo, const float* hi, MCHR_UINT dims, MCHR_UINT seed,
+                                           int inside, float* out) {
+    MCHR_INT sum = 0;
+    float position[3], g[3], dot[2], near2 = 0.0f, far2 = 0.0f;
+    for (MCHR_UINT d = 0; d < dims; ++d) {
+        sum += vertex[d];
+    }
+    for (MCHR_UINT d = 0; d < dims; ++d) {
+        position[d] = (float)vertex[d] - (float)sum * MCN_SIMPLEX_UNSKEW[dims];
+        float a = lo[d] - position[d], b = hi[d] - position[d];
+        float gap = (a > 0.0f) ? a : ((b < 0.0f) ? -b : 0.0f);
+        float reach = (fabsf(a) < fabsf(b)) ? fabsf(b) : fabsf(a);
+        near2 += gap * gap;
+        far2 += reach * reach;
+    }
+    float falloff[2] = { inside ? mcn_priv_simplex_kernel(far2) : 0.0f, mcn_priv_simplex_kernel(near2) };
+    if (falloff[1] == 0.0f)
+        return;
+    mcn_priv_gradient_vector(mcn_priv_lattice_hash(vertex, dims, seed), dims, g);
+    mcn_priv_bounds_dot(g, lo, hi, position, dims, dot);
+    float a = (falloff[0] * dot[0] < falloff[1] * dot[0]) ? falloff[0] * dot[0] : falloff[1] * dot[0];
+    float b = (falloff[0] * dot[1] < falloff[1] * dot[1]) ? falloff[1] * dot[1] : falloff[0] * dot[1];
+    out[0] += a;
+    out[1] += b;
+}
+
+static void mcn_priv_simplex_bounds(const float* lo, const float* hi, MCHR_UINT dims, MCHR_UINT seed, float* out) {
+    // zeroed, as 2D simplices only fill part of them and they are compared whole
+    MCHR_INT vertices[4][3] = {{0}}, corner_vertices[4][3] = {{0}};
+    float skewed_lo[3], skewed_hi[3], sum_lo = 0.0f, sum_hi = 0.0f;
+    MCHR_INT first[3], last[3], p[3];
+    out[0] = -1.0f;
+    out[1] = 1.0f;
+    for (MCHR_UINT d = 0; d < dims; ++d) {
+        sum_lo += lo[d];
+        sum_hi += hi[d];
+    }
+    for (MCHR_UINT d = 0; d < dims; ++d) {
+        skewed_lo[d] = lo[d] + sum_lo * MCN_SIMPLEX_SKEW[dims];
+        skewed_hi[d] = hi[d] + sum_hi * MCN_SIMPLEX_SKEW[dims];
+    }
+    const MCHR_UINT count = mcn_priv_bounds_lattice(skewed_lo, skewed_hi, dims, 0, 1, first, last);
+    if (count == 0)
+        return;
+
+    int inside = 1;
+    mcn_priv_simplex_vertices(lo, dims, vertices);
+    for (MCHR_UINT c = 1; c < (1U << dims) && inside; ++c) {
+        float corner[3];
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            corner[d] = ((c >> d) & 1) ? hi[d] : lo[d];
+        }
+        mcn_priv_simplex_vertices(corner, dims, corner_vertices);
+        inside = memcmp(vertices, corner_vertices, sizeof(vertices)) == 0;
+    }
+
+    out[0] = out[1] = 0.0f;
+    if (inside) {
+        for (MCHR_UINT v = 0; v <= dims; ++v) {
+            mcn_priv_simplex_vertex_bounds(vertices[v], lo, hi, dims, seed, 1, out);
+        }
+    } else {
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            p[d] = first[d];
+        }
+        for (MCHR_UINT k = 0; k < count; ++k, mcn_priv_bounds_next(p, first, last, dims)) {
+            mcn_priv_simplex_vertex_bounds(p, lo, hi, dims, seed, 0, out);
+        }
+    }
+    out[0] *= MCN_SIMPLEX_SCALE[dims];
+    out[1] *= MCN_SIMPLEX_SCALE[dims];
+    mcn_priv_bounds_widen(out);
+    mcn_priv_bounds_clamp(out, -1.0f, 1.0f);
+}
+
+static void mcn_priv_base_noise_bounds(mcn_noise_type_t noise, const float* lo, const float* hi, MCHR_UINT dims, MCHR_UINT seed, float* out) {
+    if (noise == MCN_NOISE_SIMPLEX) {
+        mcn_priv_simplex_bounds(lo, hi, dims, seed, out);
+    } else {
+        mcn_priv_lattice_bounds((noise == MCN_NOISE_VALUE) ? MCN_PRIV_VALUE : MCN_PRIV_GRADIENT, lo, hi, dims, seed, out);
+    }
+}
+
+// F1 is at least the distance from the box to the closest feature point around it, and
+//  at most the distance from the farthest point of the box to any feature point that all
+//  the samples in the box search (or to the feature point of their own cell).
+static void mcn_priv_cellular_bounds(const float* lo, const float* hi, MCHR_UINT dims, float jitter, mcn_distance_t distance,
+                                     MCHR_UINT seed, float* out) {
+    MCHR_INT first[3], last[3], p[3];
+    float delta[3];
+    for (MCHR_UINT d = 0; d < dims; ++d) {
+        delta[d] = 0.5f + 0.5f * jitter;
+    }
+    out[0] = 0.0f;
+    out[1] = mcn_priv_cellular_distance(distance, delta, dims);
+    const MCHR_UINT count = mcn_priv_bounds_lattice(lo, hi, dims, 1, 1, first, last);
+    if (count > 0) {
+        out[0] = FLT_MAX;
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            p[d] = first[d];
+        }
+        for (MCHR_UINT k = 0; k < count; ++k, mcn_priv_bounds_next(p, first, last, dims)) {
+            float feature[3], closest[3], farthest[3];
+            MCHR_UINT hash = mcn_priv_lattice_hash(p, dims, seed);
+            if (dims == 2) {
+                mcn_priv_feature_2d(hash, jitter, &feature[0], &feature[1]);
+            } else {
+                mcn_priv_feature_3d(hash, jitter, &feature[0], &feature[1], &feature[2]);
+            }
+            int shared = 1;
+            for (MCHR_UINT d = 0; d < dims; ++d) {
+                feature[d] += (float)p[d];
+                float a = lo[d] - feature[d], b = hi[d] - feature[d];
+                closest[d] = (a > 0.0f) ? a : ((b < 0.0f) ? b : 0.0f);
+                farthest[d] = (fabsf(a) < fabsf(b)) ? b : a;
+                shared = shared && p[d] >= last[d] - 2 && p[d] <= first[d] + 2;
+            }
+            float lower = mcn_priv_cellular_distance(distance, closest, dims);
+            out[0] = (lower < out[0]) ? lower : out[0];
+            if (shared) {
+                float upper = mcn_priv_cellular_distance(distance, farthest, dims);
+                out[1] = (upper < out[1]) ? upper : out[1];
+            }
+        }
+    }
+    out[0] = mcn_priv_cellular_finish(distance, out[0]);
+    out[1] = mcn_priv_cellular_finish(distance, out[1]);
+    mcn_priv_bounds_widen(out);
+    out[0] = (out[0] < 0.0f) ? 0.0f : out[0];
+}
+
+// Octaves are bounded separately at their own frequency and added. The domain warp moves
+//  samples by at most its amplitude along each axis.
+static void mcn_priv_fractal_bounds(const mcn_fractal_t* fractal, const float* lo, const float* hi, MCHR_UINT dims, MCHR_UINT seed, float* out) {
+    assert(fractal && fractal->octaves > 0);
+    float box_lo[3], box_hi[3];
+    const float warp = fabsf(fractal->warp_amplitude);
+    for (MCHR_UINT d = 0; d < dims; ++d) {
+        box_lo[d] = lo[d] - warp;
+        box_hi[d] = hi[d] + warp;
+    }
+
+    float sum[2] = { 0.0f, 0.0f };
+    float total = 0.0f;
+    float frequency = fractal->frequency, amplitude = 1.0f;
+    for (MCHR_UINT octave = 0; octave < fractal->octaves; ++octave) {
+        float octave_lo[3], octave_hi[3], value[2];
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            float a = box_lo[d] * frequency, b = box_hi[d] * frequency;
+            octave_lo[d] = (a < b) ? a : b;
+            octave_hi[d] = (a < b) ? b : a;
+        }
+        mcn_priv_base_noise_bounds(fractal->noise, octave_lo, octave_hi, dims, mcn_get_octave_seed(seed, octave), value);
+        if (fractal->type != MCN_FRACTAL_FBM) {
+            // shapes of |n|, with |n| in [closest to zero, farthest from zero]
+            float abs_lo = (value[0] > 0.0f) ? value[0] : ((value[1] < 0.0f) ? -value[1] : 0.0f);
+            float abs_hi = (fabsf(value[0]) < fabsf(value[1])) ? fabsf(value[1]) : fabsf(value[0]);
+            if (fractal->type == MCN_FRACTAL_BILLOW) {
+                value[0] = 2.0f * abs_lo - 1.0f;
+                value[1] = 2.0f * abs_hi - 1.0f;
+            } else {
+                value[0] = 2.0f * (1.0f - abs_hi) * (1.0f - abs_hi) - 1.0f;
+                value[1] = 2.0f * (1.0f - abs_lo) * (1.0f - abs_lo) - 1.0f;
+            }
+        }
+        float a = amplitude * value[0], b = amplitude * value[1];
+        sum[0] += (a < b) ? a : b;
+        sum[1] += (a < b) ? b : a;
+        total += amplitude;
+        frequency *= fractal->lacunarity;
+        amplitude *= fractal->gain;
+    }
+    out[0] = (total > 0.0f) ? sum[0] / total : sum[1] / total;
+    out[1] = (total > 0.0f) ? sum[1] / total : sum[0] / total;
+    mcn_priv_bounds_widen(out);
+    mcn_priv_bounds_clamp(out, -1.0f, 1.0f);
+}
+
+MCN_DEF void mcn_value_noise_2d_bounds( float min_x, float min_y, float max_x, float max_y, MCHR_UINT seed, float* out_min, float* out_max ) {
+    const float lo[2] = { min_x, min_y }, hi[2] = { max_x, max_y };
+    float bounds[2];
+    mcn_priv_lattice_bounds(MCN_PRIV_VALUE, lo, hi, 2, seed, bounds);
+    *out_min = bounds[0];
+    *out_max = bounds[1];
+}
+
+MCN_DEF void mcn_value_noise_3d_bounds( float min_x, float min_y, float min_z, float max_x, float max_y, float max_z, MCHR_UINT seed,
+                                        float* out_min, float* out_max ) {
+    const float lo[3] = { min_x, min_y, min_z }, hi[3] = { max_x, max_y, max_z };
+    float bounds[2];
+    mcn_priv_lattice_bounds(MCN_PRIV_VALUE, lo, hi, 3, seed, bounds);
+    *out_min = bounds[0];
+    *out_max = bounds[1];
+}
+
+MCN_DEF void mcn_gradient_noise_2d_bounds( float min_x, float min_y, float max_x, float max_y, MCHR_UINT seed, float* out_min, float* out_max ) {
+    const float lo[2] = { min_x, min_y }, hi[2] = { max_x, max_y };
+    float bounds[2];
+    mcn_priv_lattice_bounds(MCN_PRIV_GRADIENT, lo, hi, 2, seed, bounds);
+    *out_min = bounds[0];
+    *out_max = bounds[1];
+}
+
+MCN_DEF void mcn_gradient_noise_3d_bounds( float min_x, float min_y, float min_z, float max_x, float max_y, float max_z, MCHR_UINT seed,
+                                           float* out_min, float* out_max ) {
+    const float lo[3] = { min_x, min_y, min_z }, hi[3] = { max_x, max_y, max_z };
+    float bounds[2];
+    mcn_priv_lattice_bounds(MCN_PRIV_GRADIENT, lo, hi, 3, seed, bounds);
+    *out_min = bounds[0];
+    *out_max = bounds[1];
+}
+
+MCN_DEF void mcn_simplex_noise_2d_bounds( float min_x, float min_y, float max_x, float max_y, MCHR_UINT seed, float* out_min, float* out_max ) {
+    const float lo[2] = { min_x, min_y }, hi[2] = { max_x, max_y };
+    float bounds[2];
+    mcn_priv_simplex_bounds(lo, hi, 2, seed, bounds);
+    *out_min = bounds[0];
+    *out_max = bounds[1];
+}
+
+MCN_DEF void mcn_simplex_noise_3d_bounds( float min_x, float min_y, float min_z, float max_x, float max_y, float max_z, MCHR_UINT seed,
+                                          float* out_min, float* out_max ) {
+    const float lo[3] = { min_x, min_y, min_z }, hi[3] = { max_x, max_y, max_z };
+    float bounds[2];
+    mcn_priv_simplex_bounds(lo, hi, 3, seed, bounds);
+    *out_min = bounds[0];
+    *out_max = bounds[1];
+}
+
+MCN_DEF void mcn_cellular_noise_2d_bounds( float min_x, float min_y, float max_x, float max_y, float jitter, mcn_distance_t distance, MCHR_UINT seed,
+                                           float* out_min, float* out_max ) {
+    const float lo[2] = { min_x, min_y }, hi[2] = { max_x, max_y };
+    float bounds[2];
+    mcn_priv_cellular_bounds(lo, hi, 2, jitter, distance, seed, bounds);
+    *out_min = bounds[0];
+    *out_max = bounds[1];
+}
+
+MCN_DEF void mcn_cellular_noise_3d_bounds( float min_x, float min_y, float min_z, float max_x, float max_y, float max_z,
+                                           float jitter, mcn_distance_t distance, MCHR_UINT seed, float* out_min, float* out_max ) {
+    const float lo[3] = { min_x, min_y, min_z }, hi[3] = { max_x, max_y, max_z };
+    float bounds[2];
+    mcn_priv_cellular_bounds(lo, hi, 3, jitter, distance, seed, bounds);
+    *out_min = bounds[0];
+    *out_max = bounds[1];
+}
+
+MCN_DEF void mcn_fractal_noise_2d_bounds( const mcn_fractal_t* fractal, float min_x, float min_y, float max_x, float max_y, MCHR_UINT seed,
+                                          float* out_min, float* out_max ) {
+    const float lo[2] = { min_x, min_y }, hi[2] = { max_x, max_y };
+    float bounds[2];
+    mcn_priv_fractal_bounds(fractal, lo, hi, 2, seed, bounds);
+    *out_min = bounds[0];
+    *out_max = bounds[1];
+}
+
+MCN_DEF void mcn_fractal_noise_3d_bounds( const mcn_fractal_t* fractal, float min_x, float min_y, float min_z, float max_x, float max_y, float max_z,
+                                          MCHR_UINT seed, float* out_min, float* out_max ) {
+    const float lo[3] = { min_x, min_y, min_z }, hi[3] = { max_x, max_y, max_z };
+    float bounds[2];
+    mcn_priv_fractal_bounds(fractal, lo, hi, 3, seed, bounds);
+    *out_min = bounds[0];
+    *out_max = bounds[1];
+}
+
+// Graph bounds propagate intervals through the nodes in evaluation order. The piecewise
+//  linear curve takes its extremes at the ends of the interval or at the points inside it.
+static void mcn_priv_graph_node_bounds(const mcn_graph_node_t* node, const float* const* in, MCHR_UINT seed, float* out) {
+    const float* a = in[0];
+    const float* b = in[1];
+    const float* c = in[2];
+    switch (node->kernel_op) {
+    case MCN_GRAPH_ADD:
+        out[0] = a[0] + b[0];
+        out[1] = a[1] + b[1];
+        break;
+    case MCN_GRAPH_SUB:
+        out[0] = a[0] - b[1];
+        out[1] = a[1] - b[0];
+        break;
+    case MCN_GRAPH_MUL:
+    case MCN_GRAPH_MAD: {
+        float p[4] = { a[0] * b[0], a[0] * b[1], a[1] * b[0], a[1] * b[1] };
+        out[0] = out[1] = p[0];
+        for (MCHR_UINT k = 1; k < 4; ++k) {
+            mcn_priv_bounds_include(out, p[k], p[k]);
+        }
+        if (node->kernel_op == MCN_GRAPH_MAD) {
+            out[0] += c[0];
+            out[1] += c[1];
+        }
+        break;
+    }
+    case MCN_GRAPH_MIN:
+        out[0] = (b[0] < a[0]) ? b[0] : a[0];
+        out[1] = (b[1] < a[1]) ? b[1] : a[1];
+        break;
+    case MCN_GRAPH_MAX:
+        out[0] = (a[0] < b[0]) ? b[0] : a[0];
+        out[1] = (a[1] < b[1]) ? b[1] : a[1];
+        break;
+    case MCN_GRAPH_ABS:
+        out[0] = (a[0] > 0.0f) ? a[0] : ((a[1] < 0.0f) ? -a[1] : 0.0f);
+        out[1] = (fabsf(a[0]) < fabsf(a[1])) ? fabsf(a[1]) : fabsf(a[0]);
+        break;
+    case MCN_GRAPH_MIX: {
+        // a + t * (b - a), with t usually in [0,1]
+        float d[2] = { b[0] - a[1], b[1] - a[0] };
+        float p[4] = { c[0] * d[0], c[0] * d[1], c[1] * d[0], c[1] * d[1] };
+        out[0] = out[1] = p[0];
+        for (MCHR_UINT k = 1; k < 4; ++k) {
+            mcn_priv_bounds_include(out, p[k], p[k]);
+        }
+        out[0] += a[0];
+        out[1] += a[1];
+        break;
+    }
+    case MCN_GRAPH_CLAMP:
+        out[0] = a[0];
+        out[1] = a[1];
+        mcn_priv_bounds_clamp(out, node->values[0], node->values[1]);
+        out[0] = (node->values[1] < out[0]) ? node->values[1] : out[0];
+        out[1] = (out[1] < node->values[0]) ? node->values[0] : out[1];
+        break;
+    case MCN_GRAPH_CURVE: {
+        const float* ends[3] = { a, NULL, NULL };
+        float values[2];
+        mcn_priv_graph_kernel(node, MCN_GRAPH_CURVE, ends, 1, 2, 0, values);
+        out[0] = (values[0] < values[1]) ? values[0] : values[1];
+        out[1] = (values[0] < values[1]) ? values[1] : values[0];
+        // points at the ends are included too, as the values just before a step at the
+        //  upper end are the y of the point before it
+        for (MCHR_UINT k = 0; k < node->curve_count; ++k) {
+            if (a[0] <= node->curve_x[k] && node->curve_x[k] <= a[1])
+                mcn_priv_bounds_include(out, node->curve_y[k], node->curve_y[k]);
+        }
+        break;
+    }
+    case MCN_GRAPH_NOISE:
+    case MCN_GRAPH_FRACTAL: {
+        const MCHR_UINT dims = (node->inputs[2] == MCN_GRAPH_NONE) ? 2 : 3;
+        float lo[3], hi[3];
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            lo[d] = in[d][0];
+            hi[d] = in[d][1];
+        }
+        if (node->kernel_op == MCN_GRAPH_NOISE) {
+            mcn_priv_base_noise_bounds(node->noise, lo, hi, dims, seed, out);
+        } else {
+            mcn_priv_fractal_bounds(&node->fractal, lo, hi, dims, seed, out);
+        }
+        return;
+    }
+    default:
+        assert(0 && "not a kernel operation");
+        break;
+    }
+    mcn_priv_bounds_widen(out);
+}
+
+static void mcn_priv_graph_bounds(const mcn_graph_t* graph, const float* lo, const float* hi, MCHR_UINT seed, float* node_bounds, float* out) {
+    assert(graph && graph->output != MCN_GRAPH_NONE);
+    assert(node_bounds);
+    const mcn_graph_node_t* nodes = graph->nodes;
+    for (MCHR_UINT k = 0; k <= graph->output; ++k) {
+        const mcn_graph_node_t* node = &nodes[k];
+        float* bounds = node_bounds + 2 * k;
+        if (!node->live)
+            continue;
+        if (mcn_priv_graph_is_coordinate(node->op)) {
+            bounds[0] = lo[node->op - MCN_GRAPH_X];
+            bounds[1] = hi[node->op - MCN_GRAPH_X];
+        } else if (node->op == MCN_GRAPH_CONSTANT) {
+            bounds[0] = bounds[1] = node->values[0];
+        } else {
+            const float* in[3] = { NULL, NULL, NULL };
+            for (MCHR_UINT j = 0; j < mcn_priv_graph_input_count(node->kernel_op, node->kernel_inputs); ++j) {
+                in[j] = node_bounds + 2 * node->kernel_inputs[j];
+            }
+            mcn_priv_graph_node_bounds(node, in, mchr_get_1d_hash_uint((MCHR_INT)node->seed, seed), bounds);
+        }
+    }
+    out[0] = node_bounds[2 * graph->output];
+    out[1] = node_bounds[2 * graph->output + 1];
+}
+
+MCN_DEF void mcn_graph_bounds_2d( const mcn_graph_t* graph, float min_x, float min_y, float max_x, float max_y, MCHR_UINT seed,
+                                  float* node_bounds, float* out_min, float* out_max ) {
+    const float lo[3] = { min_x, min_y, 0.0f }, hi[3] = { max_x, max_y, 0.0f };
+    float bounds[2];
+    mcn_priv_graph_bounds(graph, lo, hi, seed, node_bounds, bounds);
+    *out_min = bounds[0];
+    *out_max = bounds[1];
+}
+
+MCN_DEF void mcn_graph_bounds_3d( const mcn_graph_t* graph, float min_x, float min_y, float min_z, float max_x, float max_y, float max_z,
+                                  MCHR_UINT seed, float* node_bounds, float* out_min, float* out_max ) {
+    const float lo[3] = { min_x, min_y, min_z }, hi[3] = { max_x, max_y, max_z };
+    float bounds[2];
+    mcn_priv_graph_bounds(graph, lo, hi, seed, node_bounds, bounds);
+    *out_min = bounds[0];
+    *out_max = bounds[1];
+}
+
+// ---------------------------------------------------------------------------------------
+// Noise with derivatives. The chunk functions compute the derivatives after the values,
+//  reusing their hashes, and the values with the same operations as without derivatives.
+//  Single points are evaluated as chunks of one point.
+// ---------------------------------------------------------------------------------------
+static void mcn_priv_noise_deriv_batch(mcn_noise_type_t noise, const mcn_fractal_t* fractal, const float* const* coords, MCHR_UINT dims,
+                                       MCHR_UINT count, MCHR_UINT seed, float* out, float* const* deriv) {
+    assert(out && deriv[0] && deriv[1] && (dims < 3 || deriv[2]));
+    for (MCHR_UINT first = 0; first < count; first += MCN_CHUNK) {
+        MCHR_UINT n = (count - first < MCN_CHUNK) ? count - first : MCN_CHUNK;
+        const float* chunk_coords[3];
+        float* chunk_deriv[3];
+        for (MCHR_UINT d = 0; d < dims; ++d) {
+            chunk_coords[d] = coords[d] + first;
+            chunk_deriv[d] = deriv[d] + first;
+        }
+        if (fractal) {
+            mcn_priv_fractal_noise_chunk(fractal, chunk_coords, dims, n, seed, NULL, out + first, chunk_deriv);
+        } else {
+            mcn_priv_base_noise_chunk(noise, chunk_coords, dims, n, seed, NULL, out + first, chunk_deriv);
+        }
+    }
+}
+
+static float mcn_priv_noise_deriv_2d(mcn_noise_type_t noise, const mcn_fractal_t* fractal, float x, float y, MCHR_UINT seed,
+                                     float* out_dx, float* out_dy) {
+    const float* coords[2] = { &x, &y };
+    float* deriv[2] = { out_dx, out_dy };
+    float result;
+    mcn_priv_noise_deriv_batch(noise, fractal, coords, 2, 1, seed, &result, deriv);
+    return result;
+}
+
+static float mcn_priv_noise_deriv_3d(mcn_noise_type_t noise, const mcn_fractal_t* fractal, float x, float y, float z, MCHR_UINT seed,
+                                     float* out_dx, float* out_dy, float* out_dz) {
+    const float* coords[3] = { &x, &y, &z };
+    float* deriv[3] = { out_dx, out_dy, out_dz };
+    float result;
+    mcn_priv_noise_deriv_batch(noise, fractal, coords, 3, 1, seed, &result, deriv);
+    return result;
+}
+
+MCN_DEF float mcn_value_noise_2d_deriv( float x, float y, MCHR_UINT seed, float* out_dx, float* out_dy ) {
+    return mcn_priv_noise_deriv_2d(MCN_NOISE_VALUE, NULL, x, y, seed, out_dx, out_dy);
+}
+
+MCN_DEF float mcn_value_noise_3d_deriv( float x, float y, float z, MCHR_UINT seed, float* out_dx, float* out_dy, float* out_dz ) {
+    return mcn_priv_noise_deriv_3d(MCN_NOISE_VALUE, NULL, x, y, z, seed, out_dx, out_dy, out_dz);
+}
+
+MCN_DEF float mcn_gradient_noise_2d_deriv( float x, float y, MCHR_UINT seed, float* out_dx, float* out_dy ) {
+    return mcn_priv_noise_deriv_2d(MCN_NOISE_GRADIENT, NULL, x, y, seed, out_dx, out_dy);
+}
+
+MCN_DEF float mcn_gradient_noise_3d_deriv( float x, float y, float z, MCHR_UINT seed, float* out_dx, float* out_dy, float* out_dz ) {
+    return mcn_priv_noise_deriv_3d(MCN_NOISE_GRADIENT, NULL, x, y, z, seed, out_dx, out_dy, out_dz);
+}
+
+MCN_DEF float mcn_simplex_noise_2d_deriv( float x, float y, MCHR_UINT seed, float* out_dx, float* out_dy ) {
+    return mcn_priv_noise_deriv_2d(MCN_NOISE_SIMPLEX, NULL, x, y, seed, out_dx, out_dy);
+}
+
+MCN_DEF float mcn_simplex_noise_3d_deriv( float x, float y, float z, MCHR_UINT seed, float* out_dx, float* out_dy, float* out_dz ) {
+    return mcn_priv_noise_deriv_3d(MCN_NOISE_SIMPLEX, NULL, x, y, z, seed, out_dx, out_dy, out_dz);
+}
+
+MCN_DEF float mcn_fractal_noise_2d_deriv( const mcn_fractal_t* fractal, float x, float y, MCHR_UINT seed, float* out_dx, float* out_dy ) {
+    assert(fractal && fractal->octaves > 0);
+    return mcn_priv_noise_deriv_2d(fractal->noise, fractal, x, y, seed, out_dx, out_dy);
+}
+
+MCN_DEF float mcn_fractal_noise_3d_deriv( const mcn_fractal_t* fractal, float x, float y, float z, MCHR_UINT seed,
+                                          float* out_dx, float* out_dy, float* out_dz ) {
+    assert(fractal && fractal->octaves > 0);
+    return mcn_priv_noise_deriv_3d(fractal->noise, fractal, x, y, z, seed, out_dx, out_dy, out_dz);
+}
+
+MCN_DEF void mcn_value_noise_2d_deriv_batch( const float* x, const float* y, MCHR_UINT count, MCHR_UINT seed, float* out, float* out_dx, float* out_dy ) {
+    const float* coords[2] = { x, y };
+    float* deriv[2] = { out_dx, out_dy };
+    mcn_priv_noise_deriv_batch(MCN_NOISE_VALUE, NULL, coords, 2, count, seed, out, deriv);
+}
+
+MCN_DEF void mcn_value_noise_3d_deriv_batch( const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT seed,
+                                             float* out, float* out_dx, float* out_dy, float* out_dz ) {
+    const float* coords[3] = { x, y, z };
+    float* deriv[3] = { out_dx, out_dy, out_dz };
+    mcn_priv_noise_deriv_batch(MCN_NOISE_VALUE, NULL, coords, 3, count, seed, out, deriv);
+}
+
+MCN_DEF void mcn_gradient_noise_2d_deriv_batch( const float* x, const float* y, MCHR_UINT count, MCHR_UINT seed, float* out, float* out_dx, float* out_dy ) {
+    const float* coords[2] = { x, y };
+    float* deriv[2] = { out_dx, out_dy };
+    mcn_priv_noise_deriv_batch(MCN_NOISE_GRADIENT, NULL, coords, 2, count, seed, out, deriv);
+}
+
+MCN_DEF void mcn_gradient_noise_3d_deriv_batch( const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT seed,
+                                                float* out, float* out_dx, float* out_dy, float* out_dz ) {
+    const float* coords[3] = { x, y, z };
+    float* deriv[3] = { out_dx, out_dy, out_dz };
+    mcn_priv_noise_deriv_batch(MCN_NOISE_GRADIENT, NULL, coords, 3, count, seed, out, deriv);
+}
+
+MCN_DEF void mcn_simplex_noise_2d_deriv_batch( const float* x, const float* y, MCHR_UINT count, MCHR_UINT seed, float* out, float* out_dx, float* out_dy ) {
+    const float* coords[2] = { x, y };
+    float* deriv[2] = { out_dx, out_dy };
+    mcn_priv_noise_deriv_batch(MCN_NOISE_SIMPLEX, NULL, coords, 2, count, seed, out, deriv);
+}
+
+MCN_DEF void mcn_simplex_noise_3d_deriv_batch( const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT seed,
+                                               float* out, float* out_dx, float* out_dy, float* out_dz ) {
+    const float* coords[3] = { x, y, z };
+    float* deriv[3] = { out_dx, out_dy, out_dz };
+    mcn_priv_noise_deriv_batch(MCN_NOISE_SIMPLEX, NULL, coords, 3, count, seed, out, deriv);
+}
+
+MCN_DEF void mcn_fractal_noise_2d_deriv_batch( const mcn_fractal_t* fractal, const float* x, const float* y, MCHR_UINT count, MCHR_UINT seed,
+                                               float* out, float* out_dx, float* out_dy ) {
+    assert(fractal && fractal->octaves > 0);
+    const float* coords[2] = { x, y };
+    float* deriv[2] = { out_dx, out_dy };
+    mcn_priv_noise_deriv_batch(fractal->noise, fractal, coords, 2, count, seed, out, deriv);
+}
+
+MCN_DEF void mcn_fractal_noise_3d_deriv_batch( const mcn_fractal_t* fractal, const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT seed,
+                                               float* out, float* out_dx, float* out_dy, float* out_dz ) {
+    assert(fractal && fractal->octaves > 0);
+    const float* coords[3] = { x, y, z };
+    float* deriv[3] = { out_dx, out_dy, out_dz };
+    mcn_priv_noise_deriv_batch(fractal->noise, fractal, coords, 3, count, seed, out, deriv);
+}
+
+// ---------------------------------------------------------------------------------------
+// Curl noise. In 2D the potential is a single noise and the velocity is its gradient
+//  rotated by 90 degrees. In 3D the potential is a vector of 3 noises with different
+//  seeds, and the velocity its curl. Velocities are written after all the noises of a
+//  chunk are evaluated, so they can overwrite the coordinates.
+// ---------------------------------------------------------------------------------------
+static MCHR_UINT mcn_priv_curl_seed(MCHR_UINT seed, MCHR_UINT component) {
+    return (component == 0) ? seed : mchr_get_1d_hash_uint(-4 - (MCHR_INT)component, seed);
+}
+
+static void mcn_priv_curl_noise_batch(const mcn_fractal_t* fractal, const float* const* coords, MCHR_UINT dims,
+                                      MCHR_UINT count, MCHR_UINT seed, float* const* velocity) {
+    assert(velocity[0] && velocity[1] && (dims < 3 || velocity[2]));
+    float value[MCN_CHUNK];
+    float potential_deriv[3][3][MCN_CHUNK];    // [component][axis]
+    for (MCHR_UINT first = 0; first < count; first += MCN_CHUNK) {
+        MCHR_UINT n = (count - first < MCN_CHUNK) ? count - first : MCN_CHUNK;
+        const float* chunk_coords[3];
+        for (MCHR_UINT d = 0; d < dims; ++d)
+            chunk_coords[d] = coords[d] + first;
+        MCHR_UINT components = (dims == 2) ? 1 : 3;
+        for (MCHR_UINT c = 0; c < components; ++c) {
+            float* deriv[3] = { potential_deriv[c][0], potential_deriv[c][1], potential_deriv[c][2] };
+            MCHR_UINT component_seed = mcn_priv_curl_seed(seed, c);
+            if (fractal) {
+                mcn_priv_fractal_noise_chunk(fractal, chunk_coords, dims, n, component_seed, NULL, value, deriv);
+            } else {
+                mcn_priv_base_noise_chunk(MCN_NOISE_GRADIENT, chunk_coords, dims, n, component_seed, NULL, value, deriv);
+            }
+        }
+        float* vx = velocity[0] + first;
+        float* vy = velocity[1] + first;
+        if (dims == 2) {
+            for (MCHR_UINT i = 0; i < n; ++i) {
+                vx[i] = potential_deriv[0][1][i];
+                vy[i] = -potential_deriv[0][0][i];
+            }
+        } else {
+            float* vz = velocity[2] + first;
+            for (MCHR_UINT i = 0; i < n; ++i) {
+                vx[i] = potential_deriv[2][1][i] - potential_deriv[1][2][i];
+                vy[i] = potential_deriv[0][2][i] - potential_deriv[2][0][i];
+                vz[i] = potential_deriv[1][0][i] - potential_deriv[0][1][i];
+            }
+        }
+    }
+}
+
+MCN_DEF void mcn_curl_noise_2d( float x, float y, MCHR_UINT seed, float* out_vx, float* out_vy ) {
+    const float* coords[2] = { &x, &y };
+    float* velocity[2] = { out_vx, out_vy };
+    mcn_priv_curl_noise_batch(NULL, coords, 2, 1, seed, velocity);
+}
+
+MCN_DEF void mcn_curl_noise_3d( float x, float y, float z, MCHR_UINT seed, float* out_vx, float* out_vy, float* out_vz ) {
+    const float* coords[3] = { &x, &y, &z };
+    float* velocity[3] = { out_vx, out_vy, out_vz };
+    mcn_priv_curl_noise_batch(NULL, coords, 3, 1, seed, velocity);
+}
+
+MCN_DEF void mcn_fractal_curl_noise_2d( const mcn_fractal_t* fractal, float x, float y, MCHR_UINT seed, float* out_vx, float* out_vy ) {
+    assert(fractal && fractal->octaves > 0);
+    const float* coords[2] = { &x, &y };
+    float* velocity[2] = { out_vx, out_vy };
+    mcn_priv_curl_noise_batch(fractal, coords, 2, 1, seed, velocity);
+}
+
+MCN_DEF void mcn_fractal_curl_noise_3d( const mcn_fractal_t* fractal, float x, float y, float z, MCHR_UINT seed,
+                                        float* out_vx, float* out_vy, float* out_vz ) {
+    assert(fractal && fractal->octaves > 0);
+    const float* coords[3] = { &x, &y, &z };
+    float* velocity[3] = { out_vx, out_vy, out_vz };
+    mcn_priv_curl_noise_batch(fractal, coords, 3, 1, seed, velocity);
+}
+
+MCN_DEF void mcn_curl_noise_2d_batch( const float* x, const float* y, MCHR_UINT count, MCHR_UINT seed, float* out_vx, float* out_vy ) {
+    const float* coords[2] = { x, y };
+    float* velocity[2] = { out_vx, out_vy };
+    mcn_priv_curl_noise_batch(NULL, coords, 2, count, seed, velocity);
+}
+
+MCN_DEF void mcn_curl_noise_3d_batch( const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT seed,
+                                      float* out_vx, float* out_vy, float* out_vz ) {
+    const float* coords[3] = { x, y, z };
+    float* velocity[3] = { out_vx, out_vy, out_vz };
+    mcn_priv_curl_noise_batch(NULL, coords, 3, count, seed, velocity);
+}
+
+MCN_DEF void mcn_fractal_curl_noise_2d_batch( const mcn_fractal_t* fractal, const float* x, const float* y, MCHR_UINT count, MCHR_UINT seed,
+                                              float* out_vx, float* out_vy ) {
+    assert(fractal && fractal->octaves > 0);
+    const float* coords[2] = { x, y };
+    float* velocity[2] = { out_vx, out_vy };
+    mcn_priv_curl_noise_batch(fractal, coords, 2, count, seed, velocity);
+}
+
+MCN_DEF void mcn_fractal_curl_noise_3d_batch( const mcn_fractal_t* fractal, const float* x, const float* y, const float* z, MCHR_UINT count,
+                                              MCHR_UINT seed, float* out_vx, float* out_vy, float* out_vz ) {
+    assert(fractal && fractal->octaves > 0);
+    const float* coords[3] = { x, y, z };
+    float* velocity[3] = { out_vx, out_vy, out_vz };
+    mcn_priv_curl_noise_batch(fractal, coords, 3, count, seed, velocity);
+}
+
+// ---------------------------------------------------------------------------------------
+// Periodic noise. Single points are evaluated as chunks of one point.
+// ---------------------------------------------------------------------------------------
+MCN_DEF float mcn_value_noise_2d_periodic( float x, float y, MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT seed ) {
+    const float* coords[2] = { &x, &y };
+    const MCHR_UINT period[2] = { period_x, period_y };
+    float result;
+    mcn_priv_lattice_noise_batch(MCN_PRIV_VALUE, coords, 2, 1, seed, period, &result);
+    return result;
+}
+
+MCN_DEF float mcn_value_noise_3d_periodic( float x, float y, float z, MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT period_z, MCHR_UINT seed ) {
+    const float* coords[3] = { &x, &y, &z };
+    const MCHR_UINT period[3] = { period_x, period_y, period_z };
+    float result;
+    mcn_priv_lattice_noise_batch(MCN_PRIV_VALUE, coords, 3, 1, seed, period, &result);
+    return result;
+}
+
+MCN_DEF float mcn_value_noise_4d_periodic( float x, float y, float z, float w, MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT period_z,
+                                           MCHR_UINT period_w, MCHR_UINT seed ) {
+    const float* coords[4] = { &x, &y, &z, &w };
+    const MCHR_UINT period[4] = { period_x, period_y, period_z, period_w };
+    float result;
+    mcn_priv_lattice_noise_batch(MCN_PRIV_VALUE, coords, 4, 1, seed, period, &result);
+    return result;
+}
+
+MCN_DEF float mcn_gradient_noise_2d_periodic( float x, float y, MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT seed ) {
+    const float* coords[2] = { &x, &y };
+    const MCHR_UINT period[2] = { period_x, period_y };
+    float result;
+    mcn_priv_lattice_noise_batch(MCN_PRIV_GRADIENT, coords, 2, 1, seed, period, &result);
+    return result;
+}
+
+MCN_DEF float mcn_gradient_noise_3d_periodic( float x, float y, float z, MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT period_z,
+                                              MCHR_UINT seed ) {
+    const float* coords[3] = { &x, &y, &z };
+    const MCHR_UINT period[3] = { period_x, period_y, period_z };
+    float result;
+    mcn_priv_lattice_noise_batch(MCN_PRIV_GRADIENT, coords, 3, 1, seed, period, &result);
+    return result;
+}
+
+MCN_DEF float mcn_gradient_noise_4d_periodic( float x, float y, float z, float w, MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT period_z,
+                                              MCHR_UINT period_w, MCHR_UINT seed ) {
+    const float* coords[4] = { &x, &y, &z, &w };
+    const MCHR_UINT period[4] = { period_x, period_y, period_z, period_w };
+    float result;
+    mcn_priv_lattice_noise_batch(MCN_PRIV_GRADIENT, coords, 4, 1, seed, period, &result);
+    return result;
+}
+
+MCN_DEF float mcn_cellular_noise_2d_periodic( float x, float y, MCHR_UINT period_x, MCHR_UINT period_y, float jitter, mcn_distance_t distance,
+                                              MCHR_UINT seed, float* out_f2, MCHR_UINT* out_cell_id ) {
+    const float* coords[2] = { &x, &y };
+    const MCHR_UINT period[2] = { period_x, period_y };
+    float result;
+    mcn_priv_cellular_batch(coords, 2, 1, jitter, distance, seed, period, &result, out_f2, out_cell_id);
+    return result;
+}
+
+MCN_DEF float mcn_cellular_noise_3d_periodic( float x, float y, float z, MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT period_z, float jitter,
+                                              mcn_distance_t distance, MCHR_UINT seed, float* out_f2, MCHR_UINT* out_cell_id ) {
+    const float* coords[3] = { &x, &y, &z };
+    const MCHR_UINT period[3] = { period_x, period_y, period_z };
+    float result;
+    mcn_priv_cellular_batch(coords, 3, 1, jitter, distance, seed, period, &result, out_f2, out_cell_id);
+    return result;
+}
+
+MCN_DEF float mcn_fractal_noise_2d_periodic( const mcn_fractal_t* fractal, float x, float y, MCHR_UINT period_x, MCHR_UINT period_y,
+                                             MCHR_UINT seed ) {
+    const float* coords[2] = { &x, &y };
+    const MCHR_UINT period[2] = { period_x, period_y };
+    float result;
+    mcn_priv_fractal_noise_batch(fractal, coords, 2, 1, seed, period, &result);
+    return result;
+}
+
+MCN_DEF float mcn_fractal_noise_3d_periodic( const mcn_fractal_t* fractal, float x, float y, float z, MCHR_UINT period_x, MCHR_UINT period_y,
+                                             MCHR_UINT period_z, MCHR_UINT seed ) {
+    const float* coords[3] = { &x, &y, &z };
+    const MCHR_UINT period[3] = { period_x, period_y, period_z };
+    float result;
+    mcn_priv_fractal_noise_batch(fractal, coords, 3, 1, seed, period, &result);
+    return result;
+}
+
+MCN_DEF void mcn_value_noise_2d_periodic_batch( const float* x, const float* y, MCHR_UINT count, MCHR_UINT period_x, MCHR_UINT period_y,
+                                                MCHR_UINT seed, float* out ) {
+    const float* coords[2] = { x, y };
+    const MCHR_UINT period[2] = { period_x, period_y };
+    mcn_priv_lattice_noise_batch(MCN_PRIV_VALUE, coords, 2, count, seed, period, out);
+}
+
+MCN_DEF void mcn_value_noise_3d_periodic_batch( const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT period_x,
+                                                MCHR_UINT period_y, MCHR_UINT period_z, MCHR_UINT seed, float* out ) {
+    const float* coords[3] = { x, y, z };
+    const MCHR_UINT period[3] = { period_x, period_y, period_z };
+    mcn_priv_lattice_noise_batch(MCN_PRIV_VALUE, coords, 3, count, seed, period, out);
+}
+
+MCN_DEF void mcn_value_noise_4d_periodic_batch( const float* x, const float* y, const float* z, const float* w, MCHR_UINT count, MCHR_UINT period_x,
+                                                MCHR_UINT period_y, MCHR_UINT period_z, MCHR_UINT period_w, MCHR_UINT seed, float* out ) {
+    const float* coords[4] = { x, y, z, w };
+    const MCHR_UINT period[4] = { period_x, period_y, period_z, period_w };
+    mcn_priv_lattice_noise_batch(MCN_PRIV_VALUE, coords, 4, count, seed, period, out);
+}
+
+MCN_DEF void mcn_gradient_noise_2d_periodic_batch( const float* x, const float* y, MCHR_UINT count, MCHR_UINT period_x, MCHR_UINT period_y,
+                                                   MCHR_UINT seed, float* out ) {
+    const float* coords[2] = { x, y };
+    const MCHR_UINT period[2] = { period_x, period_y };
+    mcn_priv_lattice_noise_batch(MCN_PRIV_GRADIENT, coords, 2, count, seed, period, out);
+}
+
+MCN_DEF void mcn_gradient_noise_3d_periodic_batch( const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT period_x,
+                                                   MCHR_UINT period_y, MCHR_UINT period_z, MCHR_UINT seed, float* out ) {
+    const float* coords[3] = { x, y, z };
+    const MCHR_UINT period[3] = { period_x, period_y, period_z };
+    mcn_priv_lattice_noise_batch(MCN_PRIV_GRADIENT, coords, 3, count, seed, period, out);
+}
+
+MCN_DEF void mcn_gradient_noise_4d_periodic_batch( const float* x, const float* y, const float* z, const float* w, MCHR_UINT count,
+                                                   MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT period_z, MCHR_UINT period_w, MCHR_UINT seed,
+                                                   float* out ) {
+    const float* coords[4] = { x, y, z, w };
+    const MCHR_UINT period[4] = { period_x, period_y, period_z, period_w };
+    mcn_priv_lattice_noise_batch(MCN_PRIV_GRADIENT, coords, 4, count, seed, period, out);
+}
+
+MCN_DEF void mcn_cellular_noise_2d_periodic_batch( const float* x, const float* y, MCHR_UINT count, MCHR_UINT period_x, MCHR_UINT period_y,
+                                                   float jitter, mcn_distance_t distance, MCHR_UINT seed, float* out_f1, float* out_f2,
+                                                   MCHR_UINT* out_cell_id ) {
+    const float* coords[2] = { x, y };
+    const MCHR_UINT period[2] = { period_x, period_y };
+    mcn_priv_cellular_batch(coords, 2, count, jitter, distance, seed, period, out_f1, out_f2, out_cell_id);
+}
+
+MCN_DEF void mcn_cellular_noise_3d_periodic_batch( const float* x, const float* y, const float* z, MCHR_UINT count, MCHR_UINT period_x,
+                                                   MCHR_UINT period_y, MCHR_UINT period_z, float jitter, mcn_distance_t distance, MCHR_UINT seed,
+                                                   float* out_f1, float* out_f2, MCHR_UINT* out_cell_id ) {
+    const float* coords[3] = { x, y, z };
+    const MCHR_UINT period[3] = { period_x, period_y, period_z };
+    mcn_priv_cellular_batch(coords, 3, count, jitter, distance, seed, period, out_f1, out_f2, out_cell_id);
+}
+
+MCN_DEF void mcn_fractal_noise_2d_periodic_batch( const mcn_fractal_t* fractal, const float* x, const float* y, MCHR_UINT count, MCHR_UINT period_x,
+                                                  MCHR_UINT period_y, MCHR_UINT seed, float* out ) {
+    const float* coords[2] = { x, y };
+    const MCHR_UINT period[2] = { period_x, period_y };
+    mcn_priv_fractal_noise_batch(fractal, coords, 2, count, seed, period, out);
+}
+
+MCN_DEF void mcn_fractal_noise_3d_periodic_batch( const mcn_fractal_t* fractal, const float* x, const float* y, const float* z, MCHR_UINT count,
+                                                  MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT period_z, MCHR_UINT seed, float* out ) {
+    const float* coords[3] = { x, y, z };
+    const MCHR_UINT period[3] = { period_x, period_y, period_z };
+    mcn_priv_fractal_noise_batch(fractal, coords, 3, count, seed, period, out);
+}
+
+MCN_DEF void mcn_value_noise_2d_periodic_grid( float start_x, float start_y, float step_x, float step_y, MCHR_UINT width, MCHR_UINT height,
+                                               MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT seed, float* out ) {
+    const MCHR_UINT period[2] = { period_x, period_y };
+    mcn_priv_lattice_noise_2d_grid(MCN_PRIV_VALUE, start_x, start_y, step_x, step_y, width, height, seed, period, out);
+}
+
+MCN_DEF void mcn_value_noise_3d_periodic_grid( float start_x, float start_y, float start_z, float step_x, float step_y, float step_z,
+                                               MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT period_x, MCHR_UINT period_y,
+                                               MCHR_UINT period_z, MCHR_UINT seed, float* out ) {
+    const MCHR_UINT period[3] = { period_x, period_y, period_z };
+    mcn_priv_lattice_noise_3d_grid(MCN_PRIV_VALUE, start_x, start_y, start_z, step_x, step_y, step_z, width, height, depth, seed, period, out);
+}
+
+MCN_DEF void mcn_gradient_noise_2d_periodic_grid( float start_x, float start_y, float step_x, float step_y, MCHR_UINT width, MCHR_UINT height,
+                                                  MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT seed, float* out ) {
+    const MCHR_UINT period[2] = { period_x, period_y };
+    mcn_priv_lattice_noise_2d_grid(MCN_PRIV_GRADIENT, start_x, start_y, step_x, step_y, width, height, seed, period, out);
+}
+
+MCN_DEF void mcn_gradient_noise_3d_periodic_grid( float start_x, float start_y, float start_z, float step_x, float step_y, float step_z,
+                                                  MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT period_x, MCHR_UINT period_y,
+                                                  MCHR_UINT period_z, MCHR_UINT seed, float* out ) {
+    const MCHR_UINT period[3] = { period_x, period_y, period_z };
+    mcn_priv_lattice_noise_3d_grid(MCN_PRIV_GRADIENT, start_x, start_y, start_z, step_x, step_y, step_z, width, height, depth, seed, period, out);
+}
+
+MCN_DEF void mcn_cellular_noise_2d_periodic_grid( float start_x, float start_y, float step_x, float step_y, MCHR_UINT width, MCHR_UINT height,
+                                                  MCHR_UINT period_x, MCHR_UINT period_y, float jitter, mcn_distance_t distance, MCHR_UINT seed,
+                                                  float* out_f1, float* out_f2, MCHR_UINT* out_cell_id ) {
+    const MCHR_UINT period[2] = { period_x, period_y };
+    mcn_priv_cellular_grid(2, start_x, start_y, 0.0f, step_x, step_y, 0.0f, width, height, 1, jitter, distance, seed, period, out_f1, out_f2, out_cell_id);
+}
+
+MCN_DEF void mcn_cellular_noise_3d_periodic_grid( float start_x, float start_y, float start_z, float step_x, float step_y, float step_z,
+                                                  MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT period_x, MCHR_UINT period_y,
+                                                  MCHR_UINT period_z, float jitter, mcn_distance_t distance, MCHR_UINT seed, float* out_f1,
+                                                  float* out_f2, MCHR_UINT* out_cell_id ) {
+    const MCHR_UINT period[3] = { period_x, period_y, period_z };
+    mcn_priv_cellular_grid(3, start_x, start_y, start_z, step_x, step_y, step_z, width, height, depth, jitter, distance, seed, period, out_f1, out_f2, out_cell_id);
+}
+
+MCN_DEF void mcn_fractal_noise_2d_periodic_grid( const mcn_fractal_t* fractal, float start_x, float start_y, float step_x, float step_y,
+                                                 MCHR_UINT width, MCHR_UINT height, MCHR_UINT period_x, MCHR_UINT period_y, MCHR_UINT seed,
+                                                 float* out ) {
+    const MCHR_UINT period[2] = { period_x, period_y };
+    mcn_priv_fractal_noise_grid(fractal, 2, start_x, start_y, 0.0f, step_x, step_y, 0.0f, width, height, 1, seed, period, out);
+}
+
+MCN_DEF void mcn_fractal_noise_3d_periodic_grid( const mcn_fractal_t* fractal, float start_x, float start_y, float start_z, float step_x,
+                                                 float step_y, float step_z, MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT period_x,
+                                                 MCHR_UINT period_y, MCHR_UINT period_z, MCHR_UINT seed, float* out ) {
+    const MCHR_UINT period[3] = { period_x, period_y, period_z };
+    mcn_priv_fractal_noise_grid(fractal, 3, start_x, start_y, start_z, step_x, step_y, step_z, width, height, depth, seed, period, out);
+}
+
+#endif // MCN_IMPLEMENTATION
+
+/*
+------------------------------------------------------------------------------------------
+This software is available under the MIT license.
+------------------------------------------------------------------------------------------
+MIT License
+
+Copyright (c) 2021 Miguel A. Friginal
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+------------------------------------------------------------------------------------------
+*/
@@ -0,0 +1,1435 @@
+// mc_sampling.h - v0.6 - public domain, initial release 2026-10-16 - Miguel A. Friginal
+//
+// Deterministic sample patterns built on mc_hash_rng.h.
+//
+// This is a single-header-file library that provides point patterns for procedural
+// placement: points spread over the plane with a minimum distance between them, and
+// similar patterns. Every pattern is a pure function of its parameters and a seed, with
+// all its random decisions taken from the hash functions in mc_hash_rng.h, so any part of
+// a pattern can be generated on its own (e.g. the points of one world chunk, on any
+// thread) and always agrees with the neighbouring parts.
+//
+//
+// This library is based on the work of many online sources, mainly:
+//
+//   Fast Poisson Disk Sampling in Arbitrary Dimensions by Robert Bridson
+//      https://www.cs.ubc.ca/~rbridson/docs/bridson-siggraph07-poissondisk.pdf
+//
+//   Parallel Poisson Disk Sampling by Li-Yi Wei
+//      https://www.microsoft.com/en-us/research/publication/parallel-poisson-disk-sampling/
+//
+//   Multi-Jittered Sampling by Kenneth Chiu, Peter Shirley and Changyaw Wang
+//      Graphics Gems IV
+//
+//   Correlated Multi-Jittered Sampling by Andrew Kensler
+//      https://graphics.pixar.com/library/MultiJitteredSampling/
+//
+//   Practical Hash-based Owen Scrambling by Brent Burley
+//      https://jcgt.org/published/0009/04/01/
+//
+//   The Unreasonable Effectiveness of Quasirandom Sequences by Martin Roberts
+//      http://extremelearning.com.au/unreasonable-effectiveness-of-quasirandom-sequences/
+//
+//   The void-and-cluster method for dither array generation by Robert Ulichney
+//      https://doi.org/10.1117/12.152707
+//
+//   Scalar Spatiotemporal Blue Noise Masks by Alan Wolfe, Nathan Morrical, Tomas
+//   Akenine-Moller and Ravi Ramamoorthi
+//      https://arxiv.org/abs/2112.09629
+//
+//   Wang Tiles for Image and Texture Generation by Michael F. Cohen, Jonathan Shade,
+//   Stefan Hiller and Oliver Deussen
+//      https://doi.org/10.1145/882262.882265
+//
+//   An Alternative for Wang Tiles: Colored Edges versus Colored Corners by Ares Lagae and
+//   Philip Dutre
+//      https://doi.org/10.1145/1183287.1183296
+//
+//   A Linear Algorithm For Generating Random Numbers With a Given Distribution by
+//   Michael D. Vose
+//      https://doi.org/10.1109/32.92917
+//
+//
+// History:
+//
+//      0.6 (2026-10-17) Added triangle mesh scattering.
+//      0.5 (2026-10-17) Added Wang and corner tiles.
+//      0.4 (2026-10-17) Added blue-noise masks.
+//      0.3 (2026-10-16) Added low-discrepancy sequences.
+//      0.2 (2026-10-16) Added stratified patterns.
+//      0.1 (2026-10-16) First version, with Poisson-disk sampling.
+//
+//
+// Compiling:
+//
+//   This library depends on mc_hash_rng.h, which needs to be in the include path. In one
+//   C/C++ file that #includes this file, do
+//
+//      #define MCHR_IMPLEMENTATION
+//      #define MCS_IMPLEMENTATION
+//      #include "mc_sampling.h"
+//
+//   (the implementation of mc_hash_rng.h can also be compiled in a different file).
+//
+//   Optionally, #define MCS_STATIC before including the header to cause definitions to be
+//   private to the implementation file (i.e. to be "static" instead of "extern"). The
+//   integer types are the ones selected by mc_hash_rng.h (see MCHR_USE_STDINT).
+//
+//
+// License:
+//
+//   See end of file for license information.
+//
+//
+// Usage:
+//
+//   Functions producing a variable number of points take the output arrays (SoA, one per
+//   axis) and their capacity, and return the number of points in the pattern, which can
+//   be larger than the capacity (only the first `capacity` points are written then).
+//   Functions needing temporary memory take a `work` buffer of the size returned by their
+//   `_work_size()` function, so the library never allocates memory.
+//
+//
+// Poisson-disk sampling:
+//
+//   `mcs_poisson_disk_2d()` returns the points of an infinite Poisson-disk pattern (points
+//   no closer than `radius` to each other, and spread evenly) that fall inside a
+//   rectangle. Rectangles can have any position and size, and the points of adjacent
+//   rectangles respect the radius across their borders, so chunks of a world can be
+//   populated independently:
+//
+//          float min_x = chunk_x * CHUNK_SIZE, min_y = chunk_y * CHUNK_SIZE;
+//          float max_x = min_x + CHUNK_SIZE, max_y = min_y + CHUNK_SIZE;
+//          MCHR_UINT capacity = mcs_poisson_disk_2d_max_points(min_x, min_y, max_x, max_y, radius);
+//          void* work = malloc(mcs_poisson_disk_2d_work_size(min_x, min_y, max_x, max_y, radius));
+//          MCHR_UINT count = mcs_poisson_disk_2d(min_x, min_y, max_x, max_y, radius, seed, work,
+//                                                trees_x, trees_y, capacity);
+//
+//   The pattern comes from dart throwing on a grid of square cells of side radius/sqrt(2)
+//   (so a cell holds at most one point), in MCS_POISSON_ROUNDS rounds. In every round,
+//   each empty cell gets a candidate point, placed by the hash of the cell and round, that
+//   is accepted unless it's too close to a point accepted in an earlier round, or to a
+//   candidate with a higher hashed priority in the same round. A cell only depends on
+//   the cells up to 2 away in the previous round, so a rectangle is evaluated from the
+//   cells around it up to 2 * MCS_POISSON_ROUNDS cells away (plus one on every side for
+//   rounding). For a rectangle covering w x h cells, the cost and the work buffer are
+//   proportional to (w + 4 * MCS_POISSON_ROUNDS + 2) x (h + 4 * MCS_POISSON_ROUNDS + 2)
+//   cells, (w + 18) x (h + 18) with the default 4 rounds, so small rectangles pay mostly
+//   for their margin (a 5 x 5 cell rectangle evaluates 23 x 23 cells); prefer rectangles
+//   of a few dozen cells per side. Points are written in row-major order of their cells.
+//
+//
+// Stratified patterns:
+//
+//   `mcs_cell_pattern_2d()` places `count` points inside the unit square of a grid cell,
+//   splitting it into `columns` x `rows` strata (columns = floor(sqrt(count)), rows =
+//   enough to hold `count`) and placing one point in each of the first `count` strata, in
+//   row-major order. The pattern of each cell comes from the hash of its coordinates and
+//   the seed, so neighbouring cells get different patterns:
+//
+//      MCS_PATTERN_STRATIFIED                  the centres of the strata (no randomness)
+//      MCS_PATTERN_JITTERED                    a random point in each stratum
+//      MCS_PATTERN_MULTI_JITTERED              jittered, and also a single point in each
+//                                              column and row of the finer grid that
+//                                              splits every stratum in rows x columns
+//                                              substrata, (columns * rows)^2 in total;
+//                                              this only holds when count equals
+//                                              columns * rows (e.g. 4, 6 or 9, but not 5,
+//                                              whose 2 x 3 strata leave one empty)
+//      MCS_PATTERN_CORRELATED_MULTI_JITTERED   multi-jittered, shuffling every row and
+//                                              column of strata in the same way, which
+//                                              spreads the points more evenly
+//
+//   Points are returned inside [0, 1) x [0, 1) of the cell. `mcs_cell_pattern_2d_tile()`
+//   fills a tile of `cells_x` x `cells_y` cells of side `cell_size` in a single call,
+//   writing `count` points per cell, cell by cell in row-major order, each one at
+//   `(cell_x + u) * cell_size` for the point (u, v) that `mcs_cell_pattern_2d()` returns
+//   for the cell:
+//
+//          float probes_x[16 * 16 * 4], probes_y[16 * 16 * 4];
+//          mcs_cell_pattern_2d_tile(MCS_PATTERN_CORRELATED_MULTI_JITTERED, 4, tile_x * 16,
+//                                   tile_y * 16, 16, 16, CELL_SIZE, seed, probes_x, probes_y);
+//
+//   Random offsets use 16 bits per axis of a single hash per point, so their resolution
+//   is 1/65536 of a stratum (or of a substratum, for the multi-jittered patterns).
+//
+//
+// Low-discrepancy sequences:
+//
+//   `mcs_sobol()`, `mcs_halton()` and `mcs_r2()` return the point at any index of a
+//   low-discrepancy sequence, which fills [0, 1)^n more evenly than independent random
+//   values, so Monte Carlo estimates using the first N points converge faster. Every
+//   dimension of a point is evaluated on its own and in O(1), so a point uses as many
+//   dimensions as it needs, and any range of indices can be computed by any thread:
+//
+//          for (MCHR_UINT i = 0; i < SAMPLES; ++i) {
+//              float lens_x = mcs_sobol(i, 0, seed), lens_y = mcs_sobol(i, 1, seed);
+//              float time = mcs_sobol(i, 2, seed);
+//              ...
+//          }
+//
+//   The sequences are scrambled by the seed, so different seeds give different sequences
+//   with the same good distribution:
+//
+//      Sobol   Owen-scrambled Sobol points, with the nested uniform scramble of Burley. The
+//              dimensions are taken in groups of 4, each one being the first 4 dimensions
+//              of the Sobol sequence, shuffled by an index permutation of its own, so the
+//              points are well distributed in every group and the groups are decorrelated
+//              from each other. Any dimension can be used.
+//      Halton  Owen-scrambled radical inverse with a different prime base in each dimension,
+//              for up to MCS_HALTON_MAX_DIMENSIONS dimensions. Each digit is permuted by a
+//              hash of the seed, dimension and all the preceding digits, so it's slower than
+//              Sobol, specially in high dimensions.
+//      R2      The 2D sequence of Roberts (a generalisation of the golden ratio sequence),
+//              with a random offset in each dimension. It's the fastest, and its points are
+//              evenly spread at any count, but it is not stratified like the others.
+//
+//   `_batch()` versions write a range of indices of one dimension (two for R2) to SoA
+//   arrays, evaluating the scrambling seeds only once.
+//
+//
+// Blue-noise masks:
+//
+//   `mcs_blue_noise_generate()` creates a tileable blue-noise threshold mask of `width`
+//   x `height` pixels with the void-and-cluster method, ranking every pixel so that the
+//   pixels under any threshold are evenly spread. Values are 16 bit thresholds, uniformly
+//   distributed over [0, 65536), and `mcs_blue_noise_sample()` returns them as floats in
+//   [0, 1) for any (wrapped) pixel coordinates. Masks with a `depth` of more than 1 are
+//   spatio-temporal: every slice is a blue-noise mask, and the values of a pixel along
+//   the slices are also blue noise, so cycling through the slices over time gives noise
+//   that averages out quickly. Different seeds give different masks.
+//
+//   Generating a mask takes O(pixels^2) time in the worst case (a 128x128 mask takes
+//   tenths of a second), so masks are usually generated once and cached. The cache is a
+//   block of bytes that holds a header and the values, which can be written to a file
+//   and later memory mapped (or read) and used in place, without copying:
+//
+//          size_t size = mcs_blue_noise_cache_size(128, 128, 1);
+//          const unsigned short* mask;
+//          void* cache = map_file("blue_noise.bin", size);
+//          if (!cache || !mcs_blue_noise_read_cache(cache, size, 128, 128, 1, seed, &mask)) {
+//              void* work = malloc(mcs_blue_noise_work_size(128, 128, 1));
+//              cache = malloc(size);
+//              unsigned short* values = mcs_blue_noise_cache_values(cache);
+//              mcs_blue_noise_generate(128, 128, 1, seed, work, values);
+//              mcs_blue_noise_write_cache(cache, 128, 128, 1, seed);
+//              write_file("blue_noise.bin", cache, size);
+//              mask = values;
+//          }
+//
+//   The cache header records the size and seed of the mask, and a hash of its values, so
+//   `mcs_blue_noise_read_cache()` rejects caches of different masks, and truncated or
+//   corrupted files. Caches are stored with the byte order of the machine, and are also
+//   rejected on machines with a different one. The cache must be 4-byte aligned (memory
+//   mapped files always are).
+//
+//
+// Wang and corner tiles:
+//
+//   `mcs_wang_tile_2d()` returns the tile of an aperiodic tiling at any grid position,
+//   from a complete set of Wang tiles with `colors` edge colours (colors^4 tiles, one for
+//   every combination of edges). Every edge of the grid gets a colour from
+//   `mchr_get_2d_hash_uint_in_range()` of its coordinates, so neighbouring tiles always
+//   match along their shared edge, and the tile index encodes the colours of its edges:
+//
+//          index = ((north * colors + east) * colors + south) * colors + west
+//
+//   North is the edge shared with tile (x, y - 1), and west the one shared with tile
+//   (x - 1, y). `mcs_corner_tile_2d()` does the same with corner tiles, colouring the
+//   vertices of the grid instead, so tiles also match the diagonal neighbours:
+//
+//          index = ((north_west * colors + north_east) * colors + south_west) * colors + south_east
+//
+//   The `_map()` versions fill `width` x `height` tiles in row-major order, hashing every
+//   edge (or vertex) only once and in batches of consecutive coordinates:
+//
+//          MCHR_UINT tiles[32 * 32];
+//          mcs_wang_tile_2d_map(chunk_x * 32, chunk_y * 32, 32, 32, 2, seed, tiles);
+//          for (int i = 0; i < 32 * 32; ++i)
+//              draw_tile(tile_set[tiles[i]], ...);
+//
+//   Colours are between 1 and 256 (a single colour gives the same tile everywhere).
+//
+//
+// Mesh scattering:
+//
+//   `mcs_mesh_sampler_init()` prepares a triangle mesh (vertex positions, and 3 vertex
+//   indices per triangle) for scattering points uniformly over its surface, building an
+//   alias table of the triangle areas in the work buffer (which must be 8-byte aligned,
+//   as malloc returns it), which the sampler uses until it's discarded. Every sample then
+//   picks a triangle with a probability proportional to its area, and a uniform point
+//   inside it, in O(1) and from hashes of its index and the seed alone, so a mesh gets
+//   the same N points for the same seed whatever the order or the thread that generates
+//   them:
+//
+//          mcs_mesh_sampler_t sampler;
+//          void* work = malloc(mcs_mesh_sampler_work_size(triangle_count));
+//          mcs_mesh_sampler_init(&sampler, positions, indices, triangle_count, work);
+//          MCHR_UINT count = (MCHR_UINT)(sampler.total_area * GRASS_PER_SQUARE_METER);
+//          mcs_mesh_sample_batch(&sampler, 0, count, seed, triangles, NULL, NULL, grass_x, grass_y, grass_z);
+//
+//   Samples also return their triangle and the barycentric coordinates (u, v) of the
+//   point in it, the weights of its second and third vertices, to interpolate normals,
+//   texture coordinates or other vertex attributes; any output can be NULL if not needed.
+//   Batch versions write consecutive indices to SoA arrays, hashing them in batches.
+//
+//
+// Determinism:
+//
+//   Patterns only use additions, multiplications, divisions, square roots and comparisons
+//   on floats, which are exactly rounded by IEEE 754. Results are the same across
+//   platforms and compilers only if every operation is rounded to float on its own:
+//   build with -ffp-contract=off and without -ffast-math (GCC and Clang otherwise fuse
+//   multiply-adds on targets with FMA), and with SSE rather than x87 math, which keeps
+//   intermediates in extended precision (-msse2 -mfpmath=sse on 32-bit x86).
+//
+//
+// Thread-safety:
+//
+//   All functions are pure functions, and can be called from any thread, as long as
+//   every call has its own work buffer.
+
+#ifndef MCS_INCLUDE_MC_SAMPLING_H
+#define MCS_INCLUDE_MC_SAMPLING_H
+
+// std includes here
+#include <stddef.h>
+#include "mc_hash_rng.h"
+
+#ifdef MCS_STATIC
+#define MCS_DEF static
+#else
+#ifdef __cplusplus
+#define MCS_DEF extern "C"
+#else
+#define MCS_DEF extern
+#endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ---------------------------------------------------------------------------------------
+// Poisson-disk sampling: the points, no closer than `radius` to each other, inside the
+//  rectangle [min_x, max_x) x [min_y, max_y) of an infinite pattern.
+// ---------------------------------------------------------------------------------------
+MCS_DEF MCHR_UINT mcs_poisson_disk_2d_max_points( float min_x, float min_y, float max_x, float max_y, float radius );
+MCS_DEF size_t    mcs_poisson_disk_2d_work_size( float min_x, float min_y, float max_x, float max_y, float radius );
+MCS_DEF MCHR_UINT mcs_poisson_disk_2d( float min_x, float min_y, float max_x, float max_y, float radius, MCHR_UINT seed, void* work,
+                                       float* out_x, float* out_y, MCHR_UINT capacity );
+
+// ---------------------------------------------------------------------------------------
+// Stratified patterns: `count` points per cell, one per stratum of the cell. Single cells
+//  return points inside [0, 1) x [0, 1); tiles return `count` points for each of their
+//  cells, in row-major order, in the coordinates of the grid scaled by `cell_size`.
+// ---------------------------------------------------------------------------------------
+typedef enum mcs_pattern_t {
+    MCS_PATTERN_STRATIFIED,                 // centres of the strata
+    MCS_PATTERN_JITTERED,                   // random point in each stratum
+    MCS_PATTERN_MULTI_JITTERED,             // jittered, one point per row and column of substrata
+    MCS_PATTERN_CORRELATED_MULTI_JITTERED   // multi-jittered, same shuffle in every row and column
+} mcs_pattern_t;
+
+MCS_DEF void mcs_cell_pattern_2d( mcs_pattern_t pattern, MCHR_UINT count, MCHR_INT cell_x, MCHR_INT cell_y, MCHR_UINT seed,
+                                  float* out_x, float* out_y );
+MCS_DEF void mcs_cell_pattern_2d_tile( mcs_pattern_t pattern, MCHR_UINT count, MCHR_INT first_cell_x, MCHR_INT first_cell_y,
+                                       MCHR_UINT cells_x, MCHR_UINT cells_y, float cell_size, MCHR_UINT seed,
+                                       float* out_x, float* out_y );
+
+// ---------------------------------------------------------------------------------------
+// Low-discrepancy sequences: value of `dimension` of the point at `index` of a scrambled
+//  sequence, in [0, 1). Batch versions evaluate `count` points from `first_index`.
+// ---------------------------------------------------------------------------------------
+#define MCS_HALTON_MAX_DIMENSIONS 32
+
+MCS_DEF float mcs_sobol( MCHR_UINT index, MCHR_UINT dimension, MCHR_UINT seed );
+MCS_DEF void  mcs_sobol_batch( MCHR_UINT first_index, MCHR_UINT count, MCHR_UINT dimension, MCHR_UINT seed, float* out );
+
+MCS_DEF float mcs_halton( MCHR_UINT index, MCHR_UINT dimension, MCHR_UINT seed );
+MCS_DEF void  mcs_halton_batch( MCHR_UINT first_index, MCHR_UINT count, MCHR_UINT dimension, MCHR_UINT seed, float* out );
+
+MCS_DEF void  mcs_r2( MCHR_UINT index, MCHR_UINT seed, float* out_x, float* out_y );
+MCS_DEF void  mcs_r2_batch( MCHR_UINT first_index, MCHR_UINT count, MCHR_UINT seed, float* out_x, float* out_y );
+
+// ---------------------------------------------------------------------------------------
+// Blue-noise masks: `width` x `height` x `depth` thresholds, stored row by row and slice
+//  by slice (depth is 1 for 2D masks). Caches hold a header and the thresholds, that
+//  `mcs_blue_noise_cache_values()` points to.
+// ---------------------------------------------------------------------------------------
+MCS_DEF size_t mcs_blue_noise_work_size( MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth );
+MCS_DEF void   mcs_blue_noise_generate( MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT seed, void* work,
+                                        unsigned short* out_values );
+MCS_DEF float  mcs_blue_noise_sample( const unsigned short* values, MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth,
+                                      MCHR_INT x, MCHR_INT y, MCHR_INT t );
+
+MCS_DEF size_t          mcs_blue_noise_cache_size( MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth );
+MCS_DEF unsigned short* mcs_blue_noise_cache_values( void* cache );
+MCS_DEF void            mcs_blue_noise_write_cache( void* cache, MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT seed );
+MCS_DEF bool            mcs_blue_noise_read_cache( const void* cache, size_t size, MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth,
+                                                   MCHR_UINT seed, const unsigned short** out_values );
+
+// ---------------------------------------------------------------------------------------
+// Wang and corner tiles: index, in a complete set of tiles with `colors` colours, of the
+//  tile at a grid position. Map versions fill `width` x `height` tiles in row-major order.
+// ---------------------------------------------------------------------------------------
+MCS_DEF MCHR_UINT mcs_wang_tile_2d( MCHR_INT x, MCHR_INT y, MCHR_UINT colors, MCHR_UINT seed );
+MCS_DEF void      mcs_wang_tile_2d_map( MCHR_INT first_x, MCHR_INT first_y, MCHR_UINT width, MCHR_UINT height, MCHR_UINT colors,
+                                        MCHR_UINT seed, MCHR_UINT* out );
+
+MCS_DEF MCHR_UINT mcs_corner_tile_2d( MCHR_INT x, MCHR_INT y, MCHR_UINT colors, MCHR_UINT seed );
+MCS_DEF void      mcs_corner_tile_2d_map( MCHR_INT first_x, MCHR_INT first_y, MCHR_UINT width, MCHR_UINT height, MCHR_UINT colors,
+                                          MCHR_UINT seed, MCHR_UINT* out );
+
+// ---------------------------------------------------------------------------------------
+// Mesh scattering: uniformly distributed points on the surface of a triangle mesh. The
+//  sampler references the position and index arrays, which are owned by the caller, and
+//  keeps its alias table in the work buffer; all of them must outlive it.
+// ---------------------------------------------------------------------------------------
+typedef struct mcs_mesh_sampler_t {
+    const float* positions;         // x, y, z of each vertex
+    const MCHR_UINT* indices;       // 3 vertex indices per triangle
+    MCHR_UINT triangle_count;
+    float total_area;
+    MCHR_UINT* thresholds;          // alias table, in the work buffer
+    MCHR_UINT* aliases;
+} mcs_mesh_sampler_t;
+
+MCS_DEF size_t mcs_mesh_sampler_work_size( MCHR_UINT triangle_count );
+MCS_DEF void   mcs_mesh_sampler_init( mcs_mesh_sampler_t* sampler, const float* positions, const MCHR_UINT* indices,
+                                      MCHR_UINT triangle_count, void* work );
+MCS_DEF void   mcs_mesh_sample( const mcs_mesh_sampler_t* sampler, MCHR_UINT index, MCHR_UINT seed, MCHR_UINT* out_triangle,
+                                float* out_u, float* out_v, float* out_x, float* out_y, float* out_z );
+MCS_DEF void   mcs_mesh_sample_batch( const mcs_mesh_sampler_t* sampler, MCHR_UINT first_index, MCHR_UINT count, MCHR_UINT seed,
+                                      MCHR_UINT* out_triangles, float* out_u, float* out_v, float* out_x, float* out_y, float* out_z );
+
+#ifdef __cplusplus
+}
+#endif
+
+// END OF HEDER FILE ---------------------------------------------------------------------
+#endif // MCS_INCLUDE_MC_SAMPLING_H
+
+
+#if defined(MCS_IMPLEMENTATION) && !defined(MCS_IMPLEMENTATION_INCLUDED)
+#define MCS_IMPLEMENTATION_INCLUDED
+
+// std includes here
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+// Number of dart throwing rounds of Poisson-disk sampling. More rounds fill the plane more
+//  densely, but evaluate more cells around every rectangle.
+#ifndef MCS_POISSON_ROUNDS
+#define MCS_POISSON_ROUNDS 4
+#endif
+
+static MCHR_INT mcs_priv_floor(float x) {
+    MCHR_INT i = (MCHR_INT)x;
+    return i - (x < (float)i);
+}
+
+// ---------------------------------------------------------------------------------------
+// Poisson-disk sampling. Cells of the rectangle and of the margin around it are kept in
+//  the work buffer, in row-major order. Round k is evaluated on the cells at least 2k + 2
+//  cells away from the border of the buffer, and its candidates on the ones at least 2k
+//  away, so the last round covers exactly the cells of the rectangle.
+// ---------------------------------------------------------------------------------------
+#define MCS_PRIV_POISSON_MARGIN (2 * MCS_POISSON_ROUNDS)
+
+typedef struct mcs_priv_poisson_cell_t {
+    float x, y;                     // accepted point
+    float candidate_x, candidate_y;
+    MCHR_UINT priority;
+    MCHR_UINT round;                // 1 + the round that filled the cell, 0 while empty
+} mcs_priv_poisson_cell_t;
+
+typedef struct mcs_priv_poisson_region_t {
+    float cell_size;
+    MCHR_INT first_x, first_y;      // cell coordinates of the first cell of the margin
+    MCHR_UINT width, height;        // in cells, margin included
+} mcs_priv_poisson_region_t;
+
+static void mcs_priv_poisson_region(float min_x, float min_y, float max_x, float max_y, float radius, mcs_priv_poisson_region_t* out) {
+    assert(radius > 0.0f);
+    assert(min_x <= max_x && min_y <= max_y);
+    out->cell_size = radius * 0.70710678f;
+    // one more cell on every side, in case rounding moves a point into the rectangle
+    MCHR_INT x0 = mcs_priv_floor(min_x / out->cell_size) - 1, x1 = mcs_priv_floor(max_x / out->cell_size) + 1;
+    MCHR_INT y0 = mcs_priv_floor(min_y / out->cell_size) - 1, y1 = mcs_priv_floor(max_y / out->cell_size) + 1;
+    out->first_x = x0 - MCS_PRIV_POISSON_MARGIN;
+    out->first_y = y0 - MCS_PRIV_POISSON_MARGIN;
+    out->width = (MCHR_UINT)(x1 - x0) + 1 + 2 * MCS_PRIV_POISSON_MARGIN;
+    out->height = (MCHR_UINT)(y1 - y0) + 1 + 2 * MCS_PRIV_POISSON_MARGIN;
+}
+
+MCS_DEF MCHR_UINT mcs_poisson_disk_2d_max_points( float min_x, float min_y, float max_x, float max_y, float radius ) {
+    mcs_priv_poisson_region_t region;
+    mcs_priv_poisson_region(min_x, min_y, max_x, max_y, radius, &region);
+    return (region.width - 2 * MCS_PRIV_POISSON_MARGIN) * (region.height - 2 * MCS_PRIV_POISSON_MARGIN);
+}
+
+MCS_DEF size_t mcs_poisson_disk_2d_work_size( float min_x, float min_y, float max_x, float max_y, float radius ) {
+    mcs_priv_poisson_region_t region;
+    mcs_priv_poisson_region(min_x, min_y, max_x, max_y, radius, &region);
+    return (size_t)region.width * region.height * sizeof(mcs_priv_poisson_cell_t);
+}
+
+MCS_DEF MCHR_UINT mcs_poisson_disk_2d( float min_x, float min_y, float max_x, float max_y, float radius, MCHR_UINT seed, void* work,
+                                       float* out_x, float* out_y, MCHR_UINT capacity ) {
+    assert(work);
+    assert(capacity == 0 || (out_x && out_y));
+    mcs_priv_poisson_region_t region;
+    mcs_priv_poisson_region(min_x, min_y, max_x, max_y, radius, &region);
+    mcs_priv_poisson_cell_t* cells = (mcs_priv_poisson_cell_t*)work;
+    const MCHR_UINT width = region.width, height = region.height;
+    const float size = region.cell_size;
+    const float radius2 = radius * radius;
+    const MCHR_UINT seed_y = mchr_get_1d_hash_uint(-1, seed);
+    const MCHR_UINT seed_priority = mchr_get_1d_hash_uint(-2, seed);
+
+    for (MCHR_UINT i = 0; i < width * height; ++i) {
+        cells[i].round = 0;
+    }
+
+    for (MCHR_UINT round = 0; round < MCS_POISSON_ROUNDS; ++round) {
+        // candidates of the empty cells
+        MCHR_UINT inset = 2 * round;
+        for (MCHR_UINT cy = inset; cy < height - inset; ++cy) {
+            MCHR_INT y = region.first_y + (MCHR_INT)cy;
+            for (MCHR_UINT cx = inset; cx < width - inset; ++cx) {
+                mcs_priv_poisson_cell_t* cell = &cells[cy * width + cx];
+                if (cell->round != 0)
+                    continue;
+                MCHR_INT x = region.first_x + (MCHR_INT)cx;
+                MCHR_UINT hash_x = mchr_get_3d_hash_uint(x, y, (MCHR_INT)round, seed);
+                MCHR_UINT hash_y = mchr_get_3d_hash_uint(x, y, (MCHR_INT)round, seed_y);
+                cell->candidate_x = ((float)x + (float)(hash_x >> 8) * (1.0f / 16777216.0f)) * size;
+                cell->candidate_y = ((float)y + (float)(hash_y >> 8) * (1.0f / 16777216.0f)) * size;
+                cell->priority = mchr_get_3d_hash_uint(x, y, (MCHR_INT)round, seed_priority);
+            }
+        }
+
+        // accepted candidates; cells filled in this round still count as empty for the
+        //  candidates that come after them
+        inset += 2;
+        const MCHR_UINT filled_now = round + 1;
+        for (MCHR_UINT cy = inset; cy < height - inset; ++cy) {
+            for (MCHR_UINT cx = inset; cx < width - inset; ++cx) {
+                const MCHR_UINT index = cy * width + cx;
+                mcs_priv_poisson_cell_t* cell = &cells[index];
+                if (cell->round != 0)
+                    continue;
+                int accepted = 1;
+                for (MCHR_UINT ny = cy - 2; accepted && ny <= cy + 2; ++ny) {
+                    for (MCHR_UINT nx = cx - 2; nx <= cx + 2; ++nx) {
+                        const MCHR_UINT other_index = ny * width + nx;
+                        const mcs_priv_poisson_cell_t* other = &cells[other_index];
+                        if (other_index == index)
+                            continue;
+                        if (other->round != 0 && other->round != filled_now) {
+                            float dx = other->x - cell->candidate_x, dy = other->y - cell->candidate_y;
+                            if (dx * dx + dy * dy < radius2) {
+                                accepted = 0;
+                                break;
+                            }
+                        } else if (other->priority > cell->priority || (other->priority == cell->priority && other_index > index)) {
+                            float dx = other->candidate_x - cell->candidate_x, dy = other->candidate_y - cell->candidate_y;
+                            if (dx * dx + dy * dy < radius2) {
+                                accepted = 0;
+                                break;
+                            }
+                        }
+                    }
+                }
+                if (accepted) {
+                    cell->x = cell->candidate_x;
+                    cell->y = cell->candidate_y;
+                    cell->round = filled_now;
+                }
+            }
+        }
+    }
+
+    MCHR_UINT count = 0;
+    for (MCHR_UINT cy = MCS_PRIV_POISSON_MARGIN; cy < height - MCS_PRIV_POISSON_MARGIN; ++cy) {
+        for (MCHR_UINT cx = MCS_PRIV_POISSON_MARGIN; cx < width - MCS_PRIV_POISSON_MARGIN; ++cx) {
+            const mcs_priv_poisson_cell_t* cell = &cells[cy * width + cx];
+            if (cell->round == 0 || cell->x < min_x || cell->x >= max_x || cell->y < min_y || cell->y >= max_y)
+                continue;
+            if (count < capacity) {
+                out_x[count] = cell->x;
+                out_y[count] = cell->y;
+            }
+            ++count;
+        }
+    }
+    return count;
+}
+
+// ---------------------------------------------------------------------------------------
+// Stratified patterns. Points are generated in chunks, so the jitter hashes of a chunk are
+//  computed by the batch hash functions. Multi-jittered patterns shuffle the substrata
+//  with Kensler's hashed permutation, that maps [0, length) to itself in O(1) without
+//  storing the permutation.
+// ---------------------------------------------------------------------------------------
+#define MCS_PRIV_CHUNK 64
+
+static MCHR_UINT mcs_priv_permute(MCHR_UINT i, MCHR_UINT length, MCHR_UINT p) {
+    MCHR_UINT w = length - 1;
+    w |= w >> 1;
+    w |= w >> 2;
+    w |= w >> 4;
+    w |= w >> 8;
+    w |= w >> 16;
+    // the hash is a bijection of [0, w], so walking its cycle ends inside [0, length)
+    do {
+        i ^= p;
+        i *= 0xe170893du;
+        i ^= p >> 16;
+        i ^= (i & w) >> 4;
+        i ^= p >> 8;
+        i *= 0x0929eb3fu;
+        i ^= p >> 23;
+        i ^= (i & w) >> 1;
+        i *= 1 | p >> 27;
+        i *= 0x6935fa69u;
+        i ^= (i & w) >> 11;
+        i *= 0x74dcb303u;
+        i ^= (i & w) >> 2;
+        i *= 0x9e501cc3u;
+        i ^= (i & w) >> 2;
+        i *= 0xc860a3dfu;
+        i &= w;
+        i ^= i >> 5;
+    } while (i >= length);
+    return (i + p) % length;
+}
+
+static void mcs_priv_cell_pattern(mcs_pattern_t pattern, MCHR_UINT count, MCHR_UINT cell_hash, float* out_u, float* out_v) {
+    if (count == 0)
+        return;
+    MCHR_UINT columns = (MCHR_UINT)sqrt((double)count);
+    while (columns * columns > count)
+        --columns;
+    while ((columns + 1) * (columns + 1) <= count)
+        ++columns;
+    const MCHR_UINT rows = (count + columns - 1) / columns;
+    const float inv_columns = 1.0f / (float)columns, inv_rows = 1.0f / (float)rows;
+    const float below_one = 0.99999994f;
+    const MCHR_UINT seed_columns = mchr_get_1d_hash_uint(-1, cell_hash);
+    const MCHR_UINT seed_rows = mchr_get_1d_hash_uint(-2, cell_hash);
+    MCHR_INT pos[MCS_PRIV_CHUNK];
+    MCHR_UINT jitter[MCS_PRIV_CHUNK];
+    MCHR_UINT i = 0, j = 0;
+    MCHR_UINT row_seed = mchr_get_1d_hash_uint(0, seed_rows);
+    MCHR_UINT row_sub_v = pattern == MCS_PATTERN_CORRELATED_MULTI_JITTERED ? mcs_priv_permute(0, rows, seed_columns) : 0;
+
+    for (MCHR_UINT first = 0; first < count; first += MCS_PRIV_CHUNK) {
+        const MCHR_UINT n = count - first < MCS_PRIV_CHUNK ? count - first : MCS_PRIV_CHUNK;
+        if (pattern != MCS_PATTERN_STRATIFIED) {
+            for (MCHR_UINT k = 0; k < n; ++k) {
+                pos[k] = (MCHR_INT)(first + k);
+            }
+            mchr_get_1d_hash_uint_batch(pos, n, cell_hash, jitter);
+        }
+
+        for (MCHR_UINT k = 0; k < n; ++k) {
+            float u, v;
+            if (pattern == MCS_PATTERN_STRATIFIED) {
+                u = ((float)i + 0.5f) * inv_columns;
+                v = ((float)j + 0.5f) * inv_rows;
+            } else {
+                const float jitter_u = (float)(jitter[k] & 0xffff) * (1.0f / 65536.0f);
+                const float jitter_v = (float)(jitter[k] >> 16) * (1.0f / 65536.0f);
+                if (pattern == MCS_PATTERN_JITTERED) {
+                    u = ((float)i + jitter_u) * inv_columns;
+                    v = ((float)j + jitter_v) * inv_rows;
+                } else {
+                    // the column of substrata of the point in its row, and its row of
+                    //  substrata in its column
+                    MCHR_UINT sub_u, sub_v;
+                    if (pattern == MCS_PATTERN_MULTI_JITTERED) {
+                        sub_u = mcs_priv_permute(i, columns, row_seed);
+                        sub_v = mcs_priv_permute(j, rows, mchr_get_1d_hash_uint((MCHR_INT)i, seed_columns));
+                    } else {
+                        assert(pattern == MCS_PATTERN_CORRELATED_MULTI_JITTERED);
+                        sub_u = mcs_priv_permute(i, columns, seed_rows);
+                        sub_v = row_sub_v;
+                    }
+                    u = ((float)i + ((float)sub_v + jitter_u) * inv_rows) * inv_columns;
+                    v = ((float)j + ((float)sub_u + jitter_v) * inv_columns) * inv_rows;
+                }
+            }
+            out_u[first + k] = u < below_one ? u : below_one;
+            out_v[first + k] = v < below_one ? v : below_one;
+            if (++i == columns) {
+                i = 0;
+                ++j;
+                if (pattern == MCS_PATTERN_MULTI_JITTERED)
+                    row_seed = mchr_get_1d_hash_uint((MCHR_INT)j, seed_rows);
+                else if (pattern == MCS_PATTERN_CORRELATED_MULTI_JITTERED && j < rows)
+                    row_sub_v = mcs_priv_permute(j, rows, seed_columns);
+            }
+        }
+    }
+}
+
+MCS_DEF void mcs_cell_pattern_2d( mcs_pattern_t pattern, MCHR_UINT count, MCHR_INT cell_x, MCHR_INT cell_y, MCHR_UINT seed,
+                                  float* out_x, float* out_y ) {
+    assert(count == 0 || (out_x && out_y));
+    mcs_priv_cell_pattern(pattern, count, mchr_get_2d_hash_uint(cell_x, cell_y, seed), out_x, out_y);
+}
+
+MCS_DEF void mcs_cell_pattern_2d_tile( mcs_pattern_t pattern, MCHR_UINT count, MCHR_INT first_cell_x, MCHR_INT first_cell_y,
+                                       MCHR_UINT cells_x, MCHR_UINT cells_y, float cell_size, MCHR_UINT seed,
+                                       float* out_x, float* out_y ) {
+    assert(count == 0 || cells_x == 0 || cells_y == 0 || (out_x && out_y));
+    MCHR_INT row_x[MCS_PRIV_CHUNK], row_y[MCS_PRIV_CHUNK];
+    MCHR_UINT cell_hash[MCS_PRIV_CHUNK];
+    for (MCHR_UINT cy = 0; cy < cells_y; ++cy) {
+        const MCHR_INT y = (MCHR_INT)((MCHR_UINT)first_cell_y + cy);
+        for (MCHR_UINT first = 0; first < cells_x; first += MCS_PRIV_CHUNK) {
+            const MCHR_UINT n = cells_x - first < MCS_PRIV_CHUNK ? cells_x - first : MCS_PRIV_CHUNK;
+            for (MCHR_UINT k = 0; k < n; ++k) {
+                row_x[k] = (MCHR_INT)((MCHR_UINT)first_cell_x + first + k);
+                row_y[k] = y;
+            }
+            mchr_get_2d_hash_uint_batch(row_x, row_y, n, seed, cell_hash);
+            for (MCHR_UINT k = 0; k < n; ++k) {
+                float* cell_out_x = out_x + ((size_t)cy * cells_x + first + k) * count;
+                float* cell_out_y = out_y + ((size_t)cy * cells_x + first + k) * count;
+                mcs_priv_cell_pattern(pattern, count, cell_hash[k], cell_out_x, cell_out_y);
+                const float x0 = (float)row_x[k], y0 = (float)y;
+                for (MCHR_UINT s = 0; s < count; ++s) {
+                    cell_out_x[s] = (x0 + cell_out_x[s]) * cell_size;
+                    cell_out_y[s] = (y0 + cell_out_y[s]) * cell_size;
+                }
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Low-discrepancy sequences. Values are computed as 32 bit fractions, and only converted
+//  to float at the end, keeping their top 24 bits.
+// ---------------------------------------------------------------------------------------
+static const MCHR_UINT mcs_priv_sobol_directions[4][32] = {
+    { 0x80000000u, 0x40000000u, 0x20000000u, 0x10000000u, 0x08000000u, 0x04000000u, 0x02000000u, 0x01000000u,
+      0x00800000u, 0x00400000u, 0x00200000u, 0x00100000u, 0x00080000u, 0x00040000u, 0x00020000u, 0x00010000u,
+      0x00008000u, 0x00004000u, 0x00002000u, 0x00001000u, 0x00000800u, 0x00000400u, 0x00000200u, 0x00000100u,
+      0x00000080u, 0x00000040u, 0x00000020u, 0x00000010u, 0x00000008u, 0x00000004u, 0x00000002u, 0x00000001u },
+    { 0x80000000u, 0xc0000000u, 0xa0000000u, 0xf0000000u, 0x88000000u, 0xcc000000u, 0xaa000000u, 0xff000000u,
+      0x80800000u, 0xc0c00000u, 0xa0a00000u, 0xf0f00000u, 0x88880000u, 0xcccc0000u, 0xaaaa0000u, 0xffff0000u,
+      0x80008000u, 0xc000c000u, 0xa000a000u, 0xf000f000u, 0x88008800u, 0xcc00cc00u, 0xaa00aa00u, 0xff00ff00u,
+      0x80808080u, 0xc0c0c0c0u, 0xa0a0a0a0u, 0xf0f0f0f0u, 0x88888888u, 0xccccccccu, 0xaaaaaaaau, 0xffffffffu },
+    { 0x80000000u, 0xc0000000u, 0x60000000u, 0x90000000u, 0xe8000000u, 0x5c000000u, 0x8e000000u, 0xc5000000u,
+      0x68800000u, 0x9cc00000u, 0xee600000u, 0x55900000u, 0x80680000u, 0xc09c0000u, 0x60ee0000u, 0x90550000u,
+      0xe8808000u, 0x5cc0c000u, 0x8e606000u, 0xc5909000u, 0x6868e800u, 0x9c9c5c00u, 0xeeee8e00u, 0x5555c500u,
+      0x8000e880u, 0xc0005cc0u, 0x60008e60u, 0x9000c590u, 0xe8006868u, 0x5c009c9cu, 0x8e00eeeeu, 0xc5005555u },
+    { 0x80000000u, 0xc0000000u, 0x20000000u, 0x50000000u, 0xf8000000u, 0x74000000u, 0xa2000000u, 0x93000000u,
+      0xd8800000u, 0x25400000u, 0x59e00000u, 0xe6d00000u, 0x78080000u, 0xb40c0000u, 0x82020000u, 0xc3050000u,
+      0x208f8000u, 0x51474000u, 0xfbea2000u, 0x75d93000u, 0xa0858800u, 0x914e5400u, 0xdbe79e00u, 0x25db6d00u,
+      0x58800080u, 0xe54000c0u, 0x79e00020u, 0xb6d00050u, 0x800800f8u, 0xc00c0074u, 0x200200a2u, 0x50050093u }
+};
+
+static const MCHR_UINT mcs_priv_halton_primes[MCS_HALTON_MAX_DIMENSIONS] = {
+    2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53,
+    59, 61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131
+};
+
+static float mcs_priv_fraction_to_float(MCHR_UINT fraction) {
+    return (float)(fraction >> 8) * (1.0f / 16777216.0f);
+}
+
+static MCHR_UINT mcs_priv_reverse_bits(MCHR_UINT x) {
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+    x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+// Owen scrambling of a 32 bit fraction: a hash of the reversed bits in which every bit only
+//  depends on the bits below it (Laine-Karras style, with Vegdahl's constants)
+static MCHR_UINT mcs_priv_nested_uniform_scramble(MCHR_UINT x, MCHR_UINT seed) {
+    x = mcs_priv_reverse_bits(x);
+    x ^= x * 0x3d20adeau;
+    x += seed;
+    x *= (seed >> 16) | 1;
+    x ^= x * 0x05526c56u;
+    x ^= x * 0x53a22864u;
+    return mcs_priv_reverse_bits(x);
+}
+
+static MCHR_UINT mcs_priv_sobol(MCHR_UINT index, const MCHR_UINT* directions) {
+    MCHR_UINT result = 0;
+    for (MCHR_UINT bit = 0; bit < 32; ++bit) {
+        result ^= directions[bit] & (0u - ((index >> bit) & 1));
+    }
+    return result;
+}
+
+// the index shuffle is shared by the dimensions of a group of 4, so each group keeps the
+//  stratification of the first 4 Sobol dimensions
+static void mcs_priv_sobol_seeds(MCHR_UINT dimension, MCHR_UINT seed, MCHR_UINT* out_index_seed, MCHR_UINT* out_scramble_seed) {
+    *out_index_seed = mchr_get_1d_hash_uint((MCHR_INT)(dimension / 4), seed);
+    *out_scramble_seed = mchr_get_1d_hash_uint((MCHR_INT)dimension, mchr_get_1d_hash_uint(-1, seed));
+}
+
+MCS_DEF float mcs_sobol( MCHR_UINT index, MCHR_UINT dimension, MCHR_UINT seed ) {
+    MCHR_UINT index_seed, scramble_seed;
+    mcs_priv_sobol_seeds(dimension, seed, &index_seed, &scramble_seed);
+    MCHR_UINT shuffled = mcs_priv_nested_uniform_scramble(index, index_seed);
+    MCHR_UINT value = mcs_priv_sobol(shuffled, mcs_priv_sobol_directions[dimension % 4]);
+    return mcs_priv_fraction_to_float(mcs_priv_nested_uniform_scramble(value, scramble_seed));
+}
+
+MCS_DEF void mcs_sobol_batch( MCHR_UINT first_index, MCHR_UINT count, MCHR_UINT dimension, MCHR_UINT seed, float* out ) {
+    assert(count == 0 || out);
+    MCHR_UINT index_seed, scramble_seed;
+    mcs_priv_sobol_seeds(dimension, seed, &index_seed, &scramble_seed);
+    const MCHR_UINT* directions = mcs_priv_sobol_directions[dimension % 4];
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        MCHR_UINT shuffled = mcs_priv_nested_uniform_scramble(first_index + i, index_seed);
+        MCHR_UINT value = mcs_priv_sobol(shuffled, directions);
+        out[i] = mcs_priv_fraction_to_float(mcs_priv_nested_uniform_scramble(value, scramble_seed));
+    }
+}
+
+// radical inverse in base 3 or more, permuting every digit with a hash of the preceding
+//  ones; digits are added until they are below the precision of the result (base 2 is the
+//  Sobol first dimension, scrambled in the same way)
+static float mcs_priv_halton(MCHR_UINT index, MCHR_UINT base, MCHR_UINT seed) {
+    const double inv_base = 1.0 / (double)base;
+    double scale = inv_base, value = 0.0;
+    MCHR_UINT hash = seed;
+    while (scale >= 1.0 / 33554432.0) {
+        MCHR_UINT digit = index % base;
+        index /= base;
+        value += (double)mcs_priv_permute(digit, base, hash) * scale;
+        hash = mchr_get_1d_hash_uint((MCHR_INT)digit, hash);
+        scale *= inv_base;
+    }
+    const float result = (float)value;
+    return result < 0.99999994f ? result : 0.99999994f;
+}
+
+MCS_DEF float mcs_halton( MCHR_UINT index, MCHR_UINT dimension, MCHR_UINT seed ) {
+    assert(dimension < MCS_HALTON_MAX_DIMENSIONS);
+    MCHR_UINT dimension_seed = mchr_get_1d_hash_uint((MCHR_INT)dimension, seed);
+    if (dimension == 0)
+        return mcs_priv_fraction_to_float(mcs_priv_nested_uniform_scramble(mcs_priv_reverse_bits(index), dimension_seed));
+    return mcs_priv_halton(index, mcs_priv_halton_primes[dimension], dimension_seed);
+}
+
+MCS_DEF void mcs_halton_batch( MCHR_UINT first_index, MCHR_UINT count, MCHR_UINT dimension, MCHR_UINT seed, float* out ) {
+    assert(dimension < MCS_HALTON_MAX_DIMENSIONS);
+    assert(count == 0 || out);
+    MCHR_UINT dimension_seed = mchr_get_1d_hash_uint((MCHR_INT)dimension, seed);
+    if (dimension == 0) {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            out[i] = mcs_priv_fraction_to_float(mcs_priv_nested_uniform_scramble(mcs_priv_reverse_bits(first_index + i), dimension_seed));
+        }
+    } else {
+        const MCHR_UINT base = mcs_priv_halton_primes[dimension];
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            out[i] = mcs_priv_halton(first_index + i, base, dimension_seed);
+        }
+    }
+}
+
+// R2 steps are 1/g and 1/g^2 (g being the plastic number), as 32 bit fractions, so a point
+//  is exact modulo 1 at any index
+#define MCS_PRIV_R2_STEP_X 0xc13fa9a9u
+#define MCS_PRIV_R2_STEP_Y 0x91e10da6u
+
+MCS_DEF void mcs_r2( MCHR_UINT index, MCHR_UINT seed, float* out_x, float* out_y ) {
+    assert(out_x && out_y);
+    mcs_r2_batch(index, 1, seed, out_x, out_y);
+}
+
+MCS_DEF void mcs_r2_batch( MCHR_UINT first_index, MCHR_UINT count, MCHR_UINT seed, float* out_x, float* out_y ) {
+    assert(count == 0 || (out_x && out_y));
+    const MCHR_UINT offset_x = mchr_get_1d_hash_uint(0, seed), offset_y = mchr_get_1d_hash_uint(1, seed);
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        const MCHR_UINT index = first_index + i;
+        out_x[i] = mcs_priv_fraction_to_float(offset_x + index * MCS_PRIV_R2_STEP_X);
+        out_y[i] = mcs_priv_fraction_to_float(offset_y + index * MCS_PRIV_R2_STEP_Y);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Blue-noise masks. Energies are sums of integer kernel weights, so adding and removing
+//  points is exact, and the result doesn't depend on float rounding. The kernel is
+//  (1 - d^2 / 18)^4, close to the gaussian of sigma 1.5 of Ulichney, with 4 pixels of
+//  support. Spatio-temporal masks only add the energy of the pixels in the same slice and
+//  of the same pixel in other slices, like Wolfe et al. The best void and cluster of every
+//  row are kept, so a step only rescans the rows its kernel touches.
+// ---------------------------------------------------------------------------------------
+#define MCS_PRIV_BLUE_NOISE_RADIUS 4
+#define MCS_PRIV_BLUE_NOISE_NONE 0xffffffffu
+
+typedef struct mcs_priv_blue_noise_t {
+    MCHR_UINT width, height, depth;
+    MCHR_UINT* energy;
+    MCHR_UINT* priority;            // hashed, breaks ties between equal energies
+    MCHR_UINT* row_void;            // pixel with the lowest energy among the empty ones
+    MCHR_UINT* row_cluster;         // pixel with the highest energy among the full ones
+    unsigned char* full;
+    unsigned char* prototype;
+    MCHR_UINT weights[MCS_PRIV_BLUE_NOISE_RADIUS + 1][MCS_PRIV_BLUE_NOISE_RADIUS + 1];
+} mcs_priv_blue_noise_t;
+
+MCS_DEF size_t mcs_blue_noise_work_size( MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth ) {
+    const size_t pixels = (size_t)width * height * depth, rows = (size_t)height * depth;
+    return pixels * 2 * sizeof(MCHR_UINT) + rows * 2 * sizeof(MCHR_UINT) + pixels * 2;
+}
+
+static void mcs_priv_blue_noise_scan_row(mcs_priv_blue_noise_t* mask, MCHR_UINT row) {
+    const MCHR_UINT first = row * mask->width;
+    MCHR_UINT best_void = MCS_PRIV_BLUE_NOISE_NONE, best_cluster = MCS_PRIV_BLUE_NOISE_NONE;
+    for (MCHR_UINT p = first; p < first + mask->width; ++p) {
+        const MCHR_UINT energy = mask->energy[p];
+        if (mask->full[p]) {
+            if (best_cluster == MCS_PRIV_BLUE_NOISE_NONE || energy > mask->energy[best_cluster] ||
+                (energy == mask->energy[best_cluster] && mask->priority[p] < mask->priority[best_cluster]))
+                best_cluster = p;
+        } else {
+            if (best_void == MCS_PRIV_BLUE_NOISE_NONE || energy < mask->energy[best_void] ||
+                (energy == mask->energy[best_void] && mask->priority[p] < mask->priority[best_void]))
+                best_void = p;
+        }
+    }
+    mask->row_void[row] = best_void;
+    mask->row_cluster[row] = best_cluster;
+}
+
+static MCHR_UINT mcs_priv_blue_noise_find(const mcs_priv_blue_noise_t* mask, int find_cluster) {
+    const MCHR_UINT* row_best = find_cluster ? mask->row_cluster : mask->row_void;
+    MCHR_UINT best = MCS_PRIV_BLUE_NOISE_NONE;
+    for (MCHR_UINT row = 0; row < mask->height * mask->depth; ++row) {
+        const MCHR_UINT p = row_best[row];
+        if (p == MCS_PRIV_BLUE_NOISE_NONE)
+            continue;
+        if (best == MCS_PRIV_BLUE_NOISE_NONE || (find_cluster ? mask->energy[p] > mask->energy[best] : mask->energy[p] < mask->energy[best]) ||
+            (mask->energy[p] == mask->energy[best] && mask->priority[p] < mask->priority[best]))
+            best = p;
+    }
+    return best;
+}
+
+// fills or empties a pixel, updating the energies around it and the rows they are in
+static void mcs_priv_blue_noise_set(mcs_priv_blue_noise_t* mask, MCHR_UINT p, int full, int rescan) {
+    const MCHR_UINT width = mask->width, height = mask->height, depth = mask->depth;
+    const MCHR_UINT x = p % width, y = (p / width) % height, t = p / (width * height);
+    const MCHR_INT radius = MCS_PRIV_BLUE_NOISE_RADIUS;
+    mask->full[p] = (unsigned char)full;
+    for (MCHR_INT dy = -radius; dy <= radius; ++dy) {
+        const MCHR_UINT ny = (MCHR_UINT)((MCHR_INT)y + dy + (MCHR_INT)height * radius) % height;
+        const MCHR_UINT row = t * height + ny;
+        for (MCHR_INT dx = -radius; dx <= radius; ++dx) {
+            const MCHR_UINT weight = mask->weights[dy < 0 ? -dy : dy][dx < 0 ? -dx : dx];
+            const MCHR_UINT nx = (MCHR_UINT)((MCHR_INT)x + dx + (MCHR_INT)width * radius) % width;
+            if (full)
+                mask->energy[row * width + nx] += weight;
+            else
+                mask->energy[row * width + nx] -= weight;
+        }
+    }
+    if (depth > 1) {
+        for (MCHR_INT dt = -radius; dt <= radius; ++dt) {
+            if (dt == 0)
+                continue;
+            const MCHR_UINT weight = mask->weights[dt < 0 ? -dt : dt][0];
+            const MCHR_UINT nt = (MCHR_UINT)((MCHR_INT)t + dt + (MCHR_INT)depth * radius) % depth;
+            if (full)
+                mask->energy[(nt * height + y) * width + x] += weight;
+            else
+                mask->energy[(nt * height + y) * width + x] -= weight;
+        }
+    }
+    if (!rescan)
+        return;
+    // rows are rescanned once, even if the kernel wraps around a small mask
+    const MCHR_UINT rows_y = height < 2 * MCS_PRIV_BLUE_NOISE_RADIUS + 1 ? height : 2 * MCS_PRIV_BLUE_NOISE_RADIUS + 1;
+    for (MCHR_UINT i = 0; i < rows_y; ++i) {
+        mcs_priv_blue_noise_scan_row(mask, t * height + (y + height * radius - (MCHR_UINT)radius + i) % height);
+    }
+    if (depth > 1) {
+        const MCHR_UINT rows_t = depth < 2 * MCS_PRIV_BLUE_NOISE_RADIUS + 1 ? depth : 2 * MCS_PRIV_BLUE_NOISE_RADIUS + 1;
+        for (MCHR_UINT i = 0; i < rows_t; ++i) {
+            const MCHR_UINT nt = (t + depth * radius - (MCHR_UINT)radius + i) % depth;
+            if (nt != t)
+                mcs_priv_blue_noise_scan_row(mask, nt * height + y);
+        }
+    }
+}
+
+static void mcs_priv_blue_noise_load(mcs_priv_blue_noise_t* mask, const unsigned char* pattern) {
+    const MCHR_UINT pixels = mask->width * mask->height * mask->depth;
+    for (MCHR_UINT p = 0; p < pixels; ++p) {
+        mask->energy[p] = 0;
+        mask->full[p] = 0;
+    }
+    for (MCHR_UINT p = 0; p < pixels; ++p) {
+        if (pattern[p])
+            mcs_priv_blue_noise_set(mask, p, 1, 0);
+    }
+    for (MCHR_UINT row = 0; row < mask->height * mask->depth; ++row) {
+        mcs_priv_blue_noise_scan_row(mask, row);
+    }
+}
+
+MCS_DEF void mcs_blue_noise_generate( MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT seed, void* work,
+                                      unsigned short* out_values ) {
+    assert(width > 0 && height > 0 && depth > 0);
+    assert(work && out_values);
+    const MCHR_UINT pixels = width * height * depth, rows = height * depth;
+    mcs_priv_blue_noise_t mask;
+    mask.width = width;
+    mask.height = height;
+    mask.depth = depth;
+    mask.energy = (MCHR_UINT*)work;
+    mask.priority = mask.energy + pixels;
+    mask.row_void = mask.priority + pixels;
+    mask.row_cluster = mask.row_void + rows;
+    mask.full = (unsigned char*)(mask.row_cluster + rows);
+    mask.prototype = mask.full + pixels;
+    for (MCHR_UINT dy = 0; dy <= MCS_PRIV_BLUE_NOISE_RADIUS; ++dy) {
+        for (MCHR_UINT dx = 0; dx <= MCS_PRIV_BLUE_NOISE_RADIUS; ++dx) {
+            const double falloff = 1.0 - (double)(dx * dx + dy * dy) / 18.0;
+            mask.weights[dy][dx] = falloff > 0.0 ? (MCHR_UINT)(falloff * falloff * falloff * falloff * 65536.0 + 0.5) : 0;
+        }
+    }
+
+    // initial pattern: a tenth of the pixels, at hashed positions
+    const MCHR_UINT initial = pixels / 10;
+    for (MCHR_UINT p = 0; p < pixels; ++p) {
+        mask.priority[p] = mchr_get_1d_hash_uint((MCHR_INT)p, seed);
+        mask.prototype[p] = 0;
+    }
+    const MCHR_UINT seed_initial = mchr_get_1d_hash_uint(-1, seed);
+    for (MCHR_UINT placed = 0, i = 0; placed < initial; ++i) {
+        const MCHR_UINT p = mchr_get_1d_hash_uint((MCHR_INT)i, seed_initial) % pixels;
+        if (!mask.prototype[p]) {
+            mask.prototype[p] = 1;
+            ++placed;
+        }
+    }
+    mcs_priv_blue_noise_load(&mask, mask.prototype);
+
+    // moves the tightest cluster to the largest void until they are the same pixel
+    if (initial > 0) {
+        for (MCHR_UINT i = 0; i < pixels; ++i) {
+            const MCHR_UINT cluster = mcs_priv_blue_noise_find(&mask, 1);
+            mcs_priv_blue_noise_set(&mask, cluster, 0, 1);
+            const MCHR_UINT largest_void = mcs_priv_blue_noise_find(&mask, 0);
+            mcs_priv_blue_noise_set(&mask, largest_void, 1, 1);
+            if (largest_void == cluster)
+                break;
+        }
+    }
+    for (MCHR_UINT p = 0; p < pixels; ++p) {
+        mask.prototype[p] = mask.full[p];
+    }
+
+    // ranks of the initial pixels, removing the tightest clusters first, and then of the
+    //  rest, filling the largest voids first
+    for (MCHR_UINT rank = initial; rank-- > 0;) {
+        const MCHR_UINT cluster = mcs_priv_blue_noise_find(&mask, 1);
+        mcs_priv_blue_noise_set(&mask, cluster, 0, 1);
+        out_values[cluster] = (unsigned short)((double)rank * 65536.0 / (double)pixels);
+    }
+    mcs_priv_blue_noise_load(&mask, mask.prototype);
+    for (MCHR_UINT rank = initial; rank < pixels; ++rank) {
+        const MCHR_UINT largest_void = mcs_priv_blue_noise_find(&mask, 0);
+        mcs_priv_blue_noise_set(&mask, largest_void, 1, 1);
+        out_values[largest_void] = (unsigned short)((double)rank * 65536.0 / (double)pixels);
+    }
+}
+
+MCS_DEF float mcs_blue_noise_sample( const unsigned short* values, MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth,
+                                     MCHR_INT x, MCHR_INT y, MCHR_INT t ) {
+    assert(values);
+    assert(width > 0 && height > 0 && depth > 0);
+    MCHR_INT wx = x % (MCHR_INT)width, wy = y % (MCHR_INT)height, wt = t % (MCHR_INT)depth;
+    wx += wx < 0 ? (MCHR_INT)width : 0;
+    wy += wy < 0 ? (MCHR_INT)height : 0;
+    wt += wt < 0 ? (MCHR_INT)depth : 0;
+    return (float)values[((MCHR_UINT)wt * height + (MCHR_UINT)wy) * width + (MCHR_UINT)wx] * (1.0f / 65536.0f);
+}
+
+// cache header: magic, version, width, height, depth, seed, hash of the values, unused
+#define MCS_PRIV_BLUE_NOISE_MAGIC 0x4e42434du     // "MCBN" in little-endian
+#define MCS_PRIV_BLUE_NOISE_VERSION 1
+#define MCS_PRIV_BLUE_NOISE_HEADER 8
+
+MCS_DEF size_t mcs_blue_noise_cache_size( MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth ) {
+    return MCS_PRIV_BLUE_NOISE_HEADER * sizeof(MCHR_UINT) + (size_t)width * height * depth * sizeof(unsigned short);
+}
+
+MCS_DEF unsigned short* mcs_blue_noise_cache_values( void* cache ) {
+    assert(cache);
+    return (unsigned short*)((MCHR_UINT*)cache + MCS_PRIV_BLUE_NOISE_HEADER);
+}
+
+MCS_DEF void mcs_blue_noise_write_cache( void* cache, MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth, MCHR_UINT seed ) {
+    assert(cache);
+    MCHR_UINT* header = (MCHR_UINT*)cache;
+    const size_t values_size = (size_t)width * height * depth * sizeof(unsigned short);
+    header[0] = MCS_PRIV_BLUE_NOISE_MAGIC;
+    header[1] = MCS_PRIV_BLUE_NOISE_VERSION;
+    header[2] = width;
+    header[3] = height;
+    header[4] = depth;
+    header[5] = seed;
+    header[6] = mchr_get_hash_uint(header + MCS_PRIV_BLUE_NOISE_HEADER, values_size, seed);
+    header[7] = 0;
+}
+
+MCS_DEF bool mcs_blue_noise_read_cache( const void* cache, size_t size, MCHR_UINT width, MCHR_UINT height, MCHR_UINT depth,
+                                        MCHR_UINT seed, const unsigned short** out_values ) {
+    assert(out_values);
+    const MCHR_UINT* header = (const MCHR_UINT*)cache;
+    if (!cache || size != mcs_blue_noise_cache_size(width, height, depth))
+        return false;
+    if (header[0] != MCS_PRIV_BLUE_NOISE_MAGIC || header[1] != MCS_PRIV_BLUE_NOISE_VERSION || header[2] != width ||
+        header[3] != height || header[4] != depth || header[5] != seed)
+        return false;
+    const size_t values_size = size - MCS_PRIV_BLUE_NOISE_HEADER * sizeof(MCHR_UINT);
+    if (header[6] != mchr_get_hash_uint(header + MCS_PRIV_BLUE_NOISE_HEADER, values_size, seed))
+        return false;
+    *out_values = (const unsigned short*)(header + MCS_PRIV_BLUE_NOISE_HEADER);
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------
+// Wang and corner tiles. Horizontal edges (north and south) are hashed at the coordinates
+//  of the tile to their south, vertical edges (west and east) at the coordinates of the
+//  tile to their east, and vertices at the coordinates of the tile to their south east, each
+//  kind with its own seed. Maps are filled in columns of up to MCS_PRIV_CHUNK tiles, row
+//  by row, so the south edges (or vertices) of a row are the north ones of the next.
+// ---------------------------------------------------------------------------------------
+static void mcs_priv_tile_seeds(MCHR_UINT seed, MCHR_UINT* out_horizontal, MCHR_UINT* out_vertical) {
+    *out_horizontal = mchr_get_1d_hash_uint(-1, seed);
+    *out_vertical = mchr_get_1d_hash_uint(-2, seed);
+}
+
+// colours of `count` consecutive edges (or vertices) of a row, identical to calling
+//  mchr_get_2d_hash_uint_in_range(x, y, seed, 0, colors - 1) for each one: the hashes are
+//  computed in a batch, and their bit chunks are tried in the same way (the first ones
+//  without branches), falling back to the function itself in the rare case that they are
+//  all rejected
+static void mcs_priv_tile_colors(MCHR_INT first_x, MCHR_INT y, MCHR_UINT count, MCHR_UINT colors, MCHR_UINT seed, MCHR_UINT* out) {
+    MCHR_INT xs[MCS_PRIV_CHUNK + 1], ys[MCS_PRIV_CHUNK + 1];
+    MCHR_UINT hashes[MCS_PRIV_CHUNK + 1];
+    assert(count <= MCS_PRIV_CHUNK + 1);
+    if (colors < 2) {
+        for (MCHR_UINT i = 0; i < count; ++i) {
+            out[i] = 0;
+        }
+        return;
+    }
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        xs[i] = (MCHR_INT)((MCHR_UINT)first_x + i);
+        ys[i] = y;
+    }
+    mchr_get_2d_hash_uint_batch(xs, ys, count, seed, hashes);
+
+    MCHR_UINT bits = 0;
+    while ((colors >> bits) != 0) {
+        bits += 1;
+    }
+    const MCHR_UINT mask = (1u << bits) - 1;
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        // first accepted chunk of the first 3 (all hashes have at least 3 chunks of up to 9
+        //  bits), without branches
+        const MCHR_UINT first = hashes[i] & mask;
+        const MCHR_UINT second = (hashes[i] >> bits) & mask;
+        const MCHR_UINT third = (hashes[i] >> (2 * bits)) & mask;
+        out[i] = (first < colors) ? first : (second < colors) ? second : third;
+    }
+    for (MCHR_UINT i = 0; i < count; ++i) {
+        if (out[i] < colors)
+            continue;
+        MCHR_UINT value = hashes[i] >> (2 * bits);
+        MCHR_UINT bits_left = 32 - 3 * bits;
+        while (out[i] >= colors && bits_left >= bits) {
+            value >>= bits;
+            out[i] = value & mask;
+            bits_left -= bits;
+        }
+        if (out[i] >= colors)
+            out[i] = mchr_get_2d_hash_uint_in_range(xs[i], ys[i], seed, 0, colors - 1);
+    }
+}
+
+MCS_DEF MCHR_UINT mcs_wang_tile_2d( MCHR_INT x, MCHR_INT y, MCHR_UINT colors, MCHR_UINT seed ) {
+    assert(colors >= 1 && colors <= 256);
+    if (colors < 2)
+        return 0;
+    MCHR_UINT seed_horizontal, seed_vertical;
+    mcs_priv_tile_seeds(seed, &seed_horizontal, &seed_vertical);
+    const MCHR_INT east_x = (MCHR_INT)((MCHR_UINT)x + 1), south_y = (MCHR_INT)((MCHR_UINT)y + 1);
+    const MCHR_UINT north = mchr_get_2d_hash_uint_in_range(x, y, seed_horizontal, 0, colors - 1);
+    const MCHR_UINT east = mchr_get_2d_hash_uint_in_range(east_x, y, seed_vertical, 0, colors - 1);
+    const MCHR_UINT south = mchr_get_2d_hash_uint_in_range(x, south_y, seed_horizontal, 0, colors - 1);
+    const MCHR_UINT west = mchr_get_2d_hash_uint_in_range(x, y, seed_vertical, 0, colors - 1);
+    return ((north * colors + east) * colors + south) * colors + west;
+}
+
+MCS_DEF void mcs_wang_tile_2d_map( MCHR_INT first_x, MCHR_INT first_y, MCHR_UINT width, MCHR_UINT height, MCHR_UINT colors,
+                                   MCHR_UINT seed, MCHR_UINT* out ) {
+    assert(colors >= 1 && colors <= 256);
+    assert(out || width == 0 || height == 0);
+    MCHR_UINT seed_horizontal, seed_vertical;
+    mcs_priv_tile_seeds(seed, &seed_horizontal, &seed_vertical);
+    MCHR_UINT north[MCS_PRIV_CHUNK], south[MCS_PRIV_CHUNK], vertical[MCS_PRIV_CHUNK + 1];
+    for (MCHR_UINT column = 0; column < width; column += MCS_PRIV_CHUNK) {
+        const MCHR_UINT n = (width - column < MCS_PRIV_CHUNK) ? width - column : MCS_PRIV_CHUNK;
+        const MCHR_INT x = (MCHR_INT)((MCHR_UINT)first_x + column);
+        for (MCHR_UINT row = 0; row < height; ++row) {
+            const MCHR_INT y = (MCHR_INT)((MCHR_UINT)first_y + row);
+            if (row == 0) {
+                mcs_priv_tile_colors(x, y, n, colors, seed_horizontal, north);
+            } else {
+                memcpy(north, south, n * sizeof(MCHR_UINT));
+            }
+            mcs_priv_tile_colors(x, (MCHR_INT)((MCHR_UINT)y + 1), n, colors, seed_horizontal, south);
+            mcs_priv_tile_colors(x, y, n + 1, colors, seed_vertical, vertical);
+            MCHR_UINT* out_row = out + (size_t)row * width + column;
+            for (MCHR_UINT i = 0; i < n; ++i) {
+                out_row[i] = ((north[i] * colors + vertical[i + 1]) * colors + south[i]) * colors + vertical[i];
+            }
+        }
+    }
+}
+
+MCS_DEF MCHR_UINT mcs_corner_tile_2d( MCHR_INT x, MCHR_INT y, MCHR_UINT colors, MCHR_UINT seed ) {
+    assert(colors >= 1 && colors <= 256);
+    if (colors < 2)
+        return 0;
+    const MCHR_INT east_x = (MCHR_INT)((MCHR_UINT)x + 1), south_y = (MCHR_INT)((MCHR_UINT)y + 1);
+    const MCHR_UINT north_west = mchr_get_2d_hash_uint_in_range(x, y, seed, 0, colors - 1);
+    const MCHR_UINT north_east = mchr_get_2d_hash_uint_in_range(east_x, y, seed, 0, colors - 1);
+    const MCHR_UINT south_west = mchr_get_2d_hash_uint_in_range(x, south_y, seed, 0, colors - 1);
+    const MCHR_UINT south_east = mchr_get_2d_hash_uint_in_range(east_x, south_y, seed, 0, colors - 1);
+    return ((north_west * colors + north_east) * colors + south_west) * colors + south_east;
+}
+
+MCS_DEF void mcs_corner_tile_2d_map( MCHR_INT first_x, MCHR_INT first_y, MCHR_UINT width, MCHR_UINT height, MCHR_UINT colors,
+                                     MCHR_UINT seed, MCHR_UINT* out ) {
+    assert(colors >= 1 && colors <= 256);
+    assert(out || width == 0 || height == 0);
+    MCHR_UINT north[MCS_PRIV_CHUNK + 1], south[MCS_PRIV_CHUNK + 1];
+    for (MCHR_UINT column = 0; column < width; column += MCS_PRIV_CHUNK) {
+        const MCHR_UINT n = (width - column < MCS_PRIV_CHUNK) ? width - column : MCS_PRIV_CHUNK;
+        const MCHR_INT x = (MCHR_INT)((MCHR_UINT)first_x + column);
+        for (MCHR_UINT row = 0; row < height; ++row) {
+            const MCHR_INT y = (MCHR_INT)((MCHR_UINT)first_y + row);
+            if (row == 0) {
+                mcs_priv_tile_colors(x, y, n + 1, colors, seed, north);
+            } else {
+                memcpy(north, south, (n + 1) * sizeof(MCHR_UINT));
+            }
+            mcs_priv_tile_colors(x, (MCHR_INT)((MCHR_UINT)y + 1), n + 1, colors, seed, south);
+            MCHR_UINT* out_row = out + (size_t)row * width + column;
+            for (MCHR_UINT i = 0; i < n; ++i) {
+                out_row[i] = ((north[i] * colors + north[i + 1]) * colors + south[i]) * colors + south[i + 1];
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Mesh scattering. Triangles are picked with the alias method of Vose: a hash selects a
+//  column of the table, and a second one compares against its 32-bit threshold to keep
+//  the column's triangle or take its alias. The table is built in double precision, with
+//  the small and large columns stacked at both ends of a temporary array. Barycentric
+//  coordinates come from two more hashes, folding the points of the far half of the
+//  parallelogram back into the triangle.
+// The work buffer holds the temporary scaled areas, the thresholds and aliases, and the
+//  temporary stack.
+// ---------------------------------------------------------------------------------------
+static double mcs_priv_triangle_area(const float* positions, const MCHR_UINT* indices) {
+    const float* a = positions + 3 * (size_t)indices[0];
+    const float* b = positions + 3 * (size_t)indices[1];
+    const float* c = positions + 3 * (size_t)indices[2];
+    const double ab[3] = { (double)b[0] - a[0], (double)b[1] - a[1], (double)b[2] - a[2] };
+    const double ac[3] = { (double)c[0] - a[0], (double)c[1] - a[1], (double)c[2] - a[2] };
+    const double cross_x = ab[1] * ac[2] - ab[2] * ac[1];
+    const double cross_y = ab[2] * ac[0] - ab[0] * ac[2];
+    const double cross_z = ab[0] * ac[1] - ab[1] * ac[0];
+    return 0.5 * sqrt(cross_x * cross_x + cross_y * cross_y + cross_z * cross_z);
+}
+
+static MCHR_UINT mcs_priv_alias_threshold(double scaled) {
+    const double threshold = scaled * 4294967296.0;
+    return threshold < 4294967295.0 ? (MCHR_UINT)threshold : 0xffffffffu;
+}
+
+static void mcs_priv_mesh_seeds(MCHR_UINT seed, MCHR_UINT* out_seeds) {
+    for (MCHR_UINT i = 0; i < 4; ++i) {
+        out_seeds[i] = mchr_get_1d_hash_uint((MCHR_INT)i, seed);
+    }
+}
+
+static void mcs_priv_mesh_point(const mcs_mesh_sampler_t* sampler, MCHR_UINT hash_column, MCHR_UINT hash_alias, MCHR_UINT hash_u,
+                                MCHR_UINT hash_v, MCHR_UINT* out_triangle, float* out_u, float* out_v, float* out_x, float* out_y,
+                                float* out_z) {
+    // both choices are random, so they are made with masks instead of branches
+    const MCHR_UINT column = (MCHR_UINT)(((unsigned long long)hash_column * sampler->triangle_count) >> 32);
+    const MCHR_UINT keep = 0u - (MCHR_UINT)(hash_alias < sampler->thresholds[column]);
+    const MCHR_UINT triangle = (column & keep) | (sampler->aliases[column] & ~keep);
+
+    // 24-bit fixed point, folded if u + v > 1
+    const MCHR_UINT u0 = hash_u >> 8, v0 = hash_v >> 8;
+    const MCHR_UINT fold = 0u - ((u0 + v0) >> 24);
+    const float u = (float)((u0 & ~fold) | ((0x1000000u - u0) & fold)) * (1.0f / 16777216.0f);
+    const float v = (float)((v0 & ~fold) | ((0x1000000u - v0) & fold)) * (1.0f / 16777216.0f);
+
+    const MCHR_UINT* indices = sampler->indices + 3 * (size_t)triangle;
+    const float* a = sampler->positions + 3 * (size_t)indices[0];
+    const float* b = sampler->positions + 3 * (size_t)indices[1];
+    const float* c = sampler->positions + 3 * (size_t)indices[2];
+    *out_triangle = triangle;
+    *out_u = u;
+    *out_v = v;
+    *out_x = a[0] + u * (b[0] - a[0]) + v * (c[0] - a[0]);
+    *out_y = a[1] + u * (b[1] - a[1]) + v * (c[1] - a[1]);
+    *out_z = a[2] + u * (b[2] - a[2]) + v * (c[2] - a[2]);
+}
+
+MCS_DEF size_t mcs_mesh_sampler_work_size( MCHR_UINT triangle_count ) {
+    return (size_t)triangle_count * (3 * sizeof(MCHR_UINT) + sizeof(double));
+}
+
+MCS_DEF void mcs_mesh_sampler_init( mcs_mesh_sampler_t* sampler, const float* positions, const MCHR_UINT* indices,
+                                    MCHR_UINT triangle_count, void* work ) {
+    assert(sampler && triangle_count > 0 && positions && indices && work);
+    const MCHR_UINT n = triangle_count;
+    sampler->positions = positions;
+    sampler->indices = indices;
+    sampler->triangle_count = n;
+    double* scaled = (double*)work;
+    sampler->thresholds = (MCHR_UINT*)(void*)(scaled + n);
+    sampler->aliases = sampler->thresholds + n;
+    MCHR_UINT* stack = sampler->aliases + n;
+
+    double total = 0.0;
+    for (MCHR_UINT i = 0; i < n; ++i) {
+        scaled[i] = mcs_priv_triangle_area(positions, indices + 3 * (size_t)i);
+        total += scaled[i];
+    }
+    sampler->total_area = (float)total;
+
+    // degenerate meshes pick every triangle with the same probability
+    MCHR_UINT small_count = 0, large_count = 0;
+    for (MCHR_UINT i = 0; i < n; ++i) {
+        scaled[i] = (total > 0.0) ? scaled[i] * n / total : 1.0;
+        if (scaled[i] < 1.0)
+            stack[small_count++] = i;
+        else
+            stack[n - 1 - large_count++] = i;
+    }
+    while (small_count > 0 && large_count > 0) {
+        const MCHR_UINT small = stack[--small_count];
+        const MCHR_UINT large = stack[n - large_count];
+        sampler->thresholds[small] = mcs_priv_alias_threshold(scaled[small]);
+        sampler->aliases[small] = large;
+        scaled[large] = (scaled[large] + scaled[small]) - 1.0;
+        if (scaled[large] < 1.0) {
+            large_count -= 1;
+            stack[small_count++] = large;
+        }
+    }
+    // columns left are full (up to rounding)
+    while (small_count > 0) {
+        const MCHR_UINT i = stack[--small_count];
+        sampler->thresholds[i] = 0xffffffffu;
+        sampler->aliases[i] = i;
+    }
+    while (large_count > 0) {
+        const MCHR_UINT i = stack[n - large_count--];
+        sampler->thresholds[i] = 0xffffffffu;
+        sampler->aliases[i] = i;
+    }
+}
+
+MCS_DEF void mcs_mesh_sample( const mcs_mesh_sampler_t* sampler, MCHR_UINT index, MCHR_UINT seed, MCHR_UINT* out_triangle,
+                              float* out_u, float* out_v, float* out_x, float* out_y, float* out_z ) {
+    assert(sampler);
+    MCHR_UINT seeds[4], triangle;
+    float u, v, x, y, z;
+    mcs_priv_mesh_seeds(seed, seeds);
+    mcs_priv_mesh_point(sampler, mchr_get_1d_hash_uint((MCHR_INT)index, seeds[0]), mchr_get_1d_hash_uint((MCHR_INT)index, seeds[1]),
+                        mchr_get_1d_hash_uint((MCHR_INT)index, seeds[2]), mchr_get_1d_hash_uint((MCHR_INT)index, seeds[3]),
+                        &triangle, &u, &v, &x, &y, &z);
+    if (out_triangle) *out_triangle = triangle;
+    if (out_u) *out_u = u;
+    if (out_v) *out_v = v;
+    if (out_x) *out_x = x;
+    if (out_y) *out_y = y;
+    if (out_z) *out_z = z;
+}
+
+MCS_DEF void mcs_mesh_sample_batch( const mcs_mesh_sampler_t* sampler, MCHR_UINT first_index, MCHR_UINT count, MCHR_UINT seed,
+                                    MCHR_UINT* out_triangles, float* out_u, float* out_v, float* out_x, float* out_y, float* out_z ) {
+    assert(sampler);
+    MCHR_UINT seeds[4];
+    MCHR_INT pos[MCS_PRIV_CHUNK];
+    MCHR_UINT hashes[4][MCS_PRIV_CHUNK];
+    MCHR_UINT triangles[MCS_PRIV_CHUNK];
+    float u[MCS_PRIV_CHUNK], v[MCS_PRIV_CHUNK], x[MCS_PRIV_CHUNK], y[MCS_PRIV_CHUNK], z[MCS_PRIV_CHUNK];
+    mcs_priv_mesh_seeds(seed, seeds);
+
+    for (MCHR_UINT first = 0; first < count; first += MCS_PRIV_CHUNK) {
+        const MCHR_UINT n = count - first < MCS_PRIV_CHUNK ? count - first : MCS_PRIV_CHUNK;
+        for (MCHR_UINT k = 0; k < n; ++k) {
+            pos[k] = (MCHR_INT)(first_index + first + k);
+        }
+        for (MCHR_UINT i = 0; i < 4; ++i) {
+            mchr_get_1d_hash_uint_batch(pos, n, seeds[i], hashes[i]);
+        }
+        for (MCHR_UINT k = 0; k < n; ++k) {
+            mcs_priv_mesh_point(sampler, hashes[0][k], hashes[1][k], hashes[2][k], hashes[3][k], &triangles[k], &u[k], &v[k],
+                                &x[k], &y[k], &z[k]);
+        }
+        if (out_triangles) memcpy(out_triangles + first, triangles, n * sizeof(MCHR_UINT));
+        if (out_u) memcpy(out_u + first, u, n * sizeof(float));
+        if (out_v) memcpy(out_v + first, v, n * sizeof(float));
+        if (out_x) memcpy(out_x + first, x, n * sizeof(float));
+        if (out_y) memcpy(out_y + first, y, n * sizeof(float));
+        if (out_z) memcpy(out_z + first, z, n * sizeof(float));
+    }
+}
+
+#endif // MCS_IMPLEMENTATION
+
+/*
+------------------------------------------------------------------------------------------
+This software is available under the MIT license.
+------------------------------------------------------------------------------------------
+MIT License
+
+Copyright (c) 2021 Miguel A. Friginal
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons
+to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+------------------------------------------------------------------------------------------
+*/
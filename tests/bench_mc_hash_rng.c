@@ -0,0 +1,176 @@
+// bench_mc_hash_rng.c - timings for mc_hash_rng.h
+//
+// Build and run from the repository root with
+//
+//      cc -std=c99 -O2 -I. tests/bench_mc_hash_rng.c -o bench_mc_hash_rng -lm && ./bench_mc_hash_rng
+//
+// Times are CPU times of a single thread, best of 3 runs.
+
+#define MCHR_IMPLEMENTATION
+#include "mc_hash_rng.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// keeps results alive, so the compiler can't drop the work
+static volatile double sink;
+
+static double seconds(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+// ---------------------------------------------------------------------------------------
+// Reservoirs: a stream of STREAM_ITEMS items through reservoirs of a few capacities, added
+//  one by one, as ranges, with hashed keys, with weights, and split among 8 reservoirs
+//  (as 8 threads would) that are merged at the end.
+// ---------------------------------------------------------------------------------------
+enum { STREAM_ITEMS = 1 << 24, STREAM_PARTS = 8, RUNS = 3 };
+
+typedef enum stream_kind_t { STREAM_SINGLE, STREAM_RANGE, STREAM_KEYED, STREAM_WEIGHTED, STREAM_MERGED, STREAM_KINDS } stream_kind_t;
+
+static double stream(stream_kind_t kind, MCHR_UINT capacity, mchr_reservoir_entry_t* entries, const float* weights) {
+    mchr_reservoir_t reservoir;
+    mchr_reservoir_init(&reservoir, entries, capacity, 1);
+    switch (kind) {
+    case STREAM_SINGLE:
+        for (MCHR_INT i = 0; i < STREAM_ITEMS; ++i) {
+            mchr_reservoir_add_1d(&reservoir, i);
+        }
+        break;
+    case STREAM_RANGE:
+        mchr_reservoir_add_1d_range(&reservoir, 0, STREAM_ITEMS);
+        break;
+    case STREAM_KEYED:
+        for (MCHR_UINT i = 0; i < STREAM_ITEMS; ++i) {
+            const MCHR_UINT key[2] = { i, ~i };
+            mchr_reservoir_add(&reservoir, key, sizeof(key), i);
+        }
+        break;
+    case STREAM_WEIGHTED:
+        mchr_reservoir_add_1d_range_weighted(&reservoir, 0, STREAM_ITEMS, weights);
+        break;
+    default: {
+        mchr_reservoir_t parts[STREAM_PARTS];
+        mchr_reservoir_entry_t* part_entries = (mchr_reservoir_entry_t*)malloc((size_t)STREAM_PARTS * capacity * sizeof(mchr_reservoir_entry_t));
+        for (MCHR_UINT k = 0; k < STREAM_PARTS; ++k) {
+            mchr_reservoir_init(&parts[k], part_entries + (size_t)k * capacity, capacity, 1);
+            mchr_reservoir_add_1d_range(&parts[k], (MCHR_INT)(k * (STREAM_ITEMS / STREAM_PARTS)), STREAM_ITEMS / STREAM_PARTS);
+        }
+        for (MCHR_UINT k = 0; k < STREAM_PARTS; ++k) {
+            mchr_reservoir_merge(&reservoir, &parts[k]);
+        }
+        free(part_entries);
+        break;
+    }
+    }
+    mchr_reservoir_sort(&reservoir);
+    return reservoir.count ? reservoir.entries[0].priority : 0.0;
+}
+
+static void bench_reservoirs(void) {
+    static const char* kind_names[STREAM_KINDS] = { "add_1d per item", "add_1d_range", "add (8-byte keys)", "add_1d_range_weighted",
+                                                    "8 ranges + merge" };
+    static const MCHR_UINT capacities[3] = { 16, 1024, 65536 };
+    float* weights = (float*)malloc(STREAM_ITEMS * sizeof(float));
+    mchr_reservoir_entry_t* entries = (mchr_reservoir_entry_t*)malloc(65536 * sizeof(mchr_reservoir_entry_t));
+    for (MCHR_INT i = 0; i < STREAM_ITEMS; ++i) {
+        weights[i] = 0.5f + mchr_get_1d_hash_zero_to_one(i, 2);
+    }
+
+    printf("reservoirs, %d items streamed, Mitems/s:\n", STREAM_ITEMS);
+    printf("    %-24s %10s %10s %10s\n", "", "k = 16", "k = 1024", "k = 65536");
+    for (int kind = 0; kind < STREAM_KINDS; ++kind) {
+        printf("    %-24s", kind_names[kind]);
+        for (int c = 0; c < 3; ++c) {
+            double best = 1e30;
+            for (int run = 0; run < RUNS; ++run) {
+                const clock_t start = clock();
+                sink = stream((stream_kind_t)kind, capacities[c], entries, weights);
+                const double time = seconds(start);
+                best = (time < best) ? time : best;
+            }
+            printf(" %10.1f", STREAM_ITEMS / best * 1e-6);
+        }
+        printf("\n");
+    }
+    free(weights);
+    free(entries);
+}
+
+// ---------------------------------------------------------------------------------------
+// Continuous distributions: SAMPLES samples of each, from the 1d functions in a loop and
+//  from the batch functions. Gamma has a shape under 1 (boosted) and one over it.
+// ---------------------------------------------------------------------------------------
+enum { SAMPLES = 1 << 22, DIRICHLET_SIZE = 4 };
+
+typedef enum distribution_kind_t { DIST_EXPONENTIAL, DIST_NORMAL, DIST_GAMMA_SMALL, DIST_GAMMA, DIST_BETA, DIST_DIRICHLET, DIST_KINDS } distribution_kind_t;
+
+static void sample(distribution_kind_t kind, bool batch, float* out) {
+    static const float alphas[DIRICHLET_SIZE] = { 0.2f, 1.0f, 3.0f, 0.5f };
+    switch (kind) {
+    case DIST_EXPONENTIAL:
+        if (batch) mchr_get_1d_exponential_batch(0, SAMPLES, 1, 2.0f, out);
+        else for (MCHR_INT i = 0; i < SAMPLES; ++i) out[i] = mchr_get_1d_exponential(i, 1, 2.0f);
+        break;
+    case DIST_NORMAL:
+        if (batch) mchr_get_1d_normal_batch(0, SAMPLES, 1, 0.0f, 1.0f, out);
+        else for (MCHR_INT i = 0; i < SAMPLES; ++i) out[i] = mchr_get_1d_normal(i, 1, 0.0f, 1.0f);
+        break;
+    case DIST_GAMMA_SMALL:
+    case DIST_GAMMA: {
+        const float shape = (kind == DIST_GAMMA) ? 2.5f : 0.3f;
+        if (batch) mchr_get_1d_gamma_batch(0, SAMPLES, 1, shape, 1.0f, out);
+        else for (MCHR_INT i = 0; i < SAMPLES; ++i) out[i] = mchr_get_1d_gamma(i, 1, shape, 1.0f);
+        break;
+    }
+    case DIST_BETA:
+        if (batch) mchr_get_1d_beta_batch(0, SAMPLES, 1, 2.0f, 5.0f, out);
+        else for (MCHR_INT i = 0; i < SAMPLES; ++i) out[i] = mchr_get_1d_beta(i, 1, 2.0f, 5.0f);
+        break;
+    default:
+        if (batch) {
+            mchr_get_1d_dirichlet_batch(0, SAMPLES, 1, alphas, DIRICHLET_SIZE, out);
+        } else {
+            for (MCHR_INT i = 0; i < SAMPLES; ++i) {
+                float ratios[DIRICHLET_SIZE];
+                mchr_get_1d_dirichlet(i, 1, alphas, DIRICHLET_SIZE, ratios);
+                for (MCHR_UINT j = 0; j < DIRICHLET_SIZE; ++j) {
+                    out[j * SAMPLES + (MCHR_UINT)i] = ratios[j];
+                }
+            }
+        }
+        break;
+    }
+}
+
+static void bench_distributions(void) {
+    static const char* kind_names[DIST_KINDS] = { "exponential", "normal", "gamma, shape 0.3", "gamma, shape 2.5", "beta (2, 5)",
+                                                  "dirichlet, 4 alphas" };
+    float* out = (float*)malloc((size_t)SAMPLES * DIRICHLET_SIZE * sizeof(float));
+
+    printf("continuous distributions, %d samples, Msamples/s:\n", SAMPLES);
+    printf("    %-24s %10s %10s\n", "", "1d loop", "batch");
+    for (int kind = 0; kind < DIST_KINDS; ++kind) {
+        printf("    %-24s", kind_names[kind]);
+        for (int batch = 0; batch < 2; ++batch) {
+            double best = 1e30;
+            for (int run = 0; run < RUNS; ++run) {
+                const clock_t start = clock();
+                sample((distribution_kind_t)kind, batch != 0, out);
+                const double time = seconds(start);
+                best = (time < best) ? time : best;
+                sink = out[SAMPLES / 2];
+            }
+            printf(" %10.1f", SAMPLES / best * 1e-6);
+        }
+        printf("\n");
+    }
+    free(out);
+}
+
+int main(void) {
+    bench_reservoirs();
+    bench_distributions();
+    return 0;
+}
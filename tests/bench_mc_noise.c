@@ -0,0 +1,149 @@
+// bench_mc_noise.c - timings for mc_noise.h
+//
+// Build and run from the repository root with
+//
+//      cc -std=c99 -O2 -I. tests/bench_mc_noise.c -o bench_mc_noise -lm && ./bench_mc_noise
+//
+// Times are CPU times of a single thread, best of 3 runs.
+
+#define MCHR_IMPLEMENTATION
+#define MCN_IMPLEMENTATION
+#include "mc_noise.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// keeps results alive, so the compiler can't drop the work
+static volatile float sink;
+
+static double seconds(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+// ---------------------------------------------------------------------------------------
+// Baseline: Ken Perlin's improved noise (2002), with its 256-entry permutation table
+//  repeated twice to skip the index wrapping, and its 12 edge gradients picked by
+//  `hash & 15`. The table is shuffled with a hash here instead of using the published
+//  one, which doesn't change the cost.
+// ---------------------------------------------------------------------------------------
+static int perm[512];
+
+static void perm_init(MCHR_UINT seed) {
+    for (int i = 0; i < 256; ++i) {
+        perm[i] = i;
+    }
+    for (int i = 255; i > 0; --i) {
+        const int j = (int)mchr_get_1d_hash_uint_in_range(i, seed, 0, (MCHR_UINT)i);
+        const int swap = perm[i];
+        perm[i] = perm[j];
+        perm[j] = swap;
+    }
+    for (int i = 0; i < 256; ++i) {
+        perm[256 + i] = perm[i];
+    }
+}
+
+static float perm_fade(float t) {
+    return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+static float perm_lerp(float t, float a, float b) {
+    return a + t * (b - a);
+}
+
+static float perm_grad(int hash, float x, float y, float z) {
+    const int h = hash & 15;
+    const float u = h < 8 ? x : y;
+    const float v = h < 4 ? y : (h == 12 || h == 14) ? x : z;
+    return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
+}
+
+static float perm_noise_3d(float x, float y, float z) {
+    const float fx = floorf(x), fy = floorf(y), fz = floorf(z);
+    const int X = (int)fx & 255, Y = (int)fy & 255, Z = (int)fz & 255;
+    x -= fx;
+    y -= fy;
+    z -= fz;
+    const float u = perm_fade(x), v = perm_fade(y), w = perm_fade(z);
+    const int A = perm[X] + Y, AA = perm[A] + Z, AB = perm[A + 1] + Z;
+    const int B = perm[X + 1] + Y, BA = perm[B] + Z, BB = perm[B + 1] + Z;
+    return perm_lerp(w, perm_lerp(v, perm_lerp(u, perm_grad(perm[AA], x, y, z), perm_grad(perm[BA], x - 1, y, z)),
+                                     perm_lerp(u, perm_grad(perm[AB], x, y - 1, z), perm_grad(perm[BB], x - 1, y - 1, z))),
+                        perm_lerp(v, perm_lerp(u, perm_grad(perm[AA + 1], x, y, z - 1), perm_grad(perm[BA + 1], x - 1, y, z - 1)),
+                                     perm_lerp(u, perm_grad(perm[AB + 1], x, y - 1, z - 1), perm_grad(perm[BB + 1], x - 1, y - 1, z - 1))));
+}
+
+// ---------------------------------------------------------------------------------------
+// 3D gradient noise over a SIZE^3 grid with a step of 0.05, evaluated point by point with
+//  the baseline and mcn_gradient_noise_3d, with mcn_gradient_noise_3d_batch on the
+//  precomputed coordinates of the grid, and with mcn_gradient_noise_3d_grid.
+// ---------------------------------------------------------------------------------------
+enum { SIZE = 128, POINTS = SIZE * SIZE * SIZE, RUNS = 3 };
+#define STEP 0.05f
+#define START 10.3f
+
+typedef enum bench_kind_t { BENCH_PERM, BENCH_SCALAR, BENCH_BATCH, BENCH_GRID, BENCH_KINDS } bench_kind_t;
+
+static void run(bench_kind_t kind, const float* xs, const float* ys, const float* zs, float* out) {
+    switch (kind) {
+    case BENCH_PERM:
+    case BENCH_SCALAR:
+        for (MCHR_UINT k = 0; k < SIZE; ++k) {
+            for (MCHR_UINT j = 0; j < SIZE; ++j) {
+                for (MCHR_UINT i = 0; i < SIZE; ++i) {
+                    const float x = START + STEP * (float)i, y = START + STEP * (float)j, z = START + STEP * (float)k;
+                    out[(k * SIZE + j) * SIZE + i] = (kind == BENCH_PERM) ? perm_noise_3d(x, y, z) : mcn_gradient_noise_3d(x, y, z, 1);
+                }
+            }
+        }
+        break;
+    case BENCH_BATCH:
+        mcn_gradient_noise_3d_batch(xs, ys, zs, POINTS, 1, out);
+        break;
+    default:
+        mcn_gradient_noise_3d_grid(START, START, START, STEP, STEP, STEP, SIZE, SIZE, SIZE, 1, out);
+        break;
+    }
+}
+
+static void bench_gradient_noise(void) {
+    static const char* kind_names[BENCH_KINDS] = { "permutation table", "mcn scalar", "mcn batch", "mcn grid" };
+    float* xs = (float*)malloc(POINTS * sizeof(float));
+    float* ys = (float*)malloc(POINTS * sizeof(float));
+    float* zs = (float*)malloc(POINTS * sizeof(float));
+    float* out = (float*)malloc(POINTS * sizeof(float));
+    for (MCHR_UINT k = 0; k < SIZE; ++k) {
+        for (MCHR_UINT j = 0; j < SIZE; ++j) {
+            for (MCHR_UINT i = 0; i < SIZE; ++i) {
+                const MCHR_UINT index = (k * SIZE + j) * SIZE + i;
+                xs[index] = START + STEP * (float)i;
+                ys[index] = START + STEP * (float)j;
+                zs[index] = START + STEP * (float)k;
+            }
+        }
+    }
+    perm_init(1);
+
+    printf("3d gradient noise, %d^3 points:\n", SIZE);
+    for (int kind = 0; kind < BENCH_KINDS; ++kind) {
+        double best = 1e30;
+        for (int run_index = 0; run_index < RUNS; ++run_index) {
+            const clock_t start = clock();
+            run((bench_kind_t)kind, xs, ys, zs, out);
+            const double time = seconds(start);
+            best = (time < best) ? time : best;
+            sink = out[POINTS / 2];
+        }
+        printf("    %-20s %8.3f s %8.1f Mpoints/s\n", kind_names[kind], best, POINTS / best * 1e-6);
+    }
+    free(xs);
+    free(ys);
+    free(zs);
+    free(out);
+}
+
+int main(void) {
+    bench_gradient_noise();
+    return 0;
+}
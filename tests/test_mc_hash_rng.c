@@ -0,0 +1,369 @@
+// test_mc_hash_rng.c - checks for mc_hash_rng.h
+//
+// Build and run from the repository root with
+//
+//      cc -std=c99 -O2 -I. tests/test_mc_hash_rng.c -o test_mc_hash_rng -lm && ./test_mc_hash_rng
+//
+// Returns 0 when every check passes, and prints the failures otherwise.
+
+#define MCHR_IMPLEMENTATION
+#include "mc_hash_rng.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition, ...) \
+    do { if (!(condition)) { ++failures; printf("FAILED %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+// uniform float in [min, max) for test case `index`
+static float random_float(MCHR_INT index, MCHR_UINT seed, float min, float max) {
+    return min + (max - min) * mchr_get_1d_hash_zero_to_one(index, seed);
+}
+
+// position `offset` after `first`, wrapping like the library does
+static MCHR_INT wrapped(MCHR_INT first, MCHR_UINT offset) {
+    return (MCHR_INT)((MCHR_UINT)first + offset);
+}
+
+// ---------------------------------------------------------------------------------------
+// Reservoirs: merging reservoirs that received any split of the items, in any arrival and
+//  merge order, must give the same selection as one reservoir receiving them all, which
+//  must be the items with the highest priorities. Range additions, which skip most
+//  candidates with a single compare against the root, must match single additions.
+// ---------------------------------------------------------------------------------------
+enum { RESERVOIR_ITEMS = 20011, RESERVOIR_CAPACITY = 64, RESERVOIR_MAX_PARTS = 16 };
+
+static bool same_selection(mchr_reservoir_t* a, mchr_reservoir_t* b) {
+    mchr_reservoir_sort(a);
+    mchr_reservoir_sort(b);
+    if (a->count != b->count)
+        return false;
+    for (MCHR_UINT i = 0; i < a->count; ++i) {
+        if (a->entries[i].priority != b->entries[i].priority || a->entries[i].item != b->entries[i].item)
+            return false;
+    }
+    return true;
+}
+
+static float item_weight(MCHR_INT item) {
+    // a few items with weight zero, which are never selected
+    return (item % 10 == 3) ? 0.0f : random_float(item, 2, 0.0f, 4.0f);
+}
+
+// unweighted, weighted, or keyed by groups of 4 items, so priorities tie and the selection
+//  depends on the items breaking the ties
+enum { RESERVOIR_UNWEIGHTED, RESERVOIR_WEIGHTED, RESERVOIR_TIED, RESERVOIR_MODES };
+
+static void reservoir_add(mchr_reservoir_t* reservoir, int mode, MCHR_INT item) {
+    const MCHR_INT key = item / 4;
+    if (mode == RESERVOIR_WEIGHTED)
+        mchr_reservoir_add_1d_weighted(reservoir, item, item_weight(item));
+    else if (mode == RESERVOIR_TIED)
+        mchr_reservoir_add(reservoir, &key, sizeof(key), (MCHR_UINT)item);
+    else
+        mchr_reservoir_add_1d(reservoir, item);
+}
+
+static void test_reservoir_merge(void) {
+    static const MCHR_UINT part_counts[4] = { 1, 2, 7, RESERVOIR_MAX_PARTS };
+    static const char* mode_names[RESERVOIR_MODES] = { "", " weighted", " tied" };
+    for (int mode = 0; mode < RESERVOIR_MODES; ++mode) {
+        mchr_reservoir_entry_t reference_entries[RESERVOIR_CAPACITY];
+        mchr_reservoir_t reference;
+        mchr_reservoir_init(&reference, reference_entries, RESERVOIR_CAPACITY, 5);
+        for (MCHR_INT i = 0; i < RESERVOIR_ITEMS; ++i) {
+            reservoir_add(&reference, mode, i);
+        }
+
+        // the selection is the items with the highest priorities, found by brute force
+        if (mode == RESERVOIR_UNWEIGHTED) {
+            unsigned higher = 0;
+            MCHR_UINT lowest = 0xFFFFFFFFU;
+            for (MCHR_UINT i = 0; i < reference.count; ++i) {
+                const MCHR_UINT priority = (MCHR_UINT)reference.entries[i].priority;
+                lowest = (priority < lowest) ? priority : lowest;
+            }
+            for (MCHR_INT i = 0; i < RESERVOIR_ITEMS; ++i) {
+                higher += (mchr_get_1d_hash_uint(i, 5) > lowest);
+            }
+            CHECK(reference.count == RESERVOIR_CAPACITY && higher == RESERVOIR_CAPACITY - 1,
+                  "reservoir: %u items selected, %u items above the lowest selected priority", reference.count, higher);
+        }
+
+        for (int p = 0; p < 4; ++p) {
+            const MCHR_UINT parts = part_counts[p];
+            for (int split = 0; split < 2; ++split) {
+                // items split in contiguous blocks or interleaved, arriving in a scrambled
+                //  order (a stride coprime with the number of items)
+                mchr_reservoir_entry_t entries[RESERVOIR_MAX_PARTS][RESERVOIR_CAPACITY];
+                mchr_reservoir_t reservoirs[RESERVOIR_MAX_PARTS];
+                for (MCHR_UINT k = 0; k < parts; ++k) {
+                    mchr_reservoir_init(&reservoirs[k], entries[k], RESERVOIR_CAPACITY, 5);
+                }
+                for (MCHR_UINT n = 0; n < RESERVOIR_ITEMS; ++n) {
+                    const MCHR_INT item = (MCHR_INT)((n * 7919u) % RESERVOIR_ITEMS);
+                    const MCHR_UINT part = split ? (MCHR_UINT)item % parts : (MCHR_UINT)item * parts / RESERVOIR_ITEMS;
+                    reservoir_add(&reservoirs[part], mode, item);
+                }
+
+                // merged forwards into a new reservoir, and backwards into the last part
+                mchr_reservoir_entry_t merged_entries[RESERVOIR_CAPACITY];
+                mchr_reservoir_t merged;
+                mchr_reservoir_init(&merged, merged_entries, RESERVOIR_CAPACITY, 5);
+                for (MCHR_UINT k = 0; k < parts; ++k) {
+                    mchr_reservoir_merge(&merged, &reservoirs[k]);
+                }
+                for (MCHR_UINT k = parts - 1; k-- > 0;) {
+                    mchr_reservoir_merge(&reservoirs[parts - 1], &reservoirs[k]);
+                }
+                CHECK(same_selection(&merged, &reference), "reservoir%s: %u %s parts merged forwards differ from a single reservoir",
+                      mode_names[mode], parts, split ? "interleaved" : "contiguous");
+                CHECK(same_selection(&reservoirs[parts - 1], &reference), "reservoir%s: %u %s parts merged backwards differ from a single reservoir",
+                      mode_names[mode], parts, split ? "interleaved" : "contiguous");
+            }
+        }
+    }
+}
+
+static void test_reservoir_ranges(void) {
+    static const MCHR_UINT capacities[4] = { 0, 1, 7, RESERVOIR_CAPACITY };
+    static const MCHR_INT firsts[3] = { 0, -1000, INT_MAX - 1000 };
+    static const MCHR_UINT counts[3] = { 3, 100, 5000 };
+    static float weights[5000];
+    for (int c = 0; c < 4; ++c) {
+        for (int f = 0; f < 3; ++f) {
+            for (int n = 0; n < 3; ++n) {
+                for (int weighted = 0; weighted < 2; ++weighted) {
+                    mchr_reservoir_entry_t range_entries[RESERVOIR_CAPACITY], single_entries[RESERVOIR_CAPACITY];
+                    mchr_reservoir_t range, single;
+                    mchr_reservoir_init(&range, range_entries, capacities[c], 9);
+                    mchr_reservoir_init(&single, single_entries, capacities[c], 9);
+                    // a partially filled reservoir first, then the range
+                    for (MCHR_INT i = 0; i < 5; ++i) {
+                        const MCHR_INT item = -5000 - i;
+                        if (weighted) {
+                            mchr_reservoir_add_1d_weighted(&range, item, 1.0f);
+                            mchr_reservoir_add_1d_weighted(&single, item, 1.0f);
+                        } else {
+                            mchr_reservoir_add_1d(&range, item);
+                            mchr_reservoir_add_1d(&single, item);
+                        }
+                    }
+                    for (MCHR_UINT i = 0; i < counts[n]; ++i) {
+                        weights[i] = item_weight(wrapped(firsts[f], i));
+                        if (weighted)
+                            mchr_reservoir_add_1d_weighted(&single, wrapped(firsts[f], i), weights[i]);
+                        else
+                            mchr_reservoir_add_1d(&single, wrapped(firsts[f], i));
+                    }
+                    if (weighted)
+                        mchr_reservoir_add_1d_range_weighted(&range, firsts[f], counts[n], weights);
+                    else
+                        mchr_reservoir_add_1d_range(&range, firsts[f], counts[n]);
+                    CHECK(same_selection(&range, &single), "reservoir%s range of %u from %d, capacity %u: differs from single additions",
+                          weighted ? " weighted" : "", counts[n], (int)firsts[f], capacities[c]);
+                }
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Continuous distributions: batches must give exactly the samples of the 1d functions,
+//  across several chunks and INT_MAX, including gamma shapes so small that the samples
+//  underflow and beta/Dirichlet fall back to picking a side.
+// ---------------------------------------------------------------------------------------
+enum { SAMPLE_COUNT = 150, DIRICHLET_SIZE = 4 };
+
+static void test_distributions(void) {
+    static const MCHR_INT firsts[3] = { 0, -70, INT_MAX - 70 };
+    static const float shapes[5] = { 0.001f, 0.3f, 1.0f, 2.5f, 40.0f };
+    static const float alphas[2][DIRICHLET_SIZE] = { { 0.2f, 1.0f, 3.0f, 0.5f }, { 0.001f, 0.002f, 0.001f, 0.003f } };
+    float batch[SAMPLE_COUNT * DIRICHLET_SIZE];
+    for (int f = 0; f < 3; ++f) {
+        const MCHR_INT first = firsts[f];
+        unsigned mismatches = 0;
+        mchr_get_1d_exponential_batch(first, SAMPLE_COUNT, 3, 2.5f, batch);
+        for (MCHR_UINT i = 0; i < SAMPLE_COUNT; ++i) {
+            mismatches += (batch[i] != mchr_get_1d_exponential(wrapped(first, i), 3, 2.5f));
+        }
+        CHECK(mismatches == 0, "exponential from %d: %u batch samples differ", (int)first, mismatches);
+
+        mismatches = 0;
+        mchr_get_1d_normal_batch(first, SAMPLE_COUNT, 3, 1.5f, 4.0f, batch);
+        for (MCHR_UINT i = 0; i < SAMPLE_COUNT; ++i) {
+            mismatches += (batch[i] != mchr_get_1d_normal(wrapped(first, i), 3, 1.5f, 4.0f));
+        }
+        CHECK(mismatches == 0, "normal from %d: %u batch samples differ", (int)first, mismatches);
+
+        for (int a = 0; a < 5; ++a) {
+            const float shape = shapes[a], other = shapes[4 - a];
+            mismatches = 0;
+            mchr_get_1d_gamma_batch(first, SAMPLE_COUNT, 5, shape, 2.0f, batch);
+            for (MCHR_UINT i = 0; i < SAMPLE_COUNT; ++i) {
+                mismatches += (batch[i] != mchr_get_1d_gamma(wrapped(first, i), 5, shape, 2.0f));
+            }
+            CHECK(mismatches == 0, "gamma, shape %g from %d: %u batch samples differ", shape, (int)first, mismatches);
+
+            // the same shape on both sides too, for the underflow of both gamma samples
+            for (int same = 0; same < 2; ++same) {
+                const float beta = same ? shape : other;
+                mismatches = 0;
+                mchr_get_1d_beta_batch(first, SAMPLE_COUNT, 5, shape, beta, batch);
+                for (MCHR_UINT i = 0; i < SAMPLE_COUNT; ++i) {
+                    mismatches += (batch[i] != mchr_get_1d_beta(wrapped(first, i), 5, shape, beta));
+                }
+                CHECK(mismatches == 0, "beta (%g, %g) from %d: %u batch samples differ", shape, beta, (int)first, mismatches);
+            }
+        }
+
+        for (int a = 0; a < 2; ++a) {
+            mismatches = 0;
+            mchr_get_1d_dirichlet_batch(first, SAMPLE_COUNT, 9, alphas[a], DIRICHLET_SIZE, batch);
+            for (MCHR_UINT i = 0; i < SAMPLE_COUNT; ++i) {
+                float ratios[DIRICHLET_SIZE];
+                mchr_get_1d_dirichlet(wrapped(first, i), 9, alphas[a], DIRICHLET_SIZE, ratios);
+                for (MCHR_UINT j = 0; j < DIRICHLET_SIZE; ++j) {
+                    mismatches += (batch[j * SAMPLE_COUNT + i] != ratios[j]);
+                }
+            }
+            CHECK(mismatches == 0, "dirichlet, alphas %d from %d: %u batch ratios differ", a, (int)first, mismatches);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Quantization: batch results must be bit-exact with the single value functions, for every
+//  rounding mode and output type, including clamped, infinite and NaN values, and spans
+//  of positions crossing INT_MAX.
+// ---------------------------------------------------------------------------------------
+enum { QUANTIZE_WIDTH = 150, QUANTIZE_HEIGHT = 4, QUANTIZE_COUNT = QUANTIZE_WIDTH * QUANTIZE_HEIGHT };
+
+static void test_quantize(void) {
+    static const char* rounding_names[4] = { "nearest", "stochastic", "triangular dither", "ordered dither" };
+    static const char* type_names[4] = { "u8", "u16", "i16", "i32" };
+    static const MCHR_INT limits[4][2] = { { 0, 255 }, { 0, 65535 }, { -32768, 32767 }, { INT_MIN, INT_MAX } };
+    static const float scales[4] = { 300.0f, 80000.0f, 40000.0f, 3e9f };
+    static const MCHR_INT firsts[3][2] = { { 0, 0 }, { -70, -2 }, { INT_MAX - 70, INT_MAX - 1 } };
+
+    static float values[QUANTIZE_COUNT];
+    for (MCHR_INT i = 0; i < QUANTIZE_COUNT; ++i) {
+        // mostly inside the output range, some outside it, and some exact halves
+        values[i] = random_float(i, 1, -0.2f, 1.2f);
+        if (i % 7 == 0)
+            values[i] = (float)(i % 5) * 0.5f;
+    }
+    values[3] = NAN;
+    values[4] = INFINITY;
+    values[5] = -INFINITY;
+    values[QUANTIZE_WIDTH + 1] = NAN;
+
+    for (int type = 0; type < 4; ++type) {
+        // signed types get values centered on zero
+        const float scale = scales[type];
+        const float offset = (limits[type][0] < 0) ? -0.5f * scale : 0.0f;
+        for (int rounding = 0; rounding < 4; ++rounding) {
+            for (int f = 0; f < 3; ++f) {
+                const MCHR_INT first_x = firsts[f][0], first_y = firsts[f][1];
+                const mchr_rounding_t mode = (mchr_rounding_t)rounding;
+                MCHR_INT batch[2][QUANTIZE_COUNT];
+                static unsigned char u8[QUANTIZE_COUNT];
+                static unsigned short u16[QUANTIZE_COUNT];
+                static short i16[QUANTIZE_COUNT];
+                for (int is_2d = 0; is_2d < 2; ++is_2d) {
+                    MCHR_INT* out = batch[is_2d];
+                    switch (type) {
+                    case 0:
+                        if (is_2d) mchr_quantize_2d_u8_batch(values, QUANTIZE_WIDTH, QUANTIZE_HEIGHT, scale, offset, mode, first_x, first_y, 7, u8);
+                        else mchr_quantize_1d_u8_batch(values, QUANTIZE_COUNT, scale, offset, mode, first_x, 7, u8);
+                        for (int i = 0; i < QUANTIZE_COUNT; ++i) out[i] = u8[i];
+                        break;
+                    case 1:
+                        if (is_2d) mchr_quantize_2d_u16_batch(values, QUANTIZE_WIDTH, QUANTIZE_HEIGHT, scale, offset, mode, first_x, first_y, 7, u16);
+                        else mchr_quantize_1d_u16_batch(values, QUANTIZE_COUNT, scale, offset, mode, first_x, 7, u16);
+                        for (int i = 0; i < QUANTIZE_COUNT; ++i) out[i] = u16[i];
+                        break;
+                    case 2:
+                        if (is_2d) mchr_quantize_2d_i16_batch(values, QUANTIZE_WIDTH, QUANTIZE_HEIGHT, scale, offset, mode, first_x, first_y, 7, i16);
+                        else mchr_quantize_1d_i16_batch(values, QUANTIZE_COUNT, scale, offset, mode, first_x, 7, i16);
+                        for (int i = 0; i < QUANTIZE_COUNT; ++i) out[i] = i16[i];
+                        break;
+                    default:
+                        if (is_2d) mchr_quantize_2d_i32_batch(values, QUANTIZE_WIDTH, QUANTIZE_HEIGHT, scale, offset, mode, first_x, first_y, 7, out);
+                        else mchr_quantize_1d_i32_batch(values, QUANTIZE_COUNT, scale, offset, mode, first_x, 7, out);
+                        break;
+                    }
+                }
+
+                unsigned mismatches[2] = { 0, 0 };
+                for (MCHR_UINT i = 0; i < QUANTIZE_COUNT; ++i) {
+                    const MCHR_INT x = wrapped(first_x, i % QUANTIZE_WIDTH), y = wrapped(first_y, i / QUANTIZE_WIDTH);
+                    const MCHR_INT single_1d = mchr_quantize_1d(values[i], scale, offset, mode, wrapped(first_x, i), 7, limits[type][0], limits[type][1]);
+                    const MCHR_INT single_2d = mchr_quantize_2d(values[i], scale, offset, mode, x, y, 7, limits[type][0], limits[type][1]);
+                    mismatches[0] += (batch[0][i] != single_1d);
+                    mismatches[1] += (batch[1][i] != single_2d);
+                }
+                CHECK(mismatches[0] == 0, "quantize 1d %s %s from %d: %u batch values differ", type_names[type], rounding_names[rounding],
+                      (int)first_x, mismatches[0]);
+                CHECK(mismatches[1] == 0, "quantize 2d %s %s from (%d, %d): %u batch values differ", type_names[type], rounding_names[rounding],
+                      (int)first_x, (int)first_y, mismatches[1]);
+            }
+        }
+    }
+
+    CHECK(mchr_quantize_1d(NAN, 1.0f, 0.0f, MCHR_ROUNDING_NEAREST, 0, 0, -5, 5) == -5, "quantize: NaN doesn't give the minimum");
+    CHECK(mchr_quantize_1d(1e30f, 1.0f, 0.0f, MCHR_ROUNDING_NEAREST, 0, 0, -5, 5) == 5, "quantize: huge value isn't clamped");
+}
+
+// ---------------------------------------------------------------------------------------
+// Quadtrees and octrees: batch boxes must give the same values as single nodes, at any
+//  level, including boxes crossing INT_MAX.
+// ---------------------------------------------------------------------------------------
+enum { TREE_SIZE = 6 };
+
+static void test_trees(void) {
+    static const MCHR_UINT levels[4] = { 0, 1, 4, 31 };
+    static const MCHR_INT firsts[3] = { 0, -3, INT_MAX - 2 };
+    for (int l = 0; l < 4; ++l) {
+        for (int f = 0; f < 3; ++f) {
+            const MCHR_UINT level = levels[l];
+            const MCHR_INT first = firsts[f];
+            MCHR_UINT counts[TREE_SIZE * TREE_SIZE * TREE_SIZE];
+            float masses[TREE_SIZE * TREE_SIZE * TREE_SIZE];
+            unsigned mismatches = 0;
+
+            mchr_get_quadtree_count_batch(level, first, first, TREE_SIZE, TREE_SIZE, 3, 1e6f, counts);
+            mchr_get_quadtree_mass_batch(level, first, first, TREE_SIZE, TREE_SIZE, 3, 1.0f, 0.5f, masses);
+            for (MCHR_UINT i = 0; i < TREE_SIZE * TREE_SIZE; ++i) {
+                const MCHR_INT x = wrapped(first, i % TREE_SIZE), y = wrapped(first, i / TREE_SIZE);
+                mismatches += (counts[i] != mchr_get_quadtree_count(level, x, y, 3, 1e6f));
+                mismatches += (masses[i] != mchr_get_quadtree_mass(level, x, y, 3, 1.0f, 0.5f));
+            }
+            CHECK(mismatches == 0, "quadtree level %u from %d: %u batch values differ", level, (int)first, mismatches);
+
+            mismatches = 0;
+            mchr_get_octree_count_batch(level, first, first, first, TREE_SIZE, TREE_SIZE, TREE_SIZE, 3, 1e6f, counts);
+            mchr_get_octree_mass_batch(level, first, first, first, TREE_SIZE, TREE_SIZE, TREE_SIZE, 3, 1.0f, 0.5f, masses);
+            for (MCHR_UINT i = 0; i < TREE_SIZE * TREE_SIZE * TREE_SIZE; ++i) {
+                const MCHR_INT x = wrapped(first, i % TREE_SIZE), y = wrapped(first, i / TREE_SIZE % TREE_SIZE), z = wrapped(first, i / (TREE_SIZE * TREE_SIZE));
+                mismatches += (counts[i] != mchr_get_octree_count(level, x, y, z, 3, 1e6f));
+                mismatches += (masses[i] != mchr_get_octree_mass(level, x, y, z, 3, 1.0f, 0.5f));
+            }
+            CHECK(mismatches == 0, "octree level %u from %d: %u batch values differ", level, (int)first, mismatches);
+        }
+    }
+}
+
+int main(void) {
+    test_reservoir_merge();
+    test_reservoir_ranges();
+    test_distributions();
+    test_quantize();
+    test_trees();
+    if (failures == 0)
+        printf("all tests passed\n");
+    return failures != 0;
+}
@@ -0,0 +1,173 @@
+// test_mc_noise.c - checks for mc_noise.h
+//
+// Build and run from the repository root with
+//
+//      cc -std=c99 -O2 -I. tests/test_mc_noise.c -o test_mc_noise -lm && ./test_mc_noise
+//
+// Returns 0 when every check passes, and prints the failures otherwise.
+
+#define MCHR_IMPLEMENTATION
+#define MCN_IMPLEMENTATION
+#include "mc_noise.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static int failures = 0;
+
+#define CHECK(condition, ...) \
+    do { if (!(condition)) { ++failures; printf("FAILED %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+// uniform float in [min, max) for test case `index`
+static float random_float(MCHR_INT index, MCHR_UINT seed, float min, float max) {
+    return min + (max - min) * mchr_get_1d_hash_zero_to_one(index, seed);
+}
+
+// leaves garbage in the stack, where the next function called keeps its locals
+static void dirty_stack(void) {
+    volatile unsigned char garbage[4096];
+    for (size_t i = 0; i < sizeof(garbage); ++i) {
+        garbage[i] = (unsigned char)(i * 131u + 17u);
+    }
+}
+
+enum { VALUE_2D, VALUE_3D, GRADIENT_2D, GRADIENT_3D, SIMPLEX_2D, SIMPLEX_3D, CELLULAR_2D, CELLULAR_3D, FRACTAL_2D, FRACTAL_3D, KINDS };
+
+static const char* kind_names[KINDS] = { "value 2d", "value 3d", "gradient 2d", "gradient 3d", "simplex 2d", "simplex 3d",
+                                         "cellular 2d", "cellular 3d", "fractal 2d", "fractal 3d" };
+
+static float noise(int kind, const mcn_fractal_t* fractal, const float* p, MCHR_UINT seed) {
+    switch (kind) {
+    case VALUE_2D:      return mcn_value_noise_2d(p[0], p[1], seed);
+    case VALUE_3D:      return mcn_value_noise_3d(p[0], p[1], p[2], seed);
+    case GRADIENT_2D:   return mcn_gradient_noise_2d(p[0], p[1], seed);
+    case GRADIENT_3D:   return mcn_gradient_noise_3d(p[0], p[1], p[2], seed);
+    case SIMPLEX_2D:    return mcn_simplex_noise_2d(p[0], p[1], seed);
+    case SIMPLEX_3D:    return mcn_simplex_noise_3d(p[0], p[1], p[2], seed);
+    case CELLULAR_2D:   return mcn_cellular_noise_2d(p[0], p[1], 1.0f, MCN_DISTANCE_EUCLIDEAN, seed, NULL, NULL);
+    case CELLULAR_3D:   return mcn_cellular_noise_3d(p[0], p[1], p[2], 1.0f, MCN_DISTANCE_EUCLIDEAN, seed, NULL, NULL);
+    case FRACTAL_2D:    return mcn_fractal_noise_2d(fractal, p[0], p[1], seed);
+    default:            return mcn_fractal_noise_3d(fractal, p[0], p[1], p[2], seed);
+    }
+}
+
+static void bounds(int kind, const mcn_fractal_t* fractal, const float* lo, const float* hi, MCHR_UINT seed, float* out) {
+    switch (kind) {
+    case VALUE_2D:      mcn_value_noise_2d_bounds(lo[0], lo[1], hi[0], hi[1], seed, &out[0], &out[1]); break;
+    case VALUE_3D:      mcn_value_noise_3d_bounds(lo[0], lo[1], lo[2], hi[0], hi[1], hi[2], seed, &out[0], &out[1]); break;
+    case GRADIENT_2D:   mcn_gradient_noise_2d_bounds(lo[0], lo[1], hi[0], hi[1], seed, &out[0], &out[1]); break;
+    case GRADIENT_3D:   mcn_gradient_noise_3d_bounds(lo[0], lo[1], lo[2], hi[0], hi[1], hi[2], seed, &out[0], &out[1]); break;
+    case SIMPLEX_2D:    mcn_simplex_noise_2d_bounds(lo[0], lo[1], hi[0], hi[1], seed, &out[0], &out[1]); break;
+    case SIMPLEX_3D:    mcn_simplex_noise_3d_bounds(lo[0], lo[1], lo[2], hi[0], hi[1], hi[2], seed, &out[0], &out[1]); break;
+    case CELLULAR_2D:   mcn_cellular_noise_2d_bounds(lo[0], lo[1], hi[0], hi[1], 1.0f, MCN_DISTANCE_EUCLIDEAN, seed, &out[0], &out[1]); break;
+    case CELLULAR_3D:   mcn_cellular_noise_3d_bounds(lo[0], lo[1], lo[2], hi[0], hi[1], hi[2], 1.0f, MCN_DISTANCE_EUCLIDEAN, seed,
+                                                     &out[0], &out[1]); break;
+    case FRACTAL_2D:    mcn_fractal_noise_2d_bounds(fractal, lo[0], lo[1], hi[0], hi[1], seed, &out[0], &out[1]); break;
+    default:            mcn_fractal_noise_3d_bounds(fractal, lo[0], lo[1], lo[2], hi[0], hi[1], hi[2], seed, &out[0], &out[1]); break;
+    }
+}
+
+// Bounds of random boxes must contain the noise at random points of the box, and be
+//  tight for small boxes (the stack is dirtied before each call, so that reading
+//  uninitialized locals shows up as loose or unstable bounds).
+static void test_bounds(void) {
+    const MCHR_UINT BOXES = 300, SAMPLES = 100;
+    const float sizes[2] = { 0.01f, 0.5f };
+    mcn_fractal_t fractal;
+    mcn_fractal_init(&fractal, MCN_NOISE_GRADIENT, MCN_FRACTAL_FBM, 4);
+
+    for (int kind = 0; kind < KINDS; ++kind) {
+        const MCHR_UINT dims = (kind % 2 == 0) ? 2 : 3;
+        for (int s = 0; s < 2; ++s) {
+            MCHR_UINT violations = 0;
+            double total_width = 0.0;
+            for (MCHR_UINT box = 0; box < BOXES; ++box) {
+                const MCHR_UINT seed = mchr_get_1d_hash_uint((MCHR_INT)box, 7);
+                float lo[3], hi[3], range[2], again[2];
+                for (MCHR_UINT d = 0; d < dims; ++d) {
+                    lo[d] = random_float((MCHR_INT)(box * 3 + d), 11, -100.0f, 100.0f);
+                    hi[d] = lo[d] + sizes[s];
+                }
+                dirty_stack();
+                bounds(kind, &fractal, lo, hi, seed, range);
+                bounds(kind, &fractal, lo, hi, seed, again);
+                CHECK(range[0] == again[0] && range[1] == again[1], "%s bounds differ between calls", kind_names[kind]);
+                total_width += range[1] - range[0];
+                for (MCHR_UINT i = 0; i < SAMPLES; ++i) {
+                    float p[3];
+                    for (MCHR_UINT d = 0; d < dims; ++d) {
+                        p[d] = random_float((MCHR_INT)(i * 3 + d), seed, lo[d], hi[d]);
+                    }
+                    const float value = noise(kind, &fractal, p, seed);
+                    violations += (value < range[0] || value > range[1]);
+                }
+            }
+            CHECK(violations == 0, "%s: %u samples outside the bounds of %g-wide boxes", kind_names[kind], violations, sizes[s]);
+            if (s == 0 && kind != CELLULAR_2D && kind != CELLULAR_3D) {
+                const double mean_width = total_width / BOXES;
+                CHECK(mean_width < 0.25, "%s: mean bounds width %g for %g-wide boxes", kind_names[kind], mean_width, sizes[s]);
+            }
+        }
+    }
+}
+
+static void test_gradient_range(void) {
+    // the scales keep the values inside [-1, 1], while still getting close to its ends
+    static const float min_reached[3] = { 0.95f, 0.9f, 0.7f };
+    float largest[3] = { 0.0f, 0.0f, 0.0f };
+    for (MCHR_INT i = 0; i < 1000000; ++i) {
+        const float x = random_float(i, 1, -1000.0f, 1000.0f), y = random_float(i, 2, -1000.0f, 1000.0f);
+        const float z = random_float(i, 3, -1000.0f, 1000.0f), w = random_float(i, 4, -1000.0f, 1000.0f);
+        const float values[3] = { mcn_gradient_noise_2d(x, y, 5), mcn_gradient_noise_3d(x, y, z, 5), mcn_gradient_noise_4d(x, y, z, w, 5) };
+        for (int d = 0; d < 3; ++d) {
+            const float value = fabsf(values[d]);
+            largest[d] = (value > largest[d]) ? value : largest[d];
+        }
+    }
+    for (int d = 0; d < 3; ++d) {
+        CHECK(largest[d] <= 1.0f, "gradient %dd: value %.9g outside [-1, 1]", d + 2, largest[d]);
+        CHECK(largest[d] >= min_reached[d], "gradient %dd: largest value only %g", d + 2, largest[d]);
+    }
+}
+
+static void test_curve_steps(void) {
+    // a step at x = 1, and a spike at x = 3 whose top is only reached from the left
+    static const float curve_x[6] = { 0.0f, 1.0f, 1.0f, 3.0f, 3.0f, 4.0f };
+    static const float curve_y[6] = { 0.0f, 0.0f, 1.0f, 5.0f, 1.0f, 1.0f };
+    mcn_graph_node_t nodes[4];
+    mcn_graph_t graph;
+    mcn_graph_init(&graph, nodes, 4);
+    const MCHR_UINT output = mcn_graph_curve(&graph, mcn_graph_x(&graph), curve_x, curve_y, 6);
+    CHECK(mcn_graph_compile(&graph, output), "curve: compile failed");
+
+    static const float xs[6] = { 0.5f, 1.0f, 1.5f, 2.0f, 3.0f, 3.5f };
+    static const float expected[6] = { 0.0f, 1.0f, 2.0f, 3.0f, 1.0f, 1.0f };
+    for (int i = 0; i < 6; ++i) {
+        const float value = mcn_graph_eval(&graph, xs[i], 0.0f, 0.0f, 0);
+        CHECK(fabsf(value - expected[i]) < 1e-5f, "curve: %g at %g, expected %g", value, xs[i], expected[i]);
+    }
+
+    static const float ranges[4][4] = {
+        // min x, max x, min, max
+        { 0.25f, 0.75f, 0.0f, 0.0f },
+        { 0.5f, 1.0f, 0.0f, 1.0f },
+        { 0.5f, 1.5f, 0.0f, 2.0f },
+        { 2.0f, 3.0f, 1.0f, 5.0f },
+    };
+    for (int i = 0; i < 4; ++i) {
+        float node_bounds[2 * 4], range[2];
+        mcn_graph_bounds_2d(&graph, ranges[i][0], 0.0f, ranges[i][1], 0.0f, 0, node_bounds, &range[0], &range[1]);
+        CHECK(range[0] <= ranges[i][2] && range[1] >= ranges[i][3], "curve: bounds [%g, %g] on [%g, %g] miss [%g, %g]",
+              range[0], range[1], ranges[i][0], ranges[i][1], ranges[i][2], ranges[i][3]);
+    }
+}
+
+int main(void) {
+    test_bounds();
+    test_curve_steps();
+    test_gradient_range();
+    if (failures == 0)
+        printf("all tests passed\n");
+    return failures != 0;
+}
@@ -0,0 +1,148 @@
+// test_mc_sampling.c - checks for mc_sampling.h
+//
+// Build and run from the repository root with
+//
+//      cc -std=c99 -O2 -I. tests/test_mc_sampling.c -o test_mc_sampling -lm && ./test_mc_sampling
+//
+// Returns 0 when every check passes, and prints the failures otherwise.
+
+#define MCHR_IMPLEMENTATION
+#define MCS_IMPLEMENTATION
+#include "mc_sampling.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int failures = 0;
+
+#define CHECK(condition, ...) \
+    do { if (!(condition)) { ++failures; printf("FAILED %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+// position `offset` after `first`, wrapping like the library does
+static MCHR_INT wrapped(MCHR_INT first, MCHR_UINT offset) {
+    return (MCHR_INT)((MCHR_UINT)first + offset);
+}
+
+// ---------------------------------------------------------------------------------------
+// Poisson-disk sampling: the points of a rectangle must be exactly the union of the points
+//  of any split of it into smaller rectangles, and no two of them can be closer than the
+//  radius, across the borders of the smaller rectangles too.
+// ---------------------------------------------------------------------------------------
+typedef struct point_t {
+    float x, y;
+} point_t;
+
+static int compare_points(const void* a, const void* b) {
+    const point_t* point_a = (const point_t*)a;
+    const point_t* point_b = (const point_t*)b;
+    if (point_a->x != point_b->x)
+        return (point_a->x < point_b->x) ? -1 : 1;
+    if (point_a->y != point_b->y)
+        return (point_a->y < point_b->y) ? -1 : 1;
+    return 0;
+}
+
+// appends the points of a rectangle
+static MCHR_UINT poisson_points(float min_x, float min_y, float max_x, float max_y, float radius, MCHR_UINT seed, point_t* out, MCHR_UINT count) {
+    const MCHR_UINT capacity = mcs_poisson_disk_2d_max_points(min_x, min_y, max_x, max_y, radius);
+    void* work = malloc(mcs_poisson_disk_2d_work_size(min_x, min_y, max_x, max_y, radius));
+    float* xs = (float*)malloc(capacity * sizeof(float));
+    float* ys = (float*)malloc(capacity * sizeof(float));
+    const MCHR_UINT found = mcs_poisson_disk_2d(min_x, min_y, max_x, max_y, radius, seed, work, xs, ys, capacity);
+    for (MCHR_UINT i = 0; i < found; ++i) {
+        out[count + i].x = xs[i];
+        out[count + i].y = ys[i];
+    }
+    free(work);
+    free(xs);
+    free(ys);
+    return count + found;
+}
+
+static void test_poisson_disk(void) {
+    // borders of the split, uneven and not aligned with the cells
+    static const float split_x[5] = { -10.0f, -3.3f, 0.0f, 17.25f, 30.0f };
+    static const float split_y[4] = { -5.0f, 1.1f, 12.7f, 25.0f };
+    static const float radii[2] = { 1.0f, 2.3f };
+    for (int r = 0; r < 2; ++r) {
+        const float radius = radii[r];
+        const MCHR_UINT capacity = mcs_poisson_disk_2d_max_points(split_x[0], split_y[0], split_x[4], split_y[3], radius);
+        MCHR_UINT parts_capacity = 0;
+        for (int j = 0; j < 3; ++j) {
+            for (int i = 0; i < 4; ++i) {
+                parts_capacity += mcs_poisson_disk_2d_max_points(split_x[i], split_y[j], split_x[i + 1], split_y[j + 1], radius);
+            }
+        }
+        point_t* whole = (point_t*)malloc(capacity * sizeof(point_t));
+        point_t* parts = (point_t*)malloc(parts_capacity * sizeof(point_t));
+        const MCHR_UINT whole_count = poisson_points(split_x[0], split_y[0], split_x[4], split_y[3], radius, 11, whole, 0);
+        MCHR_UINT parts_count = 0;
+        for (int j = 0; j < 3; ++j) {
+            for (int i = 0; i < 4; ++i) {
+                parts_count = poisson_points(split_x[i], split_y[j], split_x[i + 1], split_y[j + 1], radius, 11, parts, parts_count);
+            }
+        }
+
+        qsort(whole, whole_count, sizeof(point_t), compare_points);
+        qsort(parts, parts_count, sizeof(point_t), compare_points);
+        unsigned mismatches = 0;
+        for (MCHR_UINT i = 0; i < whole_count && i < parts_count; ++i) {
+            mismatches += (compare_points(&whole[i], &parts[i]) != 0);
+        }
+        CHECK(whole_count > 100, "poisson disk, radius %g: only %u points", radius, whole_count);
+        CHECK(whole_count == parts_count && mismatches == 0, "poisson disk, radius %g: %u points in the rectangle, %u in its parts, %u differ",
+              radius, whole_count, parts_count, mismatches);
+
+        unsigned too_close = 0;
+        for (MCHR_UINT i = 0; i < whole_count; ++i) {
+            for (MCHR_UINT k = i + 1; k < whole_count; ++k) {
+                const float dx = whole[i].x - whole[k].x, dy = whole[i].y - whole[k].y;
+                too_close += (dx * dx + dy * dy < radius * radius);
+            }
+        }
+        CHECK(too_close == 0, "poisson disk, radius %g: %u pairs of points closer than the radius", radius, too_close);
+        free(whole);
+        free(parts);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Wang and corner tiles: maps must give the same tiles as the single tile functions for
+//  every number of colours (their edge colours are picked in batches, reproducing the
+//  rejection order of mchr_get_2d_hash_uint_in_range), including maps wider than a chunk
+//  and maps crossing INT_MAX.
+// ---------------------------------------------------------------------------------------
+enum { TILES_WIDTH = 70, TILES_HEIGHT = 3 };
+
+static void test_tiles(void) {
+    static const MCHR_INT firsts[3][2] = { { 0, 0 }, { -35, -1 }, { INT_MAX - 35, INT_MAX - 1 } };
+    MCHR_UINT map[TILES_WIDTH * TILES_HEIGHT];
+    for (MCHR_UINT colors = 1; colors <= 256; ++colors) {
+        for (int f = 0; f < 3; ++f) {
+            const MCHR_INT first_x = firsts[f][0], first_y = firsts[f][1];
+            const MCHR_UINT seed = colors * 31u + (MCHR_UINT)f;
+            unsigned mismatches[2] = { 0, 0 };
+            mcs_wang_tile_2d_map(first_x, first_y, TILES_WIDTH, TILES_HEIGHT, colors, seed, map);
+            for (MCHR_UINT i = 0; i < TILES_WIDTH * TILES_HEIGHT; ++i) {
+                const MCHR_INT x = wrapped(first_x, i % TILES_WIDTH), y = wrapped(first_y, i / TILES_WIDTH);
+                mismatches[0] += (map[i] != mcs_wang_tile_2d(x, y, colors, seed));
+            }
+            mcs_corner_tile_2d_map(first_x, first_y, TILES_WIDTH, TILES_HEIGHT, colors, seed, map);
+            for (MCHR_UINT i = 0; i < TILES_WIDTH * TILES_HEIGHT; ++i) {
+                const MCHR_INT x = wrapped(first_x, i % TILES_WIDTH), y = wrapped(first_y, i / TILES_WIDTH);
+                mismatches[1] += (map[i] != mcs_corner_tile_2d(x, y, colors, seed));
+            }
+            CHECK(mismatches[0] == 0, "wang tiles, %u colours from (%d, %d): %u map tiles differ", colors, (int)first_x, (int)first_y, mismatches[0]);
+            CHECK(mismatches[1] == 0, "corner tiles, %u colours from (%d, %d): %u map tiles differ", colors, (int)first_x, (int)first_y, mismatches[1]);
+        }
+    }
+}
+
+int main(void) {
+    test_poisson_disk();
+    test_tiles();
+    if (failures == 0)
+        printf("all tests passed\n");
+    return failures != 0;
+}